@@ -126,6 +126,10 @@ struct Vec4S32 {
 	void Store2(int *dst) { _mm_storel_epi64((__m128i *)dst, v); }
 	void StoreAligned(int *dst) { _mm_store_si128((__m128i *)dst, v);}
 
+	// Sign extends 4 int16s, and the other way with saturation.
+	static Vec4S32 LoadS16(const int16_t *src) { __m128i x = _mm_loadl_epi64((const __m128i *)src); return Vec4S32{ _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16) }; }
+	void StoreS16Saturate(int16_t *dst) const { _mm_storel_epi64((__m128i *)dst, _mm_packs_epi32(v, v)); }
+
 	Vec4S32 SignBits32ToMask() {
 		return Vec4S32{
 			_mm_srai_epi32(v, 31)
@@ -166,6 +170,15 @@ struct Vec4S32 {
 
 	template<int imm>
 	Vec4S32 Shl() const { return Vec4S32{ imm == 0 ? v : _mm_slli_epi32(v, imm) }; }
+	// Arithmetic shift, keeps the sign.
+	template<int imm>
+	Vec4S32 Shr() const { return Vec4S32{ imm == 0 ? v : _mm_srai_epi32(v, imm) }; }
+
+	// lo = (a0, b0, a1, b1), hi = (a2, b2, a3, b3).
+	static void Interleave(Vec4S32 a, Vec4S32 b, Vec4S32 &lo, Vec4S32 &hi) {
+		lo.v = _mm_unpacklo_epi32(a.v, b.v);
+		hi.v = _mm_unpackhi_epi32(a.v, b.v);
+	}
 
 	// NOTE: May be slow.
 	int operator[](size_t index) const { return ((int *)&v)[index]; }
@@ -297,6 +310,7 @@ struct Vec4F32 {
 
 	Vec4F32 operator +(Vec4F32 other) const { return Vec4F32{ _mm_add_ps(v, other.v) }; }
 	Vec4F32 operator -(Vec4F32 other) const { return Vec4F32{ _mm_sub_ps(v, other.v) }; }
+	Vec4F32 operator -() const { return Vec4F32{ _mm_xor_ps(v, _mm_set1_ps(-0.0f)) }; }
 	Vec4F32 operator *(Vec4F32 other) const { return Vec4F32{ _mm_mul_ps(v, other.v) }; }
 	Vec4F32 operator &(Vec4S32 other) const { return Vec4F32{ _mm_and_ps(v, _mm_castsi128_ps(other.v))}; }
 	Vec4F32 operator |(Vec4S32 other) const { return Vec4F32{ _mm_or_ps(v, _mm_castsi128_ps(other.v))}; }
@@ -464,6 +478,9 @@ struct Vec8U16 {
 
 	static Vec8U16 Load(const uint16_t *mem) { return Vec8U16{ _mm_loadu_si128((__m128i *)mem) }; }
 	void Store(uint16_t *mem) { _mm_storeu_si128((__m128i *)mem, v); }
+
+	Vec8U16 operator +(Vec8U16 other) const { return Vec8U16{ _mm_add_epi16(v, other.v) }; }
+	void operator +=(Vec8U16 other) { v = _mm_add_epi16(v, other.v); }
 };
 
 inline Vec4U16 SignBits32ToMaskU16(Vec4S32 v) {
@@ -582,6 +599,10 @@ struct Vec4S32 {
 	void Store2(int *dst) { vst1_s32(dst, vget_low_s32(v)); }
 	void StoreAligned(int *dst) { vst1q_s32(dst, v); }
 
+	// Sign extends 4 int16s, and the other way with saturation.
+	static Vec4S32 LoadS16(const int16_t *src) { return Vec4S32{ vmovl_s16(vld1_s16(src)) }; }
+	void StoreS16Saturate(int16_t *dst) const { vst1_s16(dst, vqmovn_s32(v)); }
+
 	// Warning: Unlike on x86, this is a full 32-bit multiplication.
 	Vec4S32 Mul16(Vec4S32 other) const { return Vec4S32{ vmulq_s32(v, other.v) }; }
 
@@ -608,6 +629,16 @@ struct Vec4S32 {
 
 	template<int imm>
 	Vec4S32 Shl() const { return Vec4S32{ vshlq_n_s32(v, imm) }; }
+	// Arithmetic shift, keeps the sign.
+	template<int imm>
+	Vec4S32 Shr() const { return Vec4S32{ vshrq_n_s32(v, imm) }; }
+
+	// lo = (a0, b0, a1, b1), hi = (a2, b2, a3, b3).
+	static void Interleave(Vec4S32 a, Vec4S32 b, Vec4S32 &lo, Vec4S32 &hi) {
+		int32x4x2_t zipped = vzipq_s32(a.v, b.v);
+		lo.v = zipped.val[0];
+		hi.v = zipped.val[1];
+	}
 
 	void operator +=(Vec4S32 other) { v = vaddq_s32(v, other.v); }
 	void operator -=(Vec4S32 other) { v = vsubq_s32(v, other.v); }
@@ -697,6 +728,7 @@ struct Vec4F32 {
 
 	Vec4F32 operator +(Vec4F32 other) const { return Vec4F32{ vaddq_f32(v, other.v) }; }
 	Vec4F32 operator -(Vec4F32 other) const { return Vec4F32{ vsubq_f32(v, other.v) }; }
+	Vec4F32 operator -() const { return Vec4F32{ vnegq_f32(v) }; }
 	Vec4F32 operator *(Vec4F32 other) const { return Vec4F32{ vmulq_f32(v, other.v)}; }
 	Vec4F32 operator &(Vec4S32 other) const { return Vec4F32{ vreinterpretq_f32_s32(vandq_s32(vreinterpretq_s32_f32(v), other.v))}; }
 	Vec4F32 operator |(Vec4S32 other) const { return Vec4F32{ vreinterpretq_f32_s32(vorrq_s32(vreinterpretq_s32_f32(v), other.v))}; }
@@ -967,6 +999,9 @@ struct Vec8U16 {
 
 	static Vec8U16 Load(const uint16_t *mem) { return Vec8U16{ vld1q_u16(mem) }; }
 	void Store(uint16_t *mem) { vst1q_u16(mem, v); }
+
+	Vec8U16 operator +(Vec8U16 other) const { return Vec8U16{ vaddq_u16(v, other.v) }; }
+	void operator +=(Vec8U16 other) { v = vaddq_u16(v, other.v); }
 };
 
 
@@ -1085,6 +1120,10 @@ struct Vec4S32 {
 	void Store2(int *dst) { __lsx_vstelm_d(v, dst, 0, 0); }
 	void StoreAligned(int *dst) { __lsx_vst(v, dst, 0); }
 
+	// Sign extends 4 int16s, and the other way with saturation.
+	static Vec4S32 LoadS16(const int16_t *src) { return Vec4S32{ __lsx_vsllwil_w_h(__lsx_vldrepl_d(src, 0), 0) }; }
+	void StoreS16Saturate(int16_t *dst) const { __lsx_vstelm_d(__lsx_vssrani_h_w(v, v, 0), dst, 0, 0); }
+
 	// Warning: Unlike on x86, this is a full 32-bit multiplication.
 	Vec4S32 Mul16(Vec4S32 other) const { return Vec4S32{ __lsx_vmul_w(v, other.v) }; }
 
@@ -1111,6 +1150,15 @@ struct Vec4S32 {
 
 	template<int imm>
 	Vec4S32 Shl() const { return Vec4S32{ __lsx_vslli_w(v, imm) }; }
+	// Arithmetic shift, keeps the sign.
+	template<int imm>
+	Vec4S32 Shr() const { return Vec4S32{ __lsx_vsrai_w(v, imm) }; }
+
+	// lo = (a0, b0, a1, b1), hi = (a2, b2, a3, b3).
+	static void Interleave(Vec4S32 a, Vec4S32 b, Vec4S32 &lo, Vec4S32 &hi) {
+		lo.v = __lsx_vilvl_w(b.v, a.v);
+		hi.v = __lsx_vilvh_w(b.v, a.v);
+	}
 
 	void operator +=(Vec4S32 other) { v = __lsx_vadd_w(v, other.v); }
 	void operator -=(Vec4S32 other) { v = __lsx_vsub_w(v, other.v); }
@@ -1210,6 +1258,7 @@ struct Vec4F32 {
 
 	Vec4F32 operator +(Vec4F32 other) const { return Vec4F32{ (__m128)__lsx_vfadd_s(v, other.v) }; }
 	Vec4F32 operator -(Vec4F32 other) const { return Vec4F32{ (__m128)__lsx_vfsub_s(v, other.v) }; }
+	Vec4F32 operator -() const { return Vec4F32{ (__m128)__lsx_vbitrevi_w((__m128i)v, 31) }; }
 	Vec4F32 operator *(Vec4F32 other) const { return Vec4F32{ (__m128)__lsx_vfmul_s(v, other.v)}; }
 	Vec4F32 operator &(Vec4S32 other) const { return Vec4F32{ (__m128)__lsx_vand_v((__m128i)v, other.v)}; }
 	Vec4F32 operator |(Vec4S32 other) const { return Vec4F32{(__m128)__lsx_vor_v((__m128i)v, other.v)}; }
@@ -1463,6 +1512,9 @@ struct Vec8U16 {
 
 	static Vec8U16 Load(const uint16_t *mem) { return Vec8U16{ __lsx_vld(mem, 0) }; }
 	void Store(uint16_t *mem) { __lsx_vst(v, mem, 0); }
+
+	Vec8U16 operator +(Vec8U16 other) const { return Vec8U16{ __lsx_vadd_h(v, other.v) }; }
+	void operator +=(Vec8U16 other) { v = __lsx_vadd_h(v, other.v); }
 };
 
 #else
@@ -1525,6 +1577,14 @@ struct Vec4S32 {
 	void Store2(int *dst) { memcpy(dst, v, sizeof(v[0]) * 2); }
 	void StoreAligned(int *dst) { memcpy(dst, v, sizeof(v)); }
 
+	// Sign extends 4 int16s, and the other way with saturation.
+	static Vec4S32 LoadS16(const int16_t *src) { return Vec4S32{ { src[0], src[1], src[2], src[3] } }; }
+	void StoreS16Saturate(int16_t *dst) const {
+		for (int i = 0; i < 4; i++) {
+			dst[i] = (int16_t)(v[i] < -32768 ? -32768 : (v[i] > 32767 ? 32767 : v[i]));
+		}
+	}
+
 	// Warning: Unlike on x86 SSE2, this is a full 32-bit multiplication.
 	Vec4S32 Mul16(Vec4S32 other) const { return Vec4S32{ { v[0] * other.v[0], v[1] * other.v[1], v[2] * other.v[2], v[3] * other.v[3] } }; }
 
@@ -1586,6 +1646,15 @@ struct Vec4S32 {
 
 	template<int imm>
 	Vec4S32 Shl() const { return Vec4S32{ { v[0] << imm, v[1] << imm, v[2] << imm, v[3] << imm } }; }
+	// Arithmetic shift, keeps the sign.
+	template<int imm>
+	Vec4S32 Shr() const { return Vec4S32{ { v[0] >> imm, v[1] >> imm, v[2] >> imm, v[3] >> imm } }; }
+
+	// lo = (a0, b0, a1, b1), hi = (a2, b2, a3, b3).
+	static void Interleave(Vec4S32 a, Vec4S32 b, Vec4S32 &lo, Vec4S32 &hi) {
+		lo = Vec4S32{ { a.v[0], b.v[0], a.v[1], b.v[1] } };
+		hi = Vec4S32{ { a.v[2], b.v[2], a.v[3], b.v[3] } };
+	}
 
 	Vec4S32 CompareEq(Vec4S32 other) const {
 		Vec4S32 out;
@@ -1679,7 +1748,7 @@ struct Vec4F32 {
 	}
 
 	static Vec4F32 LoadF24x4(const uint32_t *src) {
-		return LoadR24x3_One(src);
+		return LoadF24x3_One(src);
 	}
 
 	static Vec4F32 FromVec4S32(Vec4S32 src) {
@@ -1714,6 +1783,9 @@ struct Vec4F32 {
 	Vec4F32 operator -(Vec4F32 other) const {
 		return Vec4F32{ { v[0] - other.v[0], v[1] - other.v[1], v[2] - other.v[2], v[3] - other.v[3], } };
 	}
+	Vec4F32 operator -() const {
+		return Vec4F32{ { -v[0], -v[1], -v[2], -v[3] } };
+	}
 	Vec4F32 operator *(Vec4F32 other) const {
 		return Vec4F32{ { v[0] * other.v[0], v[1] * other.v[1], v[2] * other.v[2], v[3] * other.v[3], } };
 	}
@@ -1979,6 +2051,14 @@ struct Vec8U16 {
 
 	static Vec8U16 Load(const uint16_t *mem) { Vec8U16 tmp; memcpy(tmp.v, mem, sizeof(v)); return tmp; }
 	void Store(uint16_t *mem) { memcpy(mem, v, sizeof(v)); }
+
+	Vec8U16 operator +(Vec8U16 other) const {
+		Vec8U16 tmp;
+		for (int i = 0; i < 8; i++)
+			tmp.v[i] = v[i] + other.v[i];
+		return tmp;
+	}
+	void operator +=(Vec8U16 other) { for (int i = 0; i < 8; i++) v[i] += other.v[i]; }
 };
 
 inline Vec4U16 SignBits32ToMaskU16(Vec4S32 v) {
@@ -15,8 +15,12 @@
 // Official SVN repository and contact information can be found at
 // http://code.google.com/p/dolphin-emu/
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <cstdlib>
 #include <cstring>
+#include <mutex>
 #include <snappy-c.h>
 #include <zstd.h>
 
@@ -24,6 +28,8 @@
 #include "Common/Serialize/SerializeFuncs.h"
 #include "Common/File/FileUtil.h"
 #include "Common/StringUtils.h"
+#include "Common/Thread/ParallelLoop.h"
+#include "Common/Thread/Promise.h"
 
 enum class SerializeCompressType {
 	NONE = 0,
@@ -33,6 +39,16 @@ enum class SerializeCompressType {
 
 static constexpr SerializeCompressType SAVE_TYPE = SerializeCompressType::ZSTD;
 
+// States are compressed as independent zstd frames of this size, in parallel. ZSTD_decompress
+// handles concatenated frames, so this doesn't change the file format.
+static constexpr size_t SAVE_FRAME_SIZE = 4 * 1024 * 1024;
+// How much compressed data we read at a time when streaming a state in.
+static constexpr size_t LOAD_READ_SIZE = 1024 * 1024;
+
+static std::mutex g_pendingSavesLock;
+static std::condition_variable g_pendingSavesCond;
+static int g_pendingSaves = 0;
+
 void PointerWrap::RewindForWrite(u8 *writePtr) {
 	_assert_(mode == MODE_MEASURE);
 	// Switch to writing mode, save the size for later checking and start again.
@@ -405,6 +421,30 @@ CChunkFileReader::Error CChunkFileReader::LoadFile(const Path &filename, std::st
 		return err;
 	}
 
+	if (SerializeCompressType(header.Compress) == SerializeCompressType::ZSTD) {
+		// Sanity cap on the decompressed size, see below.
+		if (header.UncompressedSize > 0x40000000) {
+			ERROR_LOG(Log::SaveState, "ChunkReader: UncompressedSize too large: %u", header.UncompressedSize);
+			return ERROR_BAD_FILE;
+		}
+		// Stream it in, so we don't need the whole compressed state in memory at the same time.
+		sz = header.UncompressedSize;
+		u8 *buffer = new u8[sz];
+		if (!DecompressZstdFile(pFile, header.ExpectedSize, buffer, sz)) {
+			ERROR_LOG(Log::SaveState, "ChunkReader: Failed to decompress file");
+			delete [] buffer;
+			return ERROR_BAD_FILE;
+		}
+		_buffer = buffer;
+
+		if (header.GitVersion[31]) {
+			*gitVersion = std::string(header.GitVersion, 32);
+		} else {
+			*gitVersion = header.GitVersion;
+		}
+		return ERROR_NONE;
+	}
+
 	// read the state
 	sz = header.ExpectedSize;
 	u8 *buffer = new u8[sz];
@@ -466,6 +506,125 @@ CChunkFileReader::Error CChunkFileReader::LoadFile(const Path &filename, std::st
 	return ERROR_NONE;
 }
 
+bool CChunkFileReader::DecompressZstdFile(File::IOFile &pFile, size_t compressedSize, u8 *buffer, size_t sz) {
+	ZSTD_DStream *stream = ZSTD_createDStream();
+	if (!stream)
+		return false;
+
+	std::vector<u8> readBuffer(std::min(compressedSize, LOAD_READ_SIZE));
+	ZSTD_outBuffer out{ buffer, sz, 0 };
+	size_t remaining = compressedSize;
+	size_t status = 0;
+	bool success = true;
+	while (remaining > 0) {
+		size_t chunk = std::min(remaining, readBuffer.size());
+		if (!pFile.ReadBytes(readBuffer.data(), chunk)) {
+			ERROR_LOG(Log::SaveState, "ChunkReader: Error reading file");
+			success = false;
+			break;
+		}
+		remaining -= chunk;
+
+		ZSTD_inBuffer in{ readBuffer.data(), chunk, 0 };
+		while (in.pos < in.size) {
+			status = ZSTD_decompressStream(stream, &out, &in);
+			if (ZSTD_isError(status) || (out.pos == out.size && in.pos < in.size && status != 0)) {
+				success = false;
+				break;
+			}
+		}
+		if (!success)
+			break;
+	}
+	ZSTD_freeDStream(stream);
+
+	// status is zero once the last frame is complete.
+	if (success && (status != 0 || out.pos != sz)) {
+		ERROR_LOG(Log::SaveState, "Size mismatch: file: %u  calc: %u", (u32)sz, (u32)out.pos);
+		success = false;
+	}
+	return success;
+}
+
+bool CChunkFileReader::CompressZstd(const u8 *buffer, size_t sz, u8 *&compressed, size_t &compressedSize) {
+	const int numFrames = std::max(1, (int)((sz + SAVE_FRAME_SIZE - 1) / SAVE_FRAME_SIZE));
+	auto frameSize = [&](int i) {
+		return std::min(SAVE_FRAME_SIZE, sz - i * SAVE_FRAME_SIZE);
+	};
+
+	// Each frame gets its own worst case space, we close the gaps afterward.
+	std::vector<size_t> offsets(numFrames + 1);
+	for (int i = 0; i < numFrames; ++i)
+		offsets[i + 1] = offsets[i] + ZSTD_compressBound(frameSize(i));
+	std::vector<size_t> sizes(numFrames);
+
+	compressed = (u8 *)malloc(offsets[numFrames]);
+	if (!compressed) {
+		ERROR_LOG(Log::SaveState, "ChunkReader: Unable to allocate compressed buffer");
+		return false;
+	}
+
+	std::atomic<bool> failed{};
+	ParallelRangeLoop(&g_threadManager, [&](int l, int h) {
+		ZSTD_CCtx *ctx = ZSTD_createCCtx();
+		if (!ctx) {
+			failed = true;
+			return;
+		}
+		// TODO: If free disk space is low, we could max this out to 22?
+		ZSTD_CCtx_setParameter(ctx, ZSTD_c_compressionLevel, ZSTD_CLEVEL_DEFAULT);
+		ZSTD_CCtx_setParameter(ctx, ZSTD_c_checksumFlag, 1);
+		for (int i = l; i < h; ++i) {
+			ZSTD_CCtx_reset(ctx, ZSTD_reset_session_only);
+			ZSTD_CCtx_setPledgedSrcSize(ctx, frameSize(i));
+			size_t result = ZSTD_compress2(ctx, compressed + offsets[i], offsets[i + 1] - offsets[i], buffer + i * SAVE_FRAME_SIZE, frameSize(i));
+			if (ZSTD_isError(result)) {
+				failed = true;
+				break;
+			}
+			sizes[i] = result;
+		}
+		ZSTD_freeCCtx(ctx);
+	}, 0, numFrames, 1);
+
+	if (failed) {
+		free(compressed);
+		compressed = nullptr;
+		return false;
+	}
+
+	compressedSize = sizes[0];
+	for (int i = 1; i < numFrames; ++i) {
+		memmove(compressed + compressedSize, compressed + offsets[i], sizes[i]);
+		compressedSize += sizes[i];
+	}
+	return true;
+}
+
+void CChunkFileReader::SaveFileAsync(const Path &filename, const std::string &title, const char *gitVersion, u8 *buffer, size_t sz, std::function<void(Error)> callback) {
+	{
+		std::lock_guard<std::mutex> guard(g_pendingSavesLock);
+		g_pendingSaves++;
+	}
+
+	g_threadManager.EnqueueTask(new IndependentTask(TaskType::IO_BLOCKING, TaskPriority::NORMAL,
+		[filename, title, version = std::string(gitVersion), buffer, sz, callback = std::move(callback)]() {
+		Error error = SaveFile(filename, title, version.c_str(), buffer, sz);
+		if (callback)
+			callback(error);
+
+		// Only after the callback, which may still be moving the file into place.
+		std::lock_guard<std::mutex> guard(g_pendingSavesLock);
+		g_pendingSaves--;
+		g_pendingSavesCond.notify_all();
+	}));
+}
+
+void CChunkFileReader::WaitForPendingSaves() {
+	std::unique_lock<std::mutex> guard(g_pendingSavesLock);
+	g_pendingSavesCond.wait(guard, [] { return g_pendingSaves == 0; });
+}
+
 // Takes ownership of buffer.
 CChunkFileReader::Error CChunkFileReader::SaveFile(const Path &filename, const std::string &title, const char *gitVersion, u8 *buffer, size_t sz) {
 	INFO_LOG(Log::SaveState, "ChunkReader: Writing %s", filename.c_str());
@@ -477,67 +636,49 @@ CChunkFileReader::Error CChunkFileReader::SaveFile(const Path &filename, const s
 		return ERROR_BAD_FILE;
 	}
 
-	// Make sure we can allocate a buffer to compress before compressing.
-	size_t write_len;
+	size_t write_len = sz;
+	u8 *write_buffer = buffer;
 	SerializeCompressType usedType = SAVE_TYPE;
 	switch (usedType) {
 	case SerializeCompressType::NONE:
-		write_len = 0;
 		break;
 	case SerializeCompressType::SNAPPY:
-		write_len = snappy_max_compressed_length(sz);
+		{
+			// Make sure we can allocate a buffer to compress before compressing.
+			size_t compressed_len = snappy_max_compressed_length(sz);
+			u8 *compressed_buffer = (u8 *)malloc(compressed_len);
+			if (!compressed_buffer) {
+				ERROR_LOG(Log::SaveState, "ChunkReader: Unable to allocate compressed buffer");
+				// We'll save uncompressed.  Better than not saving...
+				usedType = SerializeCompressType::NONE;
+			} else if (snappy_compress((const char *)buffer, sz, (char *)compressed_buffer, &compressed_len) == SNAPPY_OK) {
+				write_buffer = compressed_buffer;
+				write_len = compressed_len;
+			} else {
+				ERROR_LOG(Log::SaveState, "ChunkReader: Compression failed");
+				free(compressed_buffer);
+				// We can still save uncompressed.
+				usedType = SerializeCompressType::NONE;
+			}
+		}
 		break;
 	case SerializeCompressType::ZSTD:
-		write_len = ZSTD_compressBound(sz);
-		break;
-	}
-	u8 *compressed_buffer = write_len == 0 ? nullptr : (u8 *)malloc(write_len);
-	u8 *write_buffer = buffer;
-	if (!compressed_buffer) {
-		if (write_len != 0)
-			ERROR_LOG(Log::SaveState, "ChunkReader: Unable to allocate compressed buffer");
-		// We'll save uncompressed.  Better than not saving...
-		write_len = sz;
-		usedType = SerializeCompressType::NONE;
-	} else {
-		bool success = true;
-		switch (usedType) {
-		case SerializeCompressType::NONE:
-			_assert_(false);
-			break;
-		case SerializeCompressType::SNAPPY:
-			success = snappy_compress((const char *)buffer, sz, (char *)compressed_buffer, &write_len) == SNAPPY_OK;
-			break;
-		case SerializeCompressType::ZSTD:
-			{
-				auto ctx = ZSTD_createCCtx();
-				if (!ctx) {
-					success = false;
-				} else {
-					// TODO: If free disk space is low, we could max this out to 22?
-					ZSTD_CCtx_setParameter(ctx, ZSTD_c_compressionLevel, ZSTD_CLEVEL_DEFAULT);
-					ZSTD_CCtx_setParameter(ctx, ZSTD_c_checksumFlag, 1);
-					ZSTD_CCtx_setPledgedSrcSize(ctx, sz);
-					write_len = ZSTD_compress2(ctx, compressed_buffer, write_len, buffer, sz);
-					success = !ZSTD_isError(write_len);
-				}
-				ZSTD_freeCCtx(ctx);
+		{
+			u8 *compressed_buffer = nullptr;
+			size_t compressed_len = 0;
+			if (CompressZstd(buffer, sz, compressed_buffer, compressed_len)) {
+				write_buffer = compressed_buffer;
+				write_len = compressed_len;
+			} else {
+				ERROR_LOG(Log::SaveState, "ChunkReader: Compression failed");
+				// We can still save uncompressed.
+				usedType = SerializeCompressType::NONE;
 			}
-			break;
-		}
-
-		if (success) {
-			free(buffer);
-			write_buffer = compressed_buffer;
-		} else {
-			ERROR_LOG(Log::SaveState, "ChunkReader: Compression failed");
-			free(compressed_buffer);
-
-			// We can still save uncompressed.
-			write_len = sz;
-			usedType = SerializeCompressType::NONE;
 		}
+		break;
 	}
+	if (write_buffer != buffer)
+		free(buffer);
 
 	// Create header
 	SChunkHeader header{};
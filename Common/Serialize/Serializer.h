@@ -29,6 +29,7 @@
 // + Sections can be versioned for backwards/forwards compatibility
 // - Serialization code for anything complex has to be manually written.
 
+#include <functional>
 #include <string>
 #include <cstring>
 #include <vector>
@@ -110,6 +111,9 @@ class PointerWrap
 	u8 **ptr;
 	Mode mode;
 	Error error = ERROR_NONE;
+	// Allows large memory blocks to be saved as just the changes against a reference copy,
+	// which must then also be around when loading. See Memory::DoState.
+	bool incrementalMemory = false;
 
 	PointerWrap(u8 **ptr_, Mode mode_) : ptr(ptr_), ptrStart_(*ptr), mode(mode_) {
 		if (mode == MODE_MEASURE) {
@@ -264,10 +268,11 @@ class CChunkFileReader
 	// Duplicate of the above but takes and modifies a vector. Less invasive
 	// than modifying the rewind manager to keep things in something else than vectors.
 	template<class T>
-	static Error MeasureAndSavePtr(T &_class, std::vector<u8> *saved)
+	static Error MeasureAndSavePtr(T &_class, std::vector<u8> *saved, bool incrementalMemory = false)
 	{
 		u8 *ptr = nullptr;
 		PointerWrap p(&ptr, PointerWrap::MODE_MEASURE);
+		p.incrementalMemory = incrementalMemory;
 		_class.DoState(p);
 		_assert_(p.error == PointerWrap::ERROR_NONE);
 
@@ -319,6 +324,25 @@ class CChunkFileReader
 		return error;
 	}
 
+	// Snapshots the state into RAM on the calling thread, then compresses and writes it in the
+	// background. The callback is called on the writing thread once the file is done.
+	template<class T>
+	static Error SaveAsync(const Path &filename, const std::string &title, const char *gitVersion, T& _class, std::function<void(Error)> callback)
+	{
+		u8 *buffer = nullptr;
+		size_t sz = 0;
+		Error error = MeasureAndSavePtr(_class, &buffer, &sz);
+		if (error != ERROR_NONE)
+			return error;
+
+		// SaveFileAsync takes ownership of buffer (malloc/free)
+		SaveFileAsync(filename, title, gitVersion, buffer, sz, std::move(callback));
+		return ERROR_NONE;
+	}
+
+	// Blocks until every file queued by SaveAsync has been written.
+	static void WaitForPendingSaves();
+
 	template <class T>
 	static Error Verify(T& _class)
 	{
@@ -366,5 +390,8 @@ class CChunkFileReader
 
 	static Error LoadFile(const Path &filename, std::string *gitVersion, u8 *&buffer, size_t &sz, std::string *failureReason);
 	static Error SaveFile(const Path &filename, const std::string &title, const char *gitVersion, u8 *buffer, size_t sz);
+	static void SaveFileAsync(const Path &filename, const std::string &title, const char *gitVersion, u8 *buffer, size_t sz, std::function<void(Error)> callback);
+	static bool CompressZstd(const u8 *buffer, size_t sz, u8 *&compressed, size_t &compressedSize);
+	static bool DecompressZstdFile(File::IOFile &pFile, size_t compressedSize, u8 *buffer, size_t sz);
 	static Error LoadFileHeader(File::IOFile &pFile, SChunkHeader &header, std::string *title);
 };
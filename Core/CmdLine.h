@@ -107,6 +107,9 @@ struct CommandLineOptions {
 	// Headless options
 	std::optional<bool> compare;
 	std::optional<bool> bench;
+	// Headless: decode the given .at3 files (or directories of them) through the same AudioDecoder
+	// the Atrac code uses, print the speed in frames per second and exit. No emulation involved.
+	std::optional<bool> benchAtrac;
 	std::optional<bool> verbose;
 	std::optional<double> timeout;
 	std::optional<bool> printEqualLines;
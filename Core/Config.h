@@ -231,16 +231,21 @@ struct Config : public ConfigBlock {
 	bool bHideSlowWarnings;
 	bool bHideStateWarnings;
 	uint32_t uJitDisableFlags;
+	bool bIRDiskCache;  // Keeps optimized IR blocks on disk between sessions
+	bool bIRSuperblocks;  // Compiles hot IR blocks together with the blocks they jump to
+	bool bIRBackgroundCompile;  // Optimizes IR blocks on a worker thread
 
 	bool bDisableHTTPS;
 
 	bool bShrinkIfWindowSmall;
 	bool bSeparateSASThread;
+	bool bSasParallelMix;  // Mixes SAS voices on the thread pool
 	int iIOTimingMethod;
 	int iLockedCPUSpeed;
 	bool bAutoSaveSymbolMap;
 	bool bCompressSymbols;
 	bool bCacheFullIsoInRam;
+	bool bMapIsoFiles;  // mmap local ISOs instead of reading them
 	int iRemoteISOPort; // Also used for serving a local remote debugger.
 	std::string sLastRemoteISOServer;
 	int iLastRemoteISOPort;
@@ -294,8 +299,11 @@ struct Config : public ConfigBlock {
 
 	bool bSoftwareRendering;
 	bool bSoftwareRenderingJit;
+	bool bSoftwareRenderingJitCache;  // Precompiles the jit funcs the game used last session
 	bool bSoftwareDisableDithering;
 	bool bHardwareTransform;
+	bool bVertexDecodeCache;  // Reuses decoded vertices of unchanged static meshes
+	bool bTessellationCache;  // Reuses tessellated splines and beziers
 	bool bVendorBugChecksEnabled;
 
 	// Speedhacks (more will be moved here):
@@ -346,12 +354,15 @@ struct Config : public ConfigBlock {
 	int iTexScalingType; // 0 = xBRZ, 1 = Hybrid
 	bool bTexDeposterize;
 	bool bTexHardwareScaling;
+	bool bTexAsyncScaling;  // Nearest-scaled until the worker thread is done
+	bool bTexScalingDiskCache;  // Keep upscaled textures on disk, per game
 	int iFpsLimit1;
 	int iFpsLimit2;
 	int iAnalogFpsLimit;
 	int iMaxRecent;
 	int iCurrentStateSlot;
 	int iRewindSnapshotInterval;
+	int iRewindMemoryBudgetMB;  // For the older rewind states, the newest is kept in full
 	bool bUISound;
 	bool bEnableStateUndo;
 	bool bConfirmLoadState;
@@ -422,6 +433,7 @@ struct Config : public ConfigBlock {
 	std::string sAudioDevice;
 	bool bAutoSwitchAudioDevice;
 	bool bUseOldAtrac;
+	bool bAtracDecodeAhead;  // Decodes upcoming Atrac frames on a worker thread
 
 	// iOS only for now
 	bool bAudioMixWithOthers;
@@ -18,10 +18,14 @@
 
 #include "ppsspp_config.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include "Common/Log.h"
 #include "Common/File/FileUtil.h"
 #include "Common/File/DirListing.h"
 #include "Core/Util/DarwinFileSystemServices.h"
+#include "Core/Config.h"
 #include "Core/FileLoaders/LocalFileLoader.h"
 
 #if PPSSPP_PLATFORM(ANDROID)
@@ -35,6 +39,7 @@
 #endif
 #else
 #include <fcntl.h>
+#include <sys/mman.h>
 #endif
 
 #ifdef HAVE_LIBRETRO_VFS
@@ -54,6 +59,52 @@ void LocalFileLoader::DetectSizeFd() {
 	lseek(fd_, 0, SEEK_SET);
 #endif
 }
+
+// Readahead window for sequential reads from a mapped file, doubled on each sequential read.
+static const size_t MIN_READAHEAD = 128 * 1024;
+static const size_t MAX_READAHEAD = 4 * 1024 * 1024;
+
+void LocalFileLoader::MapFile() {
+#if PPSSPP_ARCH(64BIT) && !PPSSPP_PLATFORM(SWITCH)
+	if (!g_Config.bMapIsoFiles || filesize_ == 0)
+		return;
+
+	void *ptr = mmap(nullptr, (size_t)filesize_, PROT_READ, MAP_SHARED, fd_, 0);
+	if (ptr == MAP_FAILED) {
+		WARN_LOG(Log::FileSystem, "LocalFileLoader: Unable to map '%s', falling back to reads", filename_.c_str());
+		return;
+	}
+	mapped_ = (u8 *)ptr;
+	// Games mostly seek around, so don't let the kernel read ahead on its own. We prefetch for
+	// sequential reads (like video streaming) ourselves, see AdviseMapped.
+	madvise(mapped_, (size_t)filesize_, MADV_RANDOM);
+	INFO_LOG(Log::FileSystem, "LocalFileLoader: Mapped '%s' (%lld bytes)", filename_.c_str(), (long long)filesize_);
+#endif
+}
+
+void LocalFileLoader::AdviseMapped(s64 absolutePos, size_t bytes) {
+	std::lock_guard<std::mutex> guard(readLock_);
+	s64 end = absolutePos + (s64)bytes;
+	if (absolutePos != nextSequentialPos_) {
+		readaheadSize_ = MIN_READAHEAD;
+		readaheadEnd_ = end;
+		nextSequentialPos_ = end;
+		return;
+	}
+	nextSequentialPos_ = end;
+
+	readaheadSize_ = std::min(readaheadSize_ * 2, MAX_READAHEAD);
+	s64 start = std::max(end, readaheadEnd_);
+	s64 target = std::min(end + (s64)readaheadSize_, (s64)filesize_);
+	// Only ask again once we've used up a good part of the previous window.
+	if (target - start < (s64)readaheadSize_ / 2)
+		return;
+
+	static const s64 pageMask = 4095;
+	s64 alignedStart = start & ~pageMask;
+	madvise(mapped_ + alignedStart, (size_t)(target - alignedStart), MADV_WILLNEED);
+	readaheadEnd_ = target;
+}
 #endif
 
 LocalFileLoader::LocalFileLoader(const Path &filename)
@@ -79,6 +130,7 @@ LocalFileLoader::LocalFileLoader(const Path &filename)
 		}
 		fd_ = fd;
 		DetectSizeFd();
+		MapFile();
 		return;
 	}
 	// else, fall through to normal file loading (legacy build, old Android etc).
@@ -105,6 +157,7 @@ LocalFileLoader::LocalFileLoader(const Path &filename)
 		return;
 	}
 	DetectSizeFd();
+	MapFile();
 #elif !defined(_WIN32)
 	fd_ = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
 	if (fd_ == -1) {
@@ -113,6 +166,7 @@ LocalFileLoader::LocalFileLoader(const Path &filename)
 	}
 
 	DetectSizeFd();
+	MapFile();
 #else // _WIN32
 	const DWORD access = GENERIC_READ, share = FILE_SHARE_READ, mode = OPEN_EXISTING, flags = FILE_ATTRIBUTE_NORMAL;
 #if PPSSPP_PLATFORM(UWP)
@@ -137,6 +191,11 @@ LocalFileLoader::LocalFileLoader(const Path &filename)
 }
 
 LocalFileLoader::~LocalFileLoader() {
+#if !defined(_WIN32) && !defined(HAVE_LIBRETRO_VFS)
+	if (mapped_) {
+		munmap(mapped_, (size_t)filesize_);
+	}
+#endif
 #if defined(HAVE_LIBRETRO_VFS)
 	if (file_ != nullptr) {
 		fclose(file_);
@@ -185,6 +244,18 @@ size_t LocalFileLoader::ReadAt(s64 absolutePos, size_t bytes, size_t count, void
 		return 0;
 	}
 
+#if !defined(_WIN32) && !defined(HAVE_LIBRETRO_VFS)
+	if (mapped_) {
+		if (absolutePos < 0 || (u64)absolutePos >= filesize_) {
+			return 0;
+		}
+		size_t count_read = std::min(bytes * count, (size_t)(filesize_ - absolutePos)) / bytes;
+		AdviseMapped(absolutePos, count_read * bytes);
+		memcpy(data, mapped_ + absolutePos, count_read * bytes);
+		return count_read;
+	}
+#endif
+
 #if defined(HAVE_LIBRETRO_VFS)
 	std::lock_guard<std::mutex> guard(readLock_);
 	File::Fseek(file_, absolutePos, SEEK_SET);
@@ -232,3 +303,13 @@ size_t LocalFileLoader::ReadAt(s64 absolutePos, size_t bytes, size_t count, void
 	return result == TRUE ? (size_t)read / bytes : 0;
 #endif
 }
+
+const u8 *LocalFileLoader::GetPointer(s64 absolutePos, size_t bytes) {
+#if !defined(_WIN32) && !defined(HAVE_LIBRETRO_VFS)
+	if (mapped_ && absolutePos >= 0 && (u64)absolutePos + bytes <= filesize_) {
+		AdviseMapped(absolutePos, bytes);
+		return mapped_ + absolutePos;
+	}
+#endif
+	return nullptr;
+}
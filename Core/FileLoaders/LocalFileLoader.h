@@ -42,13 +42,22 @@ class LocalFileLoader : public FileLoader {
 		return filename_;
 	}
 	size_t ReadAt(s64 absolutePos, size_t bytes, size_t count, void *data, Flags flags = Flags::NONE) override;
+	const u8 *GetPointer(s64 absolutePos, size_t bytes) override;
 
 private:
 #ifdef HAVE_LIBRETRO_VFS
 	FILE *file_ = nullptr;
 #elif !defined(_WIN32)
 	void DetectSizeFd();
+	void MapFile();
+	void AdviseMapped(s64 absolutePos, size_t bytes);
 	int fd_ = -1;
+	// With MapIsoFiles, the whole file is mapped here and reads are just copies.
+	u8 *mapped_ = nullptr;
+	// Sequential reads grow a readahead window that we ask the kernel to prefetch.
+	s64 nextSequentialPos_ = -1;
+	s64 readaheadEnd_ = 0;
+	size_t readaheadSize_ = 0;
 #else
 	HANDLE handle_ = 0;
 #endif
@@ -28,6 +28,8 @@
 #include "Common/File/FileUtil.h"
 #include "Common/File/DirListing.h"
 #include "Common/StringUtils.h"
+#include "Common/Thread/Promise.h"
+#include "Common/Thread/ThreadManager.h"
 #include "Core/Loaders.h"
 #include "Core/FileSystems/BlockDevices.h"
 #include "Core/FileSystems/ISOFileSystem.h"
@@ -288,6 +290,157 @@ BlockDevice *ConstructBlockDevice(FileLoader *fileLoader, std::string *errorStri
 	return device;
 }
 
+// How far ahead we decompress once reads are sequential, and over how many tasks at most.
+static const u32 PREFETCH_WINDOW_BYTES = 512 * 1024;
+static const int PREFETCH_MAX_TASKS = 4;
+static const int SEQUENTIAL_READS_BEFORE_PREFETCH = 2;
+
+FramePrefetchCache::FramePrefetchCache(u32 frameSize, u32 numFrames, DecompressFunc decompress, bool parallel)
+	: frameSize_(frameSize), numFrames_(numFrames), decompress_(std::move(decompress)), parallel_(parallel) {
+	windowFrames_ = std::max(4U, PREFETCH_WINDOW_BYTES / frameSize);
+	// Room for the window, plus the frames being read and a few recent ones.
+	slots_.resize(windowFrames_ * 2 + 8);
+	frameToSlot_.reserve(slots_.size());
+}
+
+FramePrefetchCache::~FramePrefetchCache() {
+	std::unique_lock<std::mutex> guard(lock_);
+	cond_.wait(guard, [&] { return tasksRunning_ == 0; });
+}
+
+// Must be called with lock_ held. Returns -1 if every slot is busy.
+int FramePrefetchCache::AllocateSlot(u32 frame) {
+	int best = -1;
+	for (int i = 0; i < (int)slots_.size(); ++i) {
+		if (slots_[i].state == SlotState::PENDING)
+			continue;
+		if (best == -1 || slots_[i].lastUse < slots_[best].lastUse)
+			best = i;
+	}
+	if (best == -1)
+		return -1;
+
+	Slot &slot = slots_[best];
+	if (slot.state != SlotState::EMPTY)
+		frameToSlot_.erase(slot.frame);
+	slot.frame = frame;
+	slot.state = SlotState::PENDING;
+	slot.lastUse = ++useCounter_;
+	frameToSlot_[frame] = best;
+	return best;
+}
+
+// Called without the lock. Serializes the decompression if the format can't run it in parallel.
+bool FramePrefetchCache::DecompressFrame(u32 frame, u8 *out) {
+	if (parallel_)
+		return decompress_(frame, out);
+	std::lock_guard<std::mutex> guard(decompressLock_);
+	return decompress_(frame, out);
+}
+
+// Called without the lock. Nothing else touches a slot while it's pending.
+void FramePrefetchCache::Decompress(int slotIndex) {
+	Slot &slot = slots_[slotIndex];
+	slot.data.resize(frameSize_);
+	bool success = DecompressFrame(slot.frame, slot.data.data());
+
+	std::lock_guard<std::mutex> guard(lock_);
+	slot.state = success ? SlotState::READY : SlotState::FAILED;
+	cond_.notify_all();
+}
+
+// Must be called with lock_ held.
+void FramePrefetchCache::Schedule(u32 firstFrame, u32 lastFrame) {
+	std::vector<int> pending;
+	u32 frame = firstFrame;
+	for (; frame <= lastFrame && frame < numFrames_; ++frame) {
+		if (frameToSlot_.find(frame) != frameToSlot_.end())
+			continue;
+		int slot = AllocateSlot(frame);
+		if (slot == -1)
+			break;
+		pending.push_back(slot);
+	}
+	prefetchedUntil_ = std::max(prefetchedUntil_, frame);
+	if (pending.empty())
+		return;
+
+	// Contiguous batches, so each task makes mostly sequential file reads.
+	const int numTasks = parallel_ ? std::min((int)pending.size(), PREFETCH_MAX_TASKS) : 1;
+	for (int t = 0; t < numTasks; ++t) {
+		size_t begin = pending.size() * t / numTasks;
+		size_t end = pending.size() * (t + 1) / numTasks;
+		std::vector<int> batch(pending.begin() + begin, pending.begin() + end);
+		tasksRunning_++;
+		g_threadManager.EnqueueTask(new IndependentTask(TaskType::CPU_COMPUTE, TaskPriority::NORMAL, [this, batch = std::move(batch)]() {
+			for (int slot : batch)
+				Decompress(slot);
+			std::lock_guard<std::mutex> guard(lock_);
+			tasksRunning_--;
+			cond_.notify_all();
+		}));
+	}
+}
+
+void FramePrefetchCache::Prefetch(u32 firstFrame, u32 lastFrame) {
+	std::lock_guard<std::mutex> guard(lock_);
+	Schedule(firstFrame, lastFrame);
+}
+
+bool FramePrefetchCache::Read(u32 frame, u32 offset, u32 size, u8 *out) {
+	std::unique_lock<std::mutex> guard(lock_);
+
+	// Several reads from the same frame don't count, but skipping around resets.
+	if (frame == nextFrame_) {
+		sequentialCount_++;
+	} else if (frame + 1 != nextFrame_) {
+		sequentialCount_ = 0;
+		prefetchedUntil_ = 0;
+	}
+	nextFrame_ = frame + 1;
+	if (sequentialCount_ >= SEQUENTIAL_READS_BEFORE_PREFETCH && frame + windowFrames_ / 2 >= prefetchedUntil_) {
+		Schedule(std::max(frame + 1, prefetchedUntil_), frame + windowFrames_);
+	}
+
+	while (true) {
+		auto it = frameToSlot_.find(frame);
+		int slotIndex;
+		if (it == frameToSlot_.end()) {
+			slotIndex = AllocateSlot(frame);
+			if (slotIndex == -1) {
+				// Everything's in flight, just do it ourselves without caching.
+				guard.unlock();
+				std::vector<u8> temp(frameSize_);
+				bool success = DecompressFrame(frame, temp.data());
+				memcpy(out, temp.data() + offset, size);
+				return success;
+			}
+			guard.unlock();
+			Decompress(slotIndex);
+			guard.lock();
+		} else {
+			slotIndex = it->second;
+		}
+
+		Slot &slot = slots_[slotIndex];
+		cond_.wait(guard, [&] { return slot.state != SlotState::PENDING; });
+		// It might have been evicted and reused while we waited.
+		if (slot.frame != frame || slot.state == SlotState::EMPTY)
+			continue;
+
+		slot.lastUse = ++useCounter_;
+		if (slot.state == SlotState::FAILED) {
+			// Let the next read try again.
+			frameToSlot_.erase(frame);
+			slot.state = SlotState::EMPTY;
+			memset(out, 0, size);
+			return false;
+		}
+		memcpy(out, slot.data.data() + offset, size);
+		return true;
+	}
+}
+
 void BlockDevice::NotifyReadError() {
 	if (!reportedError_) {
 		auto err = GetI18NCategory(I18NCat::ERRORS);
@@ -313,6 +466,10 @@ bool FileBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached) {
 	return true;
 }
 
+const u8 *FileBlockDevice::GetBlockPointer(u32 minBlock, int count) {
+	return fileLoader_->GetPointer((u64)minBlock * (u64)GetBlockSize(), (size_t)count * GetBlockSize());
+}
+
 bool FileBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
 	size_t retval = fileLoader_->ReadAt((u64)minBlock * (u64)GetBlockSize(), 2048, count, outPtr);
 	if (retval != (size_t)count) {
@@ -572,9 +729,6 @@ CISOFileBlockDevice::CISOFileBlockDevice(FileLoader *fileLoader)
 	readBufferSize = frameSize + (1u << indexShift);
 	if (readBufferSize < CSO_READ_BUFFER_SIZE)
 		readBufferSize = CSO_READ_BUFFER_SIZE;
-	readBuffer = new u8[readBufferSize];
-	zlibBuffer = new u8[frameSize + (1u << indexShift)];
-	zlibBufferFrame = numFrames;
 
 	const u32 indexSize = numFrames + 1;
 	const size_t headerEnd = hdr.ver > 1 ? (size_t)hdr.header_size : sizeof(hdr);
@@ -621,37 +775,33 @@ CISOFileBlockDevice::CISOFileBlockDevice(FileLoader *fileLoader)
 		}
 	}
 
+	cache_.reset(new FramePrefetchCache(frameSize, numFrames, [this](u32 frame, u8 *out) {
+		return DecompressFrame(frame, out, false);
+	}, true));
+
 	// all ok.
 	_dbg_assert_(errorString_.empty());
 }
 
 CISOFileBlockDevice::~CISOFileBlockDevice()
 {
+	// Stop any prefetches first, they use the index.
+	cache_.reset();
 	delete [] index;
-	delete [] readBuffer;
-	delete [] zlibBuffer;
 }
 
-bool CISOFileBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached)
-{
+// Decompresses a whole frame. Called from worker threads too, so doesn't touch any shared state.
+bool CISOFileBlockDevice::DecompressFrame(u32 frameNumber, u8 *out, bool uncached) {
 	FileLoader::Flags flags = uncached ? FileLoader::Flags::HINT_UNCACHED : FileLoader::Flags::NONE;
-	if ((u32)blockNumber >= numBlocks) {
-		memset(outPtr, 0, GetBlockSize());
-		return false;
-	}
-
-	const u32 frameNumber = blockNumber >> blockShift;
 	const u32 idx = index[frameNumber];
 	const u32 indexPos = idx & 0x7FFFFFFF;
 	const u32 nextIndexPos = index[frameNumber + 1] & 0x7FFFFFFF;
-	z_stream z{};
 
 	const u64 compressedReadPos = (u64)indexPos << indexShift;
 	const u64 compressedReadEnd = (u64)nextIndexPos << indexShift;
-	// A single frame's compressed data must fit in readBuffer.  Guard against
+	// A single frame's compressed data must fit in readBufferSize.  Guard against
 	// crafted index entries with huge gaps (index[i+1] >> index[i]).
 	const size_t compressedReadSize = std::min<size_t>((size_t)(compressedReadEnd - compressedReadPos), readBufferSize);
-	const u32 compressedOffset = (blockNumber & ((1 << blockShift) - 1)) * GetBlockSize();
 
 	bool plain = (idx & 0x80000000) != 0;
 	if (ver_ >= 2) {
@@ -659,51 +809,64 @@ bool CISOFileBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached)
 		plain = compressedReadSize >= frameSize;
 	}
 	if (plain) {
-		int readSize = (u32)fileLoader_->ReadAt(compressedReadPos + compressedOffset, 1, GetBlockSize(), outPtr, flags);
-		if (readSize < GetBlockSize())
-			memset(outPtr + readSize, 0, GetBlockSize() - readSize);
-	} else if (zlibBufferFrame == frameNumber) {
-		// We already have it.  Just apply the offset and copy.
-		memcpy(outPtr, zlibBuffer + compressedOffset, GetBlockSize());
-	} else {
-		const u32 readSize = (u32)fileLoader_->ReadAt(compressedReadPos, 1, compressedReadSize, readBuffer, flags);
+		size_t readSize = fileLoader_->ReadAt(compressedReadPos, 1, frameSize, out, flags);
+		if (readSize < frameSize)
+			memset(out + readSize, 0, frameSize - readSize);
+		return true;
+	}
 
-		z.zalloc = Z_NULL;
-		z.zfree = Z_NULL;
-		z.opaque = Z_NULL;
-		if (inflateInit2(&z, -15) != Z_OK) {
-			ERROR_LOG(Log::Loader, "GetBlockSize() ERROR: %s\n", (z.msg) ? z.msg : "?");
-			NotifyReadError();
-			return false;
-		}
-		z.avail_in = readSize;
-		z.next_out = frameSize == (u32)GetBlockSize() ? outPtr : zlibBuffer;
-		z.avail_out = frameSize;
-		z.next_in = readBuffer;
-
-		int status = inflate(&z, Z_FINISH);
-		if (status != Z_STREAM_END) {
-			ERROR_LOG(Log::Loader, "block %d: inflate : %s[%d]\n", blockNumber, (z.msg) ? z.msg : "error", status);
-			NotifyReadError();
-			inflateEnd(&z);
-			memset(outPtr, 0, GetBlockSize());
-			return false;
-		}
-		if (z.total_out != frameSize) {
-			ERROR_LOG(Log::Loader, "block %d: block size error %d != %d\n", blockNumber, (u32)z.total_out, frameSize);
-			NotifyReadError();
-			inflateEnd(&z);
-			memset(outPtr, 0, GetBlockSize());
-			return false;
-		}
-		inflateEnd(&z);
+	std::vector<u8> readBuffer(compressedReadSize);
+	const u32 readSize = (u32)fileLoader_->ReadAt(compressedReadPos, 1, compressedReadSize, readBuffer.data(), flags);
 
-		if (frameSize != (u32)GetBlockSize()) {
-			zlibBufferFrame = frameNumber;
-			memcpy(outPtr, zlibBuffer + compressedOffset, GetBlockSize());
-		}
+	z_stream z{};
+	if (inflateInit2(&z, -15) != Z_OK) {
+		ERROR_LOG(Log::Loader, "Unable to initialize inflate: %s\n", (z.msg) ? z.msg : "?");
+		NotifyReadError();
+		memset(out, 0, frameSize);
+		return false;
 	}
-	return true;
+	z.avail_in = readSize;
+	z.next_out = out;
+	z.avail_out = frameSize;
+	z.next_in = readBuffer.data();
+
+	int status = inflate(&z, Z_FINISH);
+	bool success = true;
+	if (status != Z_STREAM_END) {
+		ERROR_LOG(Log::Loader, "Inflate frame %d: failed - %s[%d]\n", frameNumber, (z.msg) ? z.msg : "error", status);
+		success = false;
+	} else if (z.total_out != frameSize) {
+		ERROR_LOG(Log::Loader, "Inflate frame %d: block size error %d != %d\n", frameNumber, (u32)z.total_out, frameSize);
+		success = false;
+	}
+	inflateEnd(&z);
+
+	if (!success) {
+		NotifyReadError();
+		memset(out, 0, frameSize);
+	}
+	return success;
+}
+
+bool CISOFileBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached)
+{
+	if ((u32)blockNumber >= numBlocks) {
+		memset(outPtr, 0, GetBlockSize());
+		return false;
+	}
+
+	const u32 frameNumber = blockNumber >> blockShift;
+	const u32 compressedOffset = (blockNumber & ((1 << blockShift) - 1)) * GetBlockSize();
+	if (uncached) {
+		// Don't push out frames that will be used again, this is probably a scan of the whole image.
+		if (frameSize == (u32)GetBlockSize())
+			return DecompressFrame(frameNumber, outPtr, true);
+		std::vector<u8> frame(frameSize);
+		bool success = DecompressFrame(frameNumber, frame.data(), true);
+		memcpy(outPtr, frame.data() + compressedOffset, GetBlockSize());
+		return success;
+	}
+	return cache_->Read(frameNumber, compressedOffset, GetBlockSize(), outPtr);
 }
 
 bool CISOFileBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
@@ -723,83 +886,22 @@ bool CISOFileBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
 
 	const u32 minFrameNumber = minBlock >> blockShift;
 	const u32 lastFrameNumber = lastBlock >> blockShift;
-	const u32 afterLastIndexPos = index[lastFrameNumber + 1] & 0x7FFFFFFF;
-	const u64 totalReadEnd = (u64)afterLastIndexPos << indexShift;
+	// Let the workers get going on the rest while we take the first frame.
+	if (lastFrameNumber > minFrameNumber)
+		cache_->Prefetch(minFrameNumber + 1, lastFrameNumber);
 
-	z_stream z{};
-	if (inflateInit2(&z, -15) != Z_OK) {
-		ERROR_LOG(Log::Loader, "Unable to initialize inflate: %s\n", (z.msg) ? z.msg : "?");
-		return false;
-	}
-
-	u64 readBufferStart = 0;
-	u64 readBufferEnd = 0;
+	bool success = true;
 	u32 block = minBlock;
 	const u32 blocksPerFrame = 1 << blockShift;
 	for (u32 frame = minFrameNumber; frame <= lastFrameNumber; ++frame) {
-		const u32 idx = index[frame];
-		const u32 indexPos = idx & 0x7FFFFFFF;
-		const u32 nextIndexPos = index[frame + 1] & 0x7FFFFFFF;
-
-		const u64 frameReadPos = (u64)indexPos << indexShift;
-		const u64 frameReadEnd = (u64)nextIndexPos << indexShift;
-		// A single frame's compressed data must fit in readBuffer.
-		const u32 frameReadSize = (u32)std::min<size_t>((size_t)(frameReadEnd - frameReadPos), readBufferSize);
-		const u32 frameBlockOffset = block & ((1 << blockShift) - 1);
+		const u32 frameBlockOffset = block & (blocksPerFrame - 1);
 		const u32 frameBlocks = std::min(lastBlock - block + 1, blocksPerFrame - frameBlockOffset);
-
-		if (frameReadEnd > readBufferEnd) {
-			const s64 maxNeeded = totalReadEnd - frameReadPos;
-			const size_t chunkSize = (size_t)std::min<s64>(std::min(maxNeeded, (s64)std::max(frameReadSize, CSO_READ_BUFFER_SIZE)), (s64)readBufferSize);
-
-			const u32 readSize = (u32)fileLoader_->ReadAt(frameReadPos, 1, chunkSize, readBuffer);
-			if (readSize < chunkSize) {
-				memset(readBuffer + readSize, 0, chunkSize - readSize);
-			}
-
-			readBufferStart = frameReadPos;
-			readBufferEnd = frameReadPos + readSize;
-		}
-
-		u8 *rawBuffer = &readBuffer[frameReadPos - readBufferStart];
-		bool plain = (idx & 0x80000000) != 0;
-		if (ver_ >= 2) {
-			// CSO v2+ requires blocks be uncompressed if large enough to be.  High bit means other things.
-			plain = frameReadSize >= frameSize;
-		}
-
-		if (plain) {
-			memcpy(outPtr, rawBuffer + frameBlockOffset * GetBlockSize(), frameBlocks * GetBlockSize());
-		} else {
-			z.avail_in = frameReadSize;
-			z.next_out = frameBlocks == blocksPerFrame ? outPtr : zlibBuffer;
-			z.avail_out = frameSize;
-			z.next_in = rawBuffer;
-
-			int status = inflate(&z, Z_FINISH);
-			if (status != Z_STREAM_END) {
-				ERROR_LOG(Log::Loader, "Inflate frame %d: failed - %s[%d]\n", frame, (z.msg) ? z.msg : "error", status);
-				NotifyReadError();
-				memset(outPtr, 0, frameBlocks * GetBlockSize());
-			} else if (z.total_out != frameSize) {
-				ERROR_LOG(Log::Loader, "Inflate frame %d: block size error %d != %d\n", frame, (u32)z.total_out, frameSize);
-				NotifyReadError();
-				memset(outPtr, 0, frameBlocks * GetBlockSize());
-			} else if (frameBlocks != blocksPerFrame) {
-				memcpy(outPtr, zlibBuffer + frameBlockOffset * GetBlockSize(), frameBlocks * GetBlockSize());
-				// In case we end up reusing it in a single read later.
-				zlibBufferFrame = frame;
-			}
-
-			inflateReset(&z);
-		}
-
+		if (!cache_->Read(frame, frameBlockOffset * GetBlockSize(), frameBlocks * GetBlockSize(), outPtr))
+			success = false;
 		block += frameBlocks;
 		outPtr += frameBlocks * GetBlockSize();
 	}
-
-	inflateEnd(&z);
-	return true;
+	return success;
 }
 
 NPDRMDemoBlockDevice::NPDRMDemoBlockDevice(FileLoader *fileLoader)
@@ -1136,18 +1238,28 @@ CHDFileBlockDevice::CHDFileBlockDevice(FileLoader *fileLoader)
 	impl_->chd = file;
 	impl_->header = chd_get_header(impl_->chd);
 
-	readBuffer = new u8[impl_->header->hunkbytes];
-	currentHunk = -1;
 	blocksPerHunk = impl_->header->hunkbytes / impl_->header->unitbytes;
 	numBlocks = impl_->header->unitcount;
 
+	// libchdr isn't thread safe, so hunks are decompressed one at a time, but still ahead of reads.
+	cache_.reset(new FramePrefetchCache(impl_->header->hunkbytes, impl_->header->hunkcount, [this](u32 hunk, u8 *out) {
+		chd_error err = chd_read(impl_->chd, hunk, out);
+		if (err != CHDERR_NONE) {
+			ERROR_LOG(Log::Loader, "CHD read failed: hunk %d %s", hunk, chd_error_string(err));
+			NotifyReadError();
+			return false;
+		}
+		return true;
+	}, false));
+
 	_dbg_assert_(errorString_.empty());
 }
 
 CHDFileBlockDevice::~CHDFileBlockDevice() {
+	// Stop any prefetches before closing.
+	cache_.reset();
 	if (impl_->chd) {
 		chd_close(impl_->chd);
-		delete[] readBuffer;
 	}
 }
 
@@ -1162,17 +1274,7 @@ bool CHDFileBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached) {
 	}
 	u32 hunk = blockNumber / blocksPerHunk;
 	u32 blockInHunk = blockNumber % blocksPerHunk;
-
-	if (currentHunk != hunk) {
-		chd_error err = chd_read(impl_->chd, hunk, readBuffer);
-		if (err != CHDERR_NONE) {
-			ERROR_LOG(Log::Loader, "CHD read failed: %d %d %s", blockNumber, hunk, chd_error_string(err));
-			NotifyReadError();
-		}
-		currentHunk = hunk;
-	}
-	memcpy(outPtr, readBuffer + blockInHunk * impl_->header->unitbytes, GetBlockSize());
-	return true;
+	return cache_->Read(hunk, blockInHunk * impl_->header->unitbytes, GetBlockSize(), outPtr);
 }
 
 bool CHDFileBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
@@ -1181,6 +1283,10 @@ bool CHDFileBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
 		return false;
 	}
 
+	const u32 lastBlock = std::min(minBlock + count, numBlocks) - 1;
+	if (lastBlock / blocksPerHunk > minBlock / blocksPerHunk)
+		cache_->Prefetch(minBlock / blocksPerHunk + 1, lastBlock / blocksPerHunk);
+
 	for (int i = 0; i < count; i++) {
 		if (!ReadBlock(minBlock + i, outPtr + i * GetBlockSize())) {
 			return false;
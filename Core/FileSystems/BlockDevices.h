@@ -23,8 +23,12 @@
 // The ISOFileSystemReader reads from a BlockDevice, so it automatically works
 // with CISO images.
 
+#include <condition_variable>
+#include <functional>
 #include <mutex>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 
@@ -46,6 +50,11 @@ class BlockDevice {
 		}
 		return true;
 	}
+	// Points straight at the data for count blocks if the device can do that without copying,
+	// like a plain ISO that's mapped into memory. Otherwise nullptr, then use ReadBlocks.
+	virtual const u8 *GetBlockPointer(u32 minBlock, int count) {
+		return nullptr;
+	}
 	int constexpr GetBlockSize() const { return 2048;}  // forced, it cannot be changed by subclasses. If a subclass uses bigger blocks internally, it must cache and virtualize.
 	virtual u32 GetNumBlocks() const = 0;
 	virtual u64 GetUncompressedSize() const {
@@ -65,6 +74,64 @@ class BlockDevice {
 	std::string errorString_;
 };
 
+// Decompressed frames of a compressed image (CSO frames, CHD hunks), shared between reads.
+// Once reads look sequential, the frames ahead are decompressed on the thread pool, so streaming
+// reads find them ready instead of inflating on the IO thread.
+class FramePrefetchCache {
+public:
+	// Must be safe to call from several threads at once if parallel is set, otherwise calls are
+	// serialized, but may still happen on a worker thread.
+	typedef std::function<bool(u32 frame, u8 *out)> DecompressFunc;
+
+	FramePrefetchCache(u32 frameSize, u32 numFrames, DecompressFunc decompress, bool parallel);
+	// Waits for any prefetches still running.
+	~FramePrefetchCache();
+
+	// Copies size bytes at offset within the frame to out, decompressing it here if needed.
+	bool Read(u32 frame, u32 offset, u32 size, u8 *out);
+	// Starts decompressing a range of frames we know will be read soon.
+	void Prefetch(u32 firstFrame, u32 lastFrame);
+
+private:
+	enum class SlotState {
+		EMPTY,
+		PENDING,
+		READY,
+		FAILED,
+	};
+
+	struct Slot {
+		u32 frame = 0;
+		SlotState state = SlotState::EMPTY;
+		u64 lastUse = 0;
+		std::vector<u8> data;
+	};
+
+	int AllocateSlot(u32 frame);
+	void Schedule(u32 firstFrame, u32 lastFrame);
+	void Decompress(int slot);
+	bool DecompressFrame(u32 frame, u8 *out);
+
+	const u32 frameSize_;
+	const u32 numFrames_;
+	DecompressFunc decompress_;
+	const bool parallel_;
+	u32 windowFrames_;
+
+	std::mutex lock_;
+	std::condition_variable cond_;
+	std::vector<Slot> slots_;
+	std::unordered_map<u32, int> frameToSlot_;
+	u64 useCounter_ = 0;
+	int tasksRunning_ = 0;
+	// For detecting sequential reads.
+	u32 nextFrame_ = 0;
+	int sequentialCount_ = 0;
+	u32 prefetchedUntil_ = 0;
+	// Only used when not parallel.
+	std::mutex decompressLock_;
+};
+
 class CISOFileBlockDevice : public BlockDevice {
 public:
 	CISOFileBlockDevice(FileLoader *fileLoader);
@@ -75,11 +142,11 @@ class CISOFileBlockDevice : public BlockDevice {
 	bool IsDisc() const override { return true; }
 
 private:
+	bool DecompressFrame(u32 frameNumber, u8 *out, bool uncached);
+
 	u32 *index = nullptr;
-	u8 *readBuffer = nullptr;
 	size_t readBufferSize = 0;
-	u8 *zlibBuffer = nullptr;
-	u32 zlibBufferFrame = 0;
+	std::unique_ptr<FramePrefetchCache> cache_;
 	u8 indexShift = 0;
 	u8 blockShift = 0;
 	u32 frameSize = 0;
@@ -94,6 +161,7 @@ class FileBlockDevice : public BlockDevice {
 	~FileBlockDevice();
 	bool ReadBlock(int blockNumber, u8 *outPtr, bool uncached = false) override;
 	bool ReadBlocks(u32 minBlock, int count, u8 *outPtr) override;
+	const u8 *GetBlockPointer(u32 minBlock, int count) override;
 	u32 GetNumBlocks() const override {return (u32)(filesize_ / GetBlockSize());}
 	bool IsDisc() const override { return true; }
 	u64 GetUncompressedSize() const override {
@@ -209,8 +277,7 @@ class CHDFileBlockDevice : public BlockDevice {
 private:
 	struct ExtendedCoreFile *core_file_ = nullptr;
 	std::unique_ptr<CHDImpl> impl_;
-	u8 *readBuffer = nullptr;
-	u32 currentHunk = 0;
+	std::unique_ptr<FramePrefetchCache> cache_;
 	u32 blocksPerHunk = 0;
 	u32 numBlocks = 0;
 };
@@ -199,8 +199,12 @@ std::string ISOFileSystem::TreeEntry::BuildPath() {
 
 void ISOFileSystem::ReadDirectory(TreeEntry *root) const {
 	for (u32 secnum = root->startsector, endsector = root->startsector + (root->dirsize + 2047) / 2048; secnum < endsector; ++secnum) {
-		u8 theSector[2048];
-		if (!blockDevice->ReadBlock(secnum, theSector)) {
+		u8 sectorBuffer[2048];
+		const u8 *theSector = blockDevice->GetBlockPointer(secnum, 1);
+		if (!theSector && blockDevice->ReadBlock(secnum, sectorBuffer)) {
+			theSector = sectorBuffer;
+		}
+		if (!theSector) {
 			blockDevice->NotifyReadError();
 			ERROR_LOG(Log::FileSystem, "Error reading block for directory '%s' in sector %d - skipping", root->name.c_str(), secnum);
 			root->valid = true;  // Prevents re-reading
@@ -209,7 +213,7 @@ void ISOFileSystem::ReadDirectory(TreeEntry *root) const {
 		lastReadBlock_ = secnum;  // Hm, this could affect timing... but lazy loading is probably more realistic.
 
 		for (int offset = 0; offset < 2048; ) {
-			DirectoryEntry &dir = *(DirectoryEntry *)&theSector[offset];
+			const DirectoryEntry &dir = *(const DirectoryEntry *)&theSector[offset];
 			u8 sz = theSector[offset];
 
 			// Nothing left in this sector.  There might be more in the next one.
@@ -565,21 +569,29 @@ size_t ISOFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size, int &usec) {
 		}
 
 		const u8 *const start = pointer;
-		if (firstBlockSize > 0) {
-			blockDevice->ReadBlock(secNum++, theSector);
-			memcpy(pointer, theSector + firstBlockOffset, firstBlockSize);
-			pointer += firstBlockSize;
-		}
-		if (middleSize > 0) {
-			const u32 middleSectors = (u32)(middleSize / 2048);
-			blockDevice->ReadBlocks(secNum, middleSectors, pointer);
-			secNum += middleSectors;
-			pointer += middleSize;
-		}
-		if (lastBlockSize > 0) {
-			blockDevice->ReadBlock(secNum++, theSector);
-			memcpy(pointer, theSector, lastBlockSize);
-			pointer += lastBlockSize;
+		const u8 *direct = size > 0 ? blockDevice->GetBlockPointer((u32)(positionOnIso / 2048), (int)((firstBlockOffset + size + 2047) / 2048)) : nullptr;
+		if (direct) {
+			// The whole range is directly accessible, just one copy straight into the destination.
+			memcpy(pointer, direct + firstBlockOffset, (size_t)size);
+			pointer += size;
+			secNum = (u32)((positionOnIso + size + 2047) / 2048);
+		} else {
+			if (firstBlockSize > 0) {
+				blockDevice->ReadBlock(secNum++, theSector);
+				memcpy(pointer, theSector + firstBlockOffset, firstBlockSize);
+				pointer += firstBlockSize;
+			}
+			if (middleSize > 0) {
+				const u32 middleSectors = (u32)(middleSize / 2048);
+				blockDevice->ReadBlocks(secNum, middleSectors, pointer);
+				secNum += middleSectors;
+				pointer += middleSize;
+			}
+			if (lastBlockSize > 0) {
+				blockDevice->ReadBlock(secNum++, theSector);
+				memcpy(pointer, theSector, lastBlockSize);
+				pointer += lastBlockSize;
+			}
 		}
 
 		size_t totalBytes = pointer - start;
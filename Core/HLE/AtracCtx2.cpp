@@ -1,8 +1,11 @@
 #include <algorithm>
+#include <cstring>
 
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
 #include "Common/Log.h"
+#include "Common/Thread/Promise.h"
+#include "Common/Thread/ThreadManager.h"
 #include "Core/MemMapHelpers.h"
 #include "Core/HLE/HLE.h"
 #include "Core/HLE/ErrorCodes.h"
@@ -29,6 +32,9 @@
 // cmd1> C:\dev\ppsspp\pspautotests\tests\audio\atrac>copy /Y ..\..\..\__testoutput.txt stream.expected
 // Then run the test, see above.
 
+// How many frames to decode ahead, with the AtracDecodeAhead setting.
+static const int ATRAC_DECODE_AHEAD_FRAMES = 4;
+
 struct AT3BitrateMeta {
 	u16 sampleSize;
 	u8 dataByte;
@@ -316,6 +322,7 @@ Atrac2::Atrac2(u32 contextAddr, int codecType) {
 }
 
 Atrac2::~Atrac2() {
+	StopDecodeAhead();
 	DumpBufferToFile();
 	delete[] decodeTemp_;
 	// Nothing else to do here, the context is freed by the HLE.
@@ -360,8 +367,10 @@ void Atrac2::DoState(PointerWrap &p) {
 	}
 
 	const SceAtracIdInfo &info = context_->info;
-	if (p.mode == p.MODE_READ && info.state != ATRAC_STATUS_NO_DATA) {
-		CreateDecoder(info.codec, info.sampleSize, info.numChan);
+	if (p.mode == p.MODE_READ) {
+		StopDecodeAhead();
+		if (info.state != ATRAC_STATUS_NO_DATA)
+			CreateDecoder(info.codec, info.sampleSize, info.numChan);
 	}
 }
 
@@ -399,6 +408,7 @@ int Atrac2::ResetPlayPosition(int seekPos, int bytesWrittenFirstBuf, int bytesWr
 		return SCE_ERROR_ATRAC_BAD_SAMPLE;
 	}
 
+	StopDecodeAhead();
 	int result = ResetPlayPositionInternal(seekPos, bytesWrittenFirstBuf, bytesWrittenSecondBuf);
 	if (result >= 0) {
 		int skipCount = 0;
@@ -807,6 +817,7 @@ u32 Atrac2::DecodeData(u8 *outbuf, u32 outbufAddr, int *SamplesNum, int *finish,
 		}
 	}
 
+	QueueDecodeAhead();
 	*remains = RemainingFrames();
 	return 0;
 }
@@ -876,7 +887,11 @@ u32 Atrac2::DecodeInternal(u32 outbufAddr, int *SamplesNum, int *finish) {
 
 	int bytesConsumed = 0;
 	int outSamples = 0;
-	if (!decoder_->Decode(Memory::GetPointerUnchecked(inAddr), info.sampleSize, &bytesConsumed, outputChannels_, outPtr, &outSamples)) {
+	bool success;
+	if (!TakeDecodedAhead(inAddr, outPtr, &bytesConsumed, &outSamples, &success)) {
+		success = decoder_->Decode(Memory::GetPointerUnchecked(inAddr), info.sampleSize, &bytesConsumed, outputChannels_, outPtr, &outSamples);
+	}
+	if (!success) {
 		// Decode failed.
 		*finish = 0;
 		// TODO: The error code here varies based on what the problem is, but not sure of the right values.
@@ -968,8 +983,151 @@ u32 Atrac2::DecodeInternal(u32 outbufAddr, int *SamplesNum, int *finish) {
 	return 0;
 }
 
+// Optionally, the frames that are sure to be decoded next are decoded on a worker thread while the game
+// does other things, so that sceAtracDecodeData just has to copy the result out. "Sure" means the data is
+// already in the buffer, and we stop short of the loop end. Second buffer streaming and the other special
+// modes just decode the old way.
+// Packets are copied out here, and checked against memory again when used, so if the game seeks, refills
+// or otherwise changes the data, we notice and drop what we have. How far the worker got with them is down
+// to timing, so dropping flushes the decoder, see StopDecodeAhead. That only affects the overlap into the
+// next frame, at a point where the stream jumps anyway.
+void Atrac2::QueueDecodeAhead() {
+	const SceAtracIdInfo &info = context_->info;
+	if (!g_Config.bAtracDecodeAhead || !decoder_ || info.numSkipFrames != 0)
+		return;
+	switch (info.state) {
+	case ATRAC_STATUS_ALL_DATA_LOADED:
+	case ATRAC_STATUS_HALFWAY_BUFFER:
+	case ATRAC_STATUS_STREAMED_WITHOUT_LOOP:
+	case ATRAC_STATUS_STREAMED_LOOP_FROM_END:
+		break;
+	default:
+		return;
+	}
+
+	const bool streaming = AtracStatusIsStreaming(info.state);
+	int fileOff = info.curFileOff;
+	int streamOff = info.streamOff;
+	int streamDataByte = info.streamDataByte;
+
+	std::lock_guard<std::mutex> guard(aheadLock_);
+	for (int i = 0; i < ATRAC_DECODE_AHEAD_FRAMES; i++) {
+		// decodePos advances by at most a frame per frame, so this is on the safe side.
+		const int maxDecodePos = info.decodePos + i * info.SamplesPerFrame();
+		if (fileOff + info.sampleSize > info.fileDataEnd || maxDecodePos > info.endSample)
+			break;
+		if (info.loopEnd != 0 && maxDecodePos > info.loopEnd)
+			break;
+
+		u32 inAddr;
+		if (streaming) {
+			if (streamDataByte < info.sampleSize)
+				break;
+			inAddr = info.buffer + streamOff;
+		} else {
+			if (info.state == ATRAC_STATUS_HALFWAY_BUFFER && info.dataOff + info.streamDataByte < fileOff + info.sampleSize)
+				break;
+			inAddr = info.buffer + fileOff;
+		}
+		if (!Memory::IsValidRange(inAddr, info.sampleSize))
+			break;
+
+		if (i < (int)aheadFrames_.size()) {
+			// Queued last time. If it somehow doesn't match anymore, TakeDecodedAhead will drop it.
+			if (aheadFrames_[i].fileOff != fileOff || aheadFrames_[i].inAddr != inAddr)
+				break;
+		} else {
+			DecodeAheadFrame frame;
+			frame.fileOff = fileOff;
+			frame.inAddr = inAddr;
+			frame.channels = outputChannels_;
+			const u8 *packet = Memory::GetPointerUnchecked(inAddr);
+			frame.packet.assign(packet, packet + info.sampleSize);
+			frame.pcm.resize(info.SamplesPerFrame() * outputChannels_);
+			aheadFrames_.push_back(std::move(frame));
+		}
+
+		// Same steps as DecodeInternal.
+		fileOff += info.sampleSize;
+		if (streaming) {
+			streamDataByte -= info.sampleSize;
+			streamOff += info.sampleSize;
+			if (streamOff + info.sampleSize > (int)info.bufferByte)
+				streamOff = 0;
+		}
+	}
+
+	if (!aheadRunning_ && aheadDecoded_ < aheadFrames_.size()) {
+		aheadRunning_ = true;
+		g_threadManager.EnqueueTask(new IndependentTask(TaskType::CPU_COMPUTE, TaskPriority::HIGH, [this]() {
+			DecodeAheadWorker();
+		}));
+	}
+}
+
+void Atrac2::DecodeAheadWorker() {
+	std::unique_lock<std::mutex> guard(aheadLock_);
+	while (!aheadCancel_ && aheadDecoded_ < aheadFrames_.size()) {
+		// Only the other end of the deque changes meanwhile, which leaves this reference valid.
+		DecodeAheadFrame &frame = aheadFrames_[aheadDecoded_];
+		guard.unlock();
+		frame.success = decoder_->Decode(frame.packet.data(), (int)frame.packet.size(), &frame.bytesConsumed, frame.channels, frame.pcm.data(), &frame.outSamples);
+		guard.lock();
+		aheadDecoded_++;
+		aheadCond_.notify_all();
+	}
+	aheadRunning_ = false;
+	aheadCond_.notify_all();
+}
+
+bool Atrac2::TakeDecodedAhead(u32 inAddr, int16_t *outPtr, int *bytesConsumed, int *outSamples, bool *success) {
+	const SceAtracIdInfo &info = context_->info;
+	std::unique_lock<std::mutex> guard(aheadLock_);
+	if (aheadFrames_.empty())
+		return false;
+
+	const DecodeAheadFrame &frame = aheadFrames_.front();
+	bool same = frame.fileOff == info.curFileOff && frame.inAddr == inAddr && frame.channels == outputChannels_;
+	same = same && (int)frame.packet.size() == info.sampleSize && Memory::IsValidRange(inAddr, info.sampleSize);
+	same = same && memcmp(frame.packet.data(), Memory::GetPointerUnchecked(inAddr), frame.packet.size()) == 0;
+	if (same) {
+		aheadCond_.wait(guard, [this] { return aheadDecoded_ > 0 || !aheadRunning_; });
+		same = aheadDecoded_ > 0;
+	}
+	if (!same) {
+		guard.unlock();
+		StopDecodeAhead();
+		return false;
+	}
+
+	*bytesConsumed = frame.bytesConsumed;
+	*outSamples = frame.outSamples;
+	*success = frame.success;
+	if (frame.success && outPtr && frame.outSamples > 0) {
+		memcpy(outPtr, frame.pcm.data(), frame.outSamples * frame.channels * sizeof(int16_t));
+	}
+	aheadFrames_.pop_front();
+	aheadDecoded_--;
+	return true;
+}
+
+// Waits for the worker, and drops everything. Needed before anything else touches decoder_.
+// If anything was queued, the decoder may or may not have seen those frames, so it's flushed to
+// always leave it in the same state.
+void Atrac2::StopDecodeAhead() {
+	std::unique_lock<std::mutex> guard(aheadLock_);
+	aheadCancel_ = true;
+	aheadCond_.wait(guard, [this] { return !aheadRunning_; });
+	aheadCancel_ = false;
+	if (!aheadFrames_.empty() && decoder_)
+		decoder_->FlushBuffers();
+	aheadFrames_.clear();
+	aheadDecoded_ = 0;
+}
+
 int Atrac2::SetData(const Track &track, u32 bufferAddr, u32 readSize, u32 bufferSize, u32 fileSize, int outputChannels, bool isAA3) {
 	_dbg_assert_(outputChannels == 1 || outputChannels == 2);
+	StopDecodeAhead();
 	TrackInfo trackInfo{};
 	if (Memory::IsValidAddress(bufferAddr)) {
 		// Turns out that games can abuse bufferSize, so we can't verify that it's a valid length with GetPointerRange.
@@ -1129,6 +1287,7 @@ int Atrac2::Bitrate() const {
 }
 
 void Atrac2::InitLowLevel(const Atrac3LowLevelParams &params, int codecType) {
+	StopDecodeAhead();
 	SceAtracIdInfo &info = context_->info;
 	info.codec = codecType;
 	info.numChan = params.encodedChannels;
@@ -1161,6 +1320,7 @@ int Atrac2::DecodeLowLevel(const u8 *srcData, int *bytesConsumed, s16 *dstData,
 }
 
 void Atrac2::CheckForSas() {
+	StopDecodeAhead();
 	SceAtracIdInfo &info = context_->info;
 	if (info.numChan != 1) {
 		WARN_LOG(Log::Atrac, "Caller forgot to set channels to 1");
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
 
 #include "Core/HLE/AtracBase.h"
 
@@ -68,6 +72,23 @@ class Atrac2 : public AtracBase {
 
 	void DumpBufferToFile();
 
+	// Decode-ahead, see QueueDecodeAhead.
+	struct DecodeAheadFrame {
+		int fileOff;
+		u32 inAddr;
+		int channels;
+		std::vector<u8> packet;
+		std::vector<int16_t> pcm;
+		int bytesConsumed = 0;
+		int outSamples = 0;
+		bool success = false;
+	};
+
+	void QueueDecodeAhead();
+	bool TakeDecodedAhead(u32 inAddr, int16_t *outPtr, int *bytesConsumed, int *outSamples, bool *success);
+	void StopDecodeAhead();
+	void DecodeAheadWorker();
+
 	// Just the current decoded frame, in order to be able to cut off the first part of it
 	// to write the initial partial frame.
 	// Does not need to be saved.
@@ -77,6 +98,16 @@ class Atrac2 : public AtracBase {
 	// But it doesn't really matter whether it's here or there.
 	AtracSasStreamState sas_;
 
+	// While aheadRunning_ is set, the worker owns decoder_ and the frames from aheadDecoded_ on.
+	// None of this needs to be saved, it's just dropped and decoded again.
+	std::mutex aheadLock_;
+	std::condition_variable aheadCond_;
+	// The frames that will be decoded next, in order. The first aheadDecoded_ are done.
+	std::deque<DecodeAheadFrame> aheadFrames_;
+	size_t aheadDecoded_ = 0;
+	bool aheadRunning_ = false;
+	bool aheadCancel_ = false;
+
 	std::vector<u8> dumpBuffer_;  // Used for dumping audio data to files.
 	bool dumped_ = false;  // Whether we already dumped the audio data to a file.
 };
@@ -1,5 +1,6 @@
 #include "SimpleAudioDec.h"
 #include "Common/LogReporting.h"
+#include "Common/Math/CrossSIMD.h"
 #include "ext/at3_standalone/at3_decoders.h"
 
 inline int16_t clamp16(float f) {
@@ -11,6 +12,13 @@ inline int16_t clamp16(float f) {
 		return (int)(f * 32767);
 }
 
+#ifndef CROSSSIMD_SLOW
+// Same as clamp16, four at a time.
+inline Vec4S32 Clamp16x4(const float *f) {
+	return Vec4S32FromF32(Vec4F32::Load(f).Clamp(-1.0f, 1.0f) * 32767.0f);
+}
+#endif
+
 // Uses our standalone AT3/AT3+ decoder derived from FFMPEG
 // Test case for ATRAC3: Mega Man Maverick Hunter X, PSP menu sound
 class Atrac3Audio : public AudioDecoder {
@@ -129,13 +137,28 @@ class Atrac3Audio : public AudioDecoder {
 				if (outputChannels == 2) {
 					// Stereo output, standard.
 					const float *right = channels_ == 2 ? buffers_[1] : buffers_[0];
-					for (int i = 0; i < nb_samples; i++) {
+					int i = 0;
+#ifndef CROSSSIMD_SLOW
+					for (; i + 4 <= nb_samples; i += 4) {
+						Vec4S32 lo, hi;
+						Vec4S32::Interleave(Clamp16x4(left + i), Clamp16x4(right + i), lo, hi);
+						lo.StoreS16Saturate(outbuf + i * 2);
+						hi.StoreS16Saturate(outbuf + i * 2 + 4);
+					}
+#endif
+					for (; i < nb_samples; i++) {
 						outbuf[i * 2] = clamp16(left[i]);
 						outbuf[i * 2 + 1] = clamp16(right[i]);
 					}
 				} else {
 					// Mono output, just take the left channel.
-					for (int i = 0; i < nb_samples; i++) {
+					int i = 0;
+#ifndef CROSSSIMD_SLOW
+					for (; i + 4 <= nb_samples; i += 4) {
+						Clamp16x4(left + i).StoreS16Saturate(outbuf + i);
+					}
+#endif
+					for (; i < nb_samples; i++) {
 						outbuf[i] = clamp16(left[i]);
 					}
 				}
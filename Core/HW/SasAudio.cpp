@@ -17,9 +17,11 @@
 
 #include <algorithm>
 
+#include "Common/Math/CrossSIMD.h"
 #include "Common/Profiler/Profiler.h"
 
 #include "Common/Serialize/SerializeFuncs.h"
+#include "Common/Thread/ParallelLoop.h"
 #include "Core/MemMapHelpers.h"
 #include "Core/HLE/sceAtrac.h"
 #include "Core/Config.h"
@@ -28,6 +30,10 @@
 #include "Core/System.h"
 #include "SasAudio.h"
 
+// Below this many voices per thread, it's not worth waking up the workers.
+static const int SAS_PARALLEL_MIN_VOICES = 4;
+static const int SAS_PARALLEL_MAX_GROUPS = 8;
+
 static const u8 f[16][2] = {
 	{   0,   0 },
 	{  60,   0 },
@@ -97,15 +103,30 @@ void VagDecoder::DecodeBlock(const u8 *&read_pointer) {
 	int coef1 = f[predict_nr][0];
 	int coef2 = -f[predict_nr][1];
 
-	// TODO: Unroll once more and interleave the unpacking with the decoding more?
+	// Unpack all the nibbles first, this loop vectorizes well. The filter below depends
+	// on the previous two outputs though, so that has to go one sample at a time.
+	int unpacked[28];
 	for (int i = 0; i < 28; i += 2) {
-		u8 d = *readp++;
-		int sample1 = (short)((d & 0xf) << 12) >> shift_factor;
-		int sample2 = (short)((d & 0xf0) << 8) >> shift_factor;
-		s2 = clamp_s16(sample1 + ((s1 * coef1 + s2 * coef2) >> 6));
-		s1 = clamp_s16(sample2 + ((s2 * coef1 + s1 * coef2) >> 6));
-		samples[i] = s2;
-		samples[i + 1] = s1;
+		u8 d = readp[i >> 1];
+		unpacked[i] = (short)((d & 0xf) << 12) >> shift_factor;
+		unpacked[i + 1] = (short)((d & 0xf0) << 8) >> shift_factor;
+	}
+	readp += 14;
+
+	if (coef1 == 0 && coef2 == 0) {
+		// No prediction (filter 0 is common), the unpacked samples are already in range.
+		for (int i = 0; i < 28; i++) {
+			samples[i] = unpacked[i];
+		}
+		s1 = samples[27];
+		s2 = samples[26];
+	} else {
+		for (int i = 0; i < 28; i += 2) {
+			s2 = clamp_s16(unpacked[i] + ((s1 * coef1 + s2 * coef2) >> 6));
+			s1 = clamp_s16(unpacked[i + 1] + ((s2 * coef1 + s1 * coef2) >> 6));
+			samples[i] = s2;
+			samples[i + 1] = s1;
+		}
 	}
 
 	s_1 = s1;
@@ -376,7 +397,6 @@ SasInstance::SasInstance() {
 	memset(&waveformEffect, 0, sizeof(waveformEffect));
 	waveformEffect.type = PSP_SAS_EFFECT_TYPE_OFF;
 	waveformEffect.isDryOn = 1;
-	memset(mixTemp_, 0, sizeof(mixTemp_));  // just to avoid a static analysis warning.
 }
 
 SasInstance::~SasInstance() {
@@ -526,7 +546,73 @@ bool SasVoice::HaveSamplesEnded() const {
 	}
 }
 
-void SasInstance::MixVoice(SasVoice &voice) {
+void SasResampleVoice(int *out, const s16 *in, u32 frac, int pitch, int count) {
+	const s16 *s = in + (frac >> PSP_SAS_PITCH_BASE_SHIFT);
+	if (pitch == PSP_SAS_PITCH_BASE) {
+		const int f = frac & PSP_SAS_PITCH_MASK;
+		if (f == 0) {
+			// Not resampling at all, the common case.
+			for (int i = 0; i < count; i++) {
+				out[i] = s[i];
+			}
+		} else {
+			// The fraction stays the same, so this is a plain blend with the next sample.
+			for (int i = 0; i < count; i++) {
+				out[i] = (s[i] * (PSP_SAS_PITCH_MASK - f) + s[i + 1] * f) >> PSP_SAS_PITCH_BASE_SHIFT;
+			}
+		}
+		return;
+	}
+
+	// Linear interpolation. Good enough. Need to make resampleHist bigger if we want more.
+	for (int i = 0; i < count; i++) {
+		s = in + (frac >> PSP_SAS_PITCH_BASE_SHIFT);
+		const int f = frac & PSP_SAS_PITCH_MASK;
+		out[i] = (s[0] * (PSP_SAS_PITCH_MASK - f) + s[1] * f) >> PSP_SAS_PITCH_BASE_SHIFT;
+		frac += pitch;
+	}
+}
+
+void SasMixVoiceSamples(int *mix, int *send, const int *samples, const int *envelope, int count, int volLeft, int volRight, int effectLeft, int effectRight) {
+	int i = 0;
+#ifndef CROSSSIMD_SLOW
+	// All the products fit in 32 bits: samples and the envelope are at most 1 << 15, and so are the
+	// scaled samples, while the volumes are at most 1 << 12.
+	const Vec4S32 round = Vec4S32::Splat(1 << 14);
+	const Vec4S32 vl = Vec4S32::Splat(volLeft);
+	const Vec4S32 vr = Vec4S32::Splat(volRight);
+	const Vec4S32 el = Vec4S32::Splat(effectLeft);
+	const Vec4S32 er = Vec4S32::Splat(effectRight);
+	for (; i + 4 <= count; i += 4) {
+		Vec4S32 sample = (Vec4S32::Load(samples + i) * Vec4S32::Load(envelope + i) + round).Shr<15>();
+
+		Vec4S32 lo, hi;
+		Vec4S32::Interleave((sample * vl).Shr<12>(), (sample * vr).Shr<12>(), lo, hi);
+		(Vec4S32::Load(mix + i * 2) + lo).Store(mix + i * 2);
+		(Vec4S32::Load(mix + i * 2 + 4) + hi).Store(mix + i * 2 + 4);
+
+		Vec4S32::Interleave((sample * el).Shr<12>(), (sample * er).Shr<12>(), lo, hi);
+		(Vec4S32::Load(send + i * 2) + lo).Store(send + i * 2);
+		(Vec4S32::Load(send + i * 2 + 4) + hi).Store(send + i * 2 + 4);
+	}
+#endif
+
+	for (; i < count; i++) {
+		// We just scale by the envelope before we scale by volumes.
+		// Again, we round up by adding (1 << 14) first (*after* multiplying.)
+		int sample = ((samples[i] * envelope[i]) + (1 << 14)) >> 15;
+
+		// We mix into this 32-bit temp buffer and clip in a second loop
+		// Ideally, the shift right should be there too but for now I'm concerned about
+		// not overflowing.
+		mix[i * 2] += (sample * volLeft) >> 12;
+		mix[i * 2 + 1] += (sample * volRight) >> 12;
+		send[i * 2] += sample * effectLeft >> 12;
+		send[i * 2 + 1] += sample * effectRight >> 12;
+	}
+}
+
+void SasInstance::MixVoice(SasVoice &voice, SasVoiceScratch &scratch, int *mix, int *send) {
 	switch (voice.type) {
 	case VOICETYPE_VAG:
 		if (voice.type == VOICETYPE_VAG && !voice.vagAddr)
@@ -551,25 +637,26 @@ void SasInstance::MixVoice(SasVoice &voice) {
 
 		// Resample to the correct pitch, writing exactly "grainSize" samples. We need a buffer that can
 		// fit 4x that, as the max pitch is 0x4000.
-		// TODO: Special case no-resample case (and 2x and 0.5x) for speed, it's not uncommon
+		// TODO: Special case 2x and 0.5x for speed too, they're not uncommon either.
 
 		// Two passes: First read, then resample.
-		mixTemp_[0] = voice.resampleHist[0];
-		mixTemp_[1] = voice.resampleHist[1];
+		int16_t *mixTemp = scratch.mixTemp;
+		mixTemp[0] = voice.resampleHist[0];
+		mixTemp[1] = voice.resampleHist[1];
 
 		int voicePitch = voice.pitch;
 		u32 sampleFrac = voice.sampleFrac;
 		int samplesToRead = (sampleFrac + voicePitch * std::max(0, grainSize - delay)) >> PSP_SAS_PITCH_BASE_SHIFT;
-		if (samplesToRead > ARRAY_SIZE(mixTemp_) - 2) {
+		if (samplesToRead > ARRAY_SIZE(scratch.mixTemp) - 2) {
 			ERROR_LOG(Log::sceSas, "Too many samples to read (%d)! This shouldn't happen.", samplesToRead);
-			samplesToRead = ARRAY_SIZE(mixTemp_) - 2;
+			samplesToRead = ARRAY_SIZE(scratch.mixTemp) - 2;
 		}
 		int readPos = 2;
 		if (voice.envelope.NeedsKeyOn()) {
 			readPos = 0;
 			samplesToRead += 2;
 		}
-		voice.ReadSamples(&mixTemp_[readPos], samplesToRead);
+		voice.ReadSamples(&mixTemp[readPos], samplesToRead);
 		int tempPos = readPos + samplesToRead;
 
 		for (int i = 0; i < delay; ++i) {
@@ -578,39 +665,23 @@ void SasInstance::MixVoice(SasVoice &voice) {
 			voice.envelope.Step();
 		}
 
-		const bool needsInterp = voicePitch != PSP_SAS_PITCH_BASE || (sampleFrac & PSP_SAS_PITCH_MASK) != 0;
-		for (int i = delay; i < grainSize; i++) {
-			const int16_t *s = mixTemp_ + (sampleFrac >> PSP_SAS_PITCH_BASE_SHIFT);
-
-			// Linear interpolation. Good enough. Need to make resampleHist bigger if we want more.
-			int sample = s[0];
-			if (needsInterp) {
-				int f = sampleFrac & PSP_SAS_PITCH_MASK;
-				sample = (s[0] * (PSP_SAS_PITCH_MASK - f) + s[1] * f) >> PSP_SAS_PITCH_BASE_SHIFT;
-			}
-			sampleFrac += voicePitch;
-
+		// Only walking the envelope has to go sample by sample, so do that first, then the rest in bulk.
+		const int count = std::max(0, grainSize - delay);
+		for (int i = 0; i < count; i++) {
 			// The maximum envelope height (PSP_SAS_ENVELOPE_HEIGHT_MAX) is (1 << 30) - 1.
 			// Reduce it to 14 bits, by shifting off 15.  Round up by adding (1 << 14) first.
-			int envelopeValue = voice.envelope.GetHeight();
+			scratch.voiceEnvelope[i] = (voice.envelope.GetHeight() + (1 << 14)) >> 15;
 			voice.envelope.Step();
-			envelopeValue = (envelopeValue + (1 << 14)) >> 15;
-
-			// We just scale by the envelope before we scale by volumes.
-			// Again, we round up by adding (1 << 14) first (*after* multiplying.)
-			sample = ((sample * envelopeValue) + (1 << 14)) >> 15;
-
-			// We mix into this 32-bit temp buffer and clip in a second loop
-			// Ideally, the shift right should be there too but for now I'm concerned about
-			// not overflowing.
-			mixBuffer[i * 2] += (sample * voice.volumeLeft) >> 12;
-			mixBuffer[i * 2 + 1] += (sample * voice.volumeRight) >> 12;
-			sendBuffer[i * 2] += sample * voice.effectLeft >> 12;
-			sendBuffer[i * 2 + 1] += sample * voice.effectRight >> 12;
 		}
 
-		voice.resampleHist[0] = mixTemp_[tempPos - 2];
-		voice.resampleHist[1] = mixTemp_[tempPos - 1];
+		SasResampleVoice(scratch.voiceSamples, mixTemp, sampleFrac, voicePitch, count);
+		sampleFrac += voicePitch * count;
+
+		SasMixVoiceSamples(mix + delay * 2, send + delay * 2, scratch.voiceSamples, scratch.voiceEnvelope, count,
+			voice.volumeLeft, voice.volumeRight, voice.effectLeft, voice.effectRight);
+
+		voice.resampleHist[0] = mixTemp[tempPos - 2];
+		voice.resampleHist[1] = mixTemp[tempPos - 1];
 
 		voice.sampleFrac = sampleFrac - (tempPos - 2) * PSP_SAS_PITCH_BASE;
 
@@ -624,12 +695,74 @@ void SasInstance::MixVoice(SasVoice &voice) {
 	}
 }
 
-void SasInstance::Mix(u32 outAddr, u32 inAddr, int leftVol, int rightVol, bool mute) {
+void SasInstance::MixVoicesParallel() {
+	// Atrac voices decode through the shared atrac contexts, so those are mixed right here.
+	int parallelVoices[PSP_SAS_VOICES_MAX];
+	int numParallel = 0;
 	for (int v = 0; v < PSP_SAS_VOICES_MAX; v++) {
 		SasVoice &voice = voices[v];
 		if (!voice.playing || voice.paused)
 			continue;
-		MixVoice(voice);
+		if (voice.type == VOICETYPE_ATRAC3)
+			MixVoice(voice, scratch_, mixBuffer, sendBuffer);
+		else
+			parallelVoices[numParallel++] = v;
+	}
+
+	// The first group mixes straight into mixBuffer/sendBuffer, the rest into partial buffers.
+	const int numGroups = std::min(std::min(numParallel / SAS_PARALLEL_MIN_VOICES, SAS_PARALLEL_MAX_GROUPS), g_threadManager.GetNumLooperThreads());
+	if (numGroups < 2) {
+		for (int i = 0; i < numParallel; i++)
+			MixVoice(voices[parallelVoices[i]], scratch_, mixBuffer, sendBuffer);
+		return;
+	}
+
+	const int partialSize = grainSize * 4;
+	while ((int)workerScratch_.size() < numGroups - 1)
+		workerScratch_.push_back(std::make_unique<SasVoiceScratch>());
+	if ((int)partialMix_.size() < (numGroups - 1) * partialSize)
+		partialMix_.resize((numGroups - 1) * partialSize);
+
+	ParallelRangeLoop(&g_threadManager, [&](int lower, int upper) {
+		for (int group = lower; group < upper; group++) {
+			SasVoiceScratch &scratch = group == 0 ? scratch_ : *workerScratch_[group - 1];
+			int *mix = mixBuffer;
+			int *send = sendBuffer;
+			if (group != 0) {
+				mix = &partialMix_[(group - 1) * partialSize];
+				send = mix + grainSize * 2;
+				memset(mix, 0, partialSize * sizeof(int));
+			}
+			// Always the same split for the same voices, it doesn't depend on the thread count.
+			const int start = numParallel * group / numGroups;
+			const int end = numParallel * (group + 1) / numGroups;
+			for (int i = start; i < end; i++)
+				MixVoice(voices[parallelVoices[i]], scratch, mix, send);
+		}
+	}, 0, numGroups, 1, TaskPriority::HIGH);
+
+	// Add them up in a fixed order. Each voice's contribution is the same as in a serial mix, and integer
+	// adds don't care about order, so the result is bit-identical.
+	for (int group = 1; group < numGroups; group++) {
+		const int *mix = &partialMix_[(group - 1) * partialSize];
+		const int *send = mix + grainSize * 2;
+		for (int i = 0; i < grainSize * 2; i++) {
+			mixBuffer[i] += mix[i];
+			sendBuffer[i] += send[i];
+		}
+	}
+}
+
+void SasInstance::Mix(u32 outAddr, u32 inAddr, int leftVol, int rightVol, bool mute) {
+	if (g_Config.bSasParallelMix) {
+		MixVoicesParallel();
+	} else {
+		for (int v = 0; v < PSP_SAS_VOICES_MAX; v++) {
+			SasVoice &voice = voices[v];
+			if (!voice.playing || voice.paused)
+				continue;
+			MixVoice(voice, scratch_, mixBuffer, sendBuffer);
+		}
 	}
 
 	// Apply mute if needed (note: we try to keep everything else identical to the non-muted case).
@@ -22,6 +22,9 @@
 
 #pragma once
 
+#include <memory>
+#include <vector>
+
 #include "Common/CommonTypes.h"
 #include "Core/HW/BufferQueue.h"
 #include "Core/HW/SasReverb.h"
@@ -291,6 +294,20 @@ struct SasVoice {
 	SasAtrac3 atrac3;
 };
 
+// The bulk parts of mixing a voice, outside the class so they can be checked against plain loops.
+// Resamples count samples from in, starting at frac (12-bit fixed point) and stepping by pitch.
+void SasResampleVoice(int *out, const s16 *in, u32 frac, int pitch, int count);
+// Scales the samples by the envelope, then by the volumes, and adds them to the interleaved stereo buffers.
+void SasMixVoiceSamples(int *mix, int *send, const int *samples, const int *envelope, int count, int volLeft, int volRight, int effectLeft, int effectRight);
+
+// Temp buffers for mixing a voice. Each thread mixing voices needs its own.
+struct SasVoiceScratch {
+	int16_t mixTemp[PSP_SAS_MAX_GRAIN * 4 + 2 + 16];  // some extra margin for very high pitches.
+	// The current voice, resampled, and its envelope.
+	int voiceSamples[PSP_SAS_MAX_GRAIN];
+	int voiceEnvelope[PSP_SAS_MAX_GRAIN];
+};
+
 class SasInstance {
 public:
 	SasInstance();
@@ -313,7 +330,7 @@ class SasInstance {
 	FILE *audioDump = nullptr;
 
 	void Mix(u32 outAddr, u32 inAddr, int leftVol, int rightVol, bool mute);
-	void MixVoice(SasVoice &voice);
+	void MixVoice(SasVoice &voice, SasVoiceScratch &scratch, int *mix, int *send);
 
 	// Applies reverb to send buffer, according to waveformEffect.
 	void ApplyWaveformEffect();
@@ -328,9 +345,15 @@ class SasInstance {
 	WaveformEffect waveformEffect;
 
 private:
+	void MixVoicesParallel();
+
 	SasReverb reverb_;
 	int grainSize = 0;
-	int16_t mixTemp_[PSP_SAS_MAX_GRAIN * 4 + 2 + 16];  // some extra margin for very high pitches.
+	SasVoiceScratch scratch_{};
+	// Only used with bSasParallelMix, one per extra group of voices.
+	std::vector<std::unique_ptr<SasVoiceScratch>> workerScratch_;
+	// The extra groups mix into these (interleaved mix, then interleaved send), and get added up in order.
+	std::vector<int> partialMix_;
 };
 
 const char *ADSRCurveModeAsString(SasADSRCurveMode mode);
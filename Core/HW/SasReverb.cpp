@@ -15,9 +15,11 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
 #include <cstdint>
 #include <cstring>
 
+#include "Common/Math/CrossSIMD.h"
 #include "Common/Math/math_util.h"
 #include "Core/Config.h"
 #include "Core/HW/SasReverb.h"
@@ -70,7 +72,8 @@ struct SasReverbData {
 	// int16_t vRIN;
 };
 
-static const SasReverbData presets[10] = {
+// Only 9 presets, sceSasRevType clamps to that.
+static constexpr SasReverbData presets[] = {
 	{
 		"Room",
 		0x26C0,
@@ -211,6 +214,244 @@ class BufferWrapper {
 	int size_;
 };
 
+// Straight into the upper part of the buffer, for stretches where none of the taps wrap around.
+class DirectBuffer {
+public:
+	DirectBuffer(int16_t *position) : pos_(position) {}
+	int16_t &operator [](int index) { return pos_[index]; }
+
+private:
+	int16_t *pos_;
+};
+
+enum {
+	REVERB_GROUP_SIZE = 4,
+};
+
+// How far from the current position a preset's taps reach, and whether ReverbGroup can be used with it.
+struct SasReverbLayout {
+	int minOffset;
+	int maxOffset;
+	bool groupable;
+};
+
+struct SasReverbAccess {
+	int offset;
+	// What ReverbGroup does for all the samples of a group in one go. 0 is the reflections, which it
+	// does sample by sample, 1 the comb reads, 2-5 the all pass filters.
+	int stage;
+	bool write;
+};
+
+struct SasReverbAccessList {
+	SasReverbAccess accesses[28]{};
+	int count = 0;
+
+	constexpr void Add(int offset, int stage, bool write) {
+		accesses[count++] = SasReverbAccess{ offset, stage, write };
+	}
+};
+
+static constexpr SasReverbLayout AnalyzePreset(const SasReverbData &d) {
+	SasReverbAccessList list;
+	list.Add(d.dLSAME, 0, false);
+	list.Add(d.mLSAME - 1, 0, false);
+	list.Add(d.mLSAME, 0, true);
+	list.Add(d.dRSAME, 0, false);
+	list.Add(d.mRSAME - 1, 0, false);
+	list.Add(d.mRSAME, 0, true);
+	list.Add(d.dRDIFF, 0, false);
+	list.Add(d.mLDIFF - 1, 0, false);
+	list.Add(d.mLDIFF, 0, true);
+	list.Add(d.dLDIFF, 0, false);
+	list.Add(d.mRDIFF - 1, 0, false);
+	list.Add(d.mRDIFF, 0, true);
+
+	// Taps with a zero volume aren't read.
+	const int vCOMB[4] = { d.vCOMB1, d.vCOMB2, d.vCOMB3, d.vCOMB4 };
+	const int mLCOMB[4] = { d.mLCOMB1, d.mLCOMB2, d.mLCOMB3, d.mLCOMB4 };
+	const int mRCOMB[4] = { d.mRCOMB1, d.mRCOMB2, d.mRCOMB3, d.mRCOMB4 };
+	for (int i = 0; i < 4; i++) {
+		if (vCOMB[i] != 0) {
+			list.Add(mLCOMB[i], 1, false);
+			list.Add(mRCOMB[i], 1, false);
+		}
+	}
+
+	list.Add(d.mLAPF1 - d.dAPF1, 2, false);
+	list.Add(d.mLAPF1, 2, true);
+	list.Add(d.mRAPF1 - d.dAPF1, 3, false);
+	list.Add(d.mRAPF1, 3, true);
+	list.Add(d.mLAPF2 - d.dAPF2, 4, false);
+	list.Add(d.mLAPF2, 4, true);
+	list.Add(d.mRAPF2 - d.dAPF2, 5, false);
+	list.Add(d.mRAPF2, 5, true);
+
+	SasReverbLayout layout{ list.accesses[0].offset, list.accesses[0].offset, true };
+	for (int i = 0; i < list.count; i++) {
+		const SasReverbAccess &a = list.accesses[i];
+		layout.minOffset = a.offset < layout.minOffset ? a.offset : layout.minOffset;
+		layout.maxOffset = a.offset > layout.maxOffset ? a.offset : layout.maxOffset;
+
+		// Doing a stage for the whole group moves its accesses for the first samples of the group ahead of
+		// the earlier stages' accesses for the later samples (and within a stage, the reads ahead of the writes).
+		// That only gives the same result as going sample by sample if those never hit the same spot.
+		for (int j = 0; j < list.count; j++) {
+			const SasReverbAccess &b = list.accesses[j];
+			const bool later = a.stage > b.stage || (a.stage == b.stage && a.write && !b.write);
+			if (!later || a.stage == 0 || !(a.write || b.write))
+				continue;
+			const int distance = a.offset - b.offset;
+			if (distance >= 1 && distance < REVERB_GROUP_SIZE)
+				layout.groupable = false;
+		}
+	}
+	return layout;
+}
+
+// The preset is a template parameter everywhere below, so the taps and volumes are constants.
+
+// ____Same Side Reflection(left - to - left and right - to - right)___________________
+// ___Different Side Reflection(left - to - right and right - to - left)_______________
+// These feed back into themselves one sample later, so can only be done one sample at a time.
+template <int P, class B>
+static inline void ReverbReflect(B &b, int16_t Lin, int16_t Rin) {
+	constexpr SasReverbData d = presets[P];
+	b[d.mLSAME] = clamp_s16(Lin + (b[d.dLSAME] * d.vWALL >> 15) - (b[d.mLSAME - 1]*d.vIIR >> 15) + b[d.mLSAME - 1]); // L - to - L
+	b[d.mRSAME] = clamp_s16(Rin + (b[d.dRSAME] * d.vWALL >> 15) - (b[d.mRSAME - 1]*d.vIIR >> 15) + b[d.mRSAME - 1]); // R - to - R
+	b[d.mLDIFF] = clamp_s16(Lin + (b[d.dRDIFF] * d.vWALL >> 15) - (b[d.mLDIFF - 1]*d.vIIR >> 15) + b[d.mLDIFF - 1]); // R - to - L
+	b[d.mRDIFF] = clamp_s16(Rin + (b[d.dLDIFF] * d.vWALL >> 15) - (b[d.mRDIFF - 1]*d.vIIR >> 15) + b[d.mRDIFF - 1]); // L - to - R
+}
+
+// One sample through the whole network, straight from the description.
+template <int P, class B>
+static inline void ReverbSample(B &b, int16_t *output, const int16_t *input, int volLeft, int volRight) {
+	constexpr SasReverbData d = presets[P];
+
+	// Dividing by two here is an incorrect hack. Some multiplication factor is needed to prevent the reverb from getting too loud, though.
+	int16_t LeftInput = input[0] >> 1;
+	int16_t RightInput = input[1] >> 1;
+
+	int16_t Lin = LeftInput; //  (d.vLIN * LeftInput) >> 15;
+	int16_t Rin = RightInput; // (d.vRIN * RightInput) >> 15;
+
+	ReverbReflect<P>(b, Lin, Rin);
+	// ___Early Echo(Comb Filter, with input from buffer)__________________________
+	int32_t Lout = ((d.vCOMB1*b[d.mLCOMB1] + d.vCOMB2*b[d.mLCOMB2] + d.vCOMB3*b[d.mLCOMB3] + d.vCOMB4*b[d.mLCOMB4]) >> 15);
+	int32_t Rout = ((d.vCOMB1*b[d.mRCOMB1] + d.vCOMB2*b[d.mRCOMB2] + d.vCOMB3*b[d.mRCOMB3] + d.vCOMB4*b[d.mRCOMB4]) >> 15);
+	// ___Late Reverb APF1(All Pass Filter 1, with input from COMB)________________
+	b[d.mLAPF1] = clamp_s16(Lout - (d.vAPF1*b[(d.mLAPF1 - d.dAPF1)] >> 15));
+	Lout = b[(d.mLAPF1 - d.dAPF1)] + (b[d.mLAPF1] * d.vAPF1 >> 15);
+	b[d.mRAPF1] = clamp_s16(Rout - (d.vAPF1*b[(d.mRAPF1 - d.dAPF1)] >> 15));
+	Rout = b[(d.mRAPF1 - d.dAPF1)] + (b[d.mRAPF1] * d.vAPF1 >> 15);
+	// ___Late Reverb APF2(All Pass Filter 2, with input from APF1)________________
+	b[d.mLAPF2] = clamp_s16(Lout - (d.vAPF2*b[(d.mLAPF2 - d.dAPF2)] >> 15));
+	Lout = b[(d.mLAPF2 - d.dAPF2)] + (b[d.mLAPF2] * d.vAPF2 >> 15);
+	b[d.mRAPF2] = clamp_s16(Rout - (d.vAPF2*b[(d.mRAPF2 - d.dAPF2)] >> 15));
+	Rout = b[(d.mRAPF2 - d.dAPF2)] + (b[d.mRAPF2] * d.vAPF2 >> 15);
+	// ___Output to Mixer(Output volume multiplied with input from APF2)___________
+	output[0] = clamp_s16((Lout * volLeft) >> 15);
+	output[1] = clamp_s16((Rout * volRight) >> 15);
+	output[2] = 0;
+	output[3] = 0;
+}
+
+#ifndef CROSSSIMD_SLOW
+
+template <int P>
+static inline Vec4S32 ReverbCombGroup(const int16_t *p, int m1, int m2, int m3, int m4) {
+	constexpr SasReverbData d = presets[P];
+	Vec4S32 sum = Vec4S32::Zero();
+	if constexpr (d.vCOMB1 != 0)
+		sum += Vec4S32::LoadS16(p + m1).Mul16(Vec4S32::Splat(d.vCOMB1));
+	if constexpr (d.vCOMB2 != 0)
+		sum += Vec4S32::LoadS16(p + m2).Mul16(Vec4S32::Splat(d.vCOMB2));
+	if constexpr (d.vCOMB3 != 0)
+		sum += Vec4S32::LoadS16(p + m3).Mul16(Vec4S32::Splat(d.vCOMB3));
+	if constexpr (d.vCOMB4 != 0)
+		sum += Vec4S32::LoadS16(p + m4).Mul16(Vec4S32::Splat(d.vCOMB4));
+	return sum.Shr<15>();
+}
+
+static inline Vec4S32 ReverbAllPassGroup(int16_t *p, int m, int delay, Vec4S32 vAPF, Vec4S32 in) {
+	const Vec4S32 delayed = Vec4S32::LoadS16(p + m - delay);
+	(in - delayed.Mul16(vAPF).Shr<15>()).StoreS16Saturate(p + m);
+	// Read back to get the clamped values.
+	const Vec4S32 filtered = Vec4S32::LoadS16(p + m);
+	return delayed + filtered.Mul16(vAPF).Shr<15>();
+}
+
+// Same as REVERB_GROUP_SIZE calls to ReverbSample, but only the reflections are done one by one.
+// Only for presets where AnalyzePreset says that's fine, and where no taps wrap around.
+template <int P>
+static inline void ReverbGroup(int16_t *p, int16_t *output, const int16_t *input, int volLeft, int volRight) {
+	constexpr SasReverbData d = presets[P];
+	for (int i = 0; i < REVERB_GROUP_SIZE; i++) {
+		DirectBuffer b(p + i);
+		ReverbReflect<P>(b, input[i * 2] >> 1, input[i * 2 + 1] >> 1);
+	}
+
+	Vec4S32 Lout = ReverbCombGroup<P>(p, d.mLCOMB1, d.mLCOMB2, d.mLCOMB3, d.mLCOMB4);
+	Vec4S32 Rout = ReverbCombGroup<P>(p, d.mRCOMB1, d.mRCOMB2, d.mRCOMB3, d.mRCOMB4);
+	const Vec4S32 vAPF1 = Vec4S32::Splat(d.vAPF1);
+	const Vec4S32 vAPF2 = Vec4S32::Splat(d.vAPF2);
+	Lout = ReverbAllPassGroup(p, d.mLAPF1, d.dAPF1, vAPF1, Lout);
+	Rout = ReverbAllPassGroup(p, d.mRAPF1, d.dAPF1, vAPF1, Rout);
+	Lout = ReverbAllPassGroup(p, d.mLAPF2, d.dAPF2, vAPF2, Lout);
+	Rout = ReverbAllPassGroup(p, d.mRAPF2, d.dAPF2, vAPF2, Rout);
+
+	int16_t left[REVERB_GROUP_SIZE], right[REVERB_GROUP_SIZE];
+	(Lout * Vec4S32::Splat(volLeft)).Shr<15>().StoreS16Saturate(left);
+	(Rout * Vec4S32::Splat(volRight)).Shr<15>().StoreS16Saturate(right);
+	for (int i = 0; i < REVERB_GROUP_SIZE; i++) {
+		output[i * 4 + 0] = left[i];
+		output[i * 4 + 1] = right[i];
+		output[i * 4 + 2] = 0;
+		output[i * 4 + 3] = 0;
+	}
+}
+
+#endif
+
+template <int P>
+void SasReverb::ProcessPreset(int16_t *output, const int16_t *input, size_t inputSize, int volLeft, int volRight) {
+	constexpr SasReverbData d = presets[P];
+	constexpr SasReverbLayout layout = AnalyzePreset(d);
+	// Between these positions, none of the taps wrap around.
+	const int directStart = BUFSIZE - d.size - layout.minOffset;
+	const int directEnd = BUFSIZE - layout.maxOffset;
+
+	size_t i = 0;
+	while (i < inputSize) {
+		if (pos_ < directStart || pos_ >= directEnd) {
+			BufferWrapper<BUFSIZE> b(workspace_, pos_, d.size);
+			ReverbSample<P>(b, output + i * 4, input + i * 2, volLeft, volRight);
+			b.Next();
+			pos_ = b.GetPosition();
+			i++;
+			continue;
+		}
+
+		const size_t count = std::min(inputSize - i, (size_t)(directEnd - pos_));
+		size_t j = 0;
+#ifndef CROSSSIMD_SLOW
+		if constexpr (layout.groupable) {
+			for (; j + REVERB_GROUP_SIZE <= count; j += REVERB_GROUP_SIZE)
+				ReverbGroup<P>(workspace_ + pos_ + j, output + (i + j) * 4, input + (i + j) * 2, volLeft, volRight);
+		}
+#endif
+		for (; j < count; j++) {
+			DirectBuffer b(workspace_ + pos_ + j);
+			ReverbSample<P>(b, output + (i + j) * 4, input + (i + j) * 2, volLeft, volRight);
+		}
+
+		i += count;
+		pos_ += (int)count;
+		if (pos_ >= BUFSIZE)
+			pos_ -= d.size;
+	}
+}
+
 void SasReverb::ProcessReverb(int16_t *output, const int16_t *input, size_t inputSize, int volLeft, int volRight) {
 	// This means replicate the input signal in the processed buffer.
 	// Can also be used to verify that the error is in here...
@@ -236,51 +477,16 @@ void SasReverb::ProcessReverb(int16_t *output, const int16_t *input, size_t inpu
 		volRight *= reverbVolumeMultiplier;
 	}
 
-	const SasReverbData &d = presets[preset_];
-
-	// We put this on the stack instead of in the object to let the compiler optimize better (avoid mem r/w).
-	BufferWrapper<BUFSIZE> b(workspace_, pos_, d.size);
-
 	// This runs at 22khz.
-	// Very unoptimized, straight from the description. Can probably be reformulated into something way more efficient.
-	// Or we could actually template the whole thing with the parameters as template arguments, as the presets are fixed.
-	for (size_t i = 0; i < inputSize; i++) {
-		// Dividing by two here is an incorrect hack. Some multiplication factor is needed to prevent the reverb from getting too loud, though.
-		int16_t LeftInput = input[i * 2] >> 1;
-		int16_t RightInput = input[i * 2 + 1] >> 1;
-
-		int16_t Lin = LeftInput; //  (d.vLIN * LeftInput) >> 15;
-		int16_t Rin = RightInput; // (d.vRIN * RightInput) >> 15;
-
-		// ____Same Side Reflection(left - to - left and right - to - right)___________________
-		b[d.mLSAME] = clamp_s16(Lin + (b[d.dLSAME] * d.vWALL >> 15) - (b[d.mLSAME - 1]*d.vIIR >> 15) + b[d.mLSAME - 1]); // L - to - L
-		b[d.mRSAME] = clamp_s16(Rin + (b[d.dRSAME] * d.vWALL >> 15) - (b[d.mRSAME - 1]*d.vIIR >> 15) + b[d.mRSAME - 1]); // R - to - R
-		// ___Different Side Reflection(left - to - right and right - to - left)_______________
-		b[d.mLDIFF] = clamp_s16(Lin + (b[d.dRDIFF] * d.vWALL >> 15) - (b[d.mLDIFF - 1]*d.vIIR >> 15) + b[d.mLDIFF - 1]); // R - to - L
-		b[d.mRDIFF] = clamp_s16(Rin + (b[d.dLDIFF] * d.vWALL >> 15) - (b[d.mRDIFF - 1]*d.vIIR >> 15) + b[d.mRDIFF - 1]); // L - to - R
-		// ___Early Echo(Comb Filter, with input from buffer)__________________________
-		int32_t Lout = ((d.vCOMB1*b[d.mLCOMB1] + d.vCOMB2*b[d.mLCOMB2] + d.vCOMB3*b[d.mLCOMB3] + d.vCOMB4*b[d.mLCOMB4]) >> 15);
-		int32_t Rout = ((d.vCOMB1*b[d.mRCOMB1] + d.vCOMB2*b[d.mRCOMB2] + d.vCOMB3*b[d.mRCOMB3] + d.vCOMB4*b[d.mRCOMB4]) >> 15);
-		// ___Late Reverb APF1(All Pass Filter 1, with input from COMB)________________
-		b[d.mLAPF1] = clamp_s16(Lout - (d.vAPF1*b[(d.mLAPF1 - d.dAPF1)] >> 15));
-		Lout = b[(d.mLAPF1 - d.dAPF1)] + (b[d.mLAPF1] * d.vAPF1 >> 15);
-		b[d.mRAPF1] = clamp_s16(Rout - (d.vAPF1*b[(d.mRAPF1 - d.dAPF1)] >> 15));
-		Rout = b[(d.mRAPF1 - d.dAPF1)] + (b[d.mRAPF1] * d.vAPF1 >> 15);
-		// ___Late Reverb APF2(All Pass Filter 2, with input from APF1)________________
-		b[d.mLAPF2] = clamp_s16(Lout - (d.vAPF2*b[(d.mLAPF2 - d.dAPF2)] >> 15));
-		Lout = b[(d.mLAPF2 - d.dAPF2)] + (b[d.mLAPF2] * d.vAPF2 >> 15);
-		b[d.mRAPF2] = clamp_s16(Rout - (d.vAPF2*b[(d.mRAPF2 - d.dAPF2)] >> 15));
-		Rout = b[(d.mRAPF2 - d.dAPF2)] + (b[d.mRAPF2] * d.vAPF2 >> 15);
-		// ___Output to Mixer(Output volume multiplied with input from APF2)___________
-		output[i * 4 + 0] = clamp_s16((Lout * volLeft) >> 15);
-		output[i * 4 + 1] = clamp_s16((Rout * volRight) >> 15);
-		output[i * 4 + 2] = 0;
-		output[i * 4 + 3] = 0;
-
-		b.Next();
+	switch (preset_) {
+	case 0: ProcessPreset<0>(output, input, inputSize, volLeft, volRight); break;
+	case 1: ProcessPreset<1>(output, input, inputSize, volLeft, volRight); break;
+	case 2: ProcessPreset<2>(output, input, inputSize, volLeft, volRight); break;
+	case 3: ProcessPreset<3>(output, input, inputSize, volLeft, volRight); break;
+	case 4: ProcessPreset<4>(output, input, inputSize, volLeft, volRight); break;
+	case 5: ProcessPreset<5>(output, input, inputSize, volLeft, volRight); break;
+	case 6: ProcessPreset<6>(output, input, inputSize, volLeft, volRight); break;
+	case 7: ProcessPreset<7>(output, input, inputSize, volLeft, volRight); break;
+	case 8: ProcessPreset<8>(output, input, inputSize, volLeft, volRight); break;
 	}
-
-	// Save the state in the object.
-	pos_ = b.GetPosition();
 }
-
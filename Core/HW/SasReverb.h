@@ -34,6 +34,9 @@ class SasReverb {
 	void ProcessReverb(int16_t *output, const int16_t *input, size_t inputSize, int volLeft, int volRight);
 
 private:
+	template <int P>
+	void ProcessPreset(int16_t *output, const int16_t *input, size_t inputSize, int volLeft, int volRight);
+
 	enum {
 		BUFSIZE = 0x20000,
 	};
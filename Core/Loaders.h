@@ -91,6 +91,11 @@ class FileLoader {
 	virtual size_t ReadAt(s64 absolutePos, size_t bytes, void *data, Flags flags = Flags::NONE) {
 		return ReadAt(absolutePos, 1, bytes, data, flags);
 	}
+	// Direct access to the data, for loaders that have all of it in memory (like a mapped file.)
+	// Stays valid as long as the loader lives. Returns nullptr if not possible, then use ReadAt.
+	virtual const u8 *GetPointer(s64 absolutePos, size_t bytes) {
+		return nullptr;
+	}
 
 	// Cancel any operations that might block, if possible.
 	virtual void Cancel() {}
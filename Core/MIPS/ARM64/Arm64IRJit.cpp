@@ -243,8 +243,14 @@ void Arm64JitBackend::CompIR_Generic(IRInst inst) {
 	FlushAll();
 	SaveStaticRegisters();
 	WriteDebugProfilerStatus(IRProfilerStatus::IR_INTERPRET);
-	MOVI2R(X0, value);
-	QuickCallFunction(SCRATCH2_64, &DoIRInst);
+	if (inst.op == IROp::InterpretBlock) {
+		MOVP2R(X0, jit_);
+		MOVI2R(W1, inst.constant);
+		QuickCallFunction(SCRATCH2_64, &DoInterpretBlock);
+	} else {
+		MOVI2R(X0, value);
+		QuickCallFunction(SCRATCH2_64, &DoIRInst);
+	}
 	WriteDebugProfilerStatus(IRProfilerStatus::IN_JIT);
 	LoadStaticRegisters();
 
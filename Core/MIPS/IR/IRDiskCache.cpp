@@ -0,0 +1,280 @@
+// Copyright (c) 2026- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <cstring>
+
+#include "ext/xxhash.h"
+#include "Common/File/FileUtil.h"
+#include "Common/Log.h"
+#include "Core/Config.h"
+#include "Core/MemMap.h"
+#include "Core/MIPS/IR/IRDiskCache.h"
+#include "Core/MIPS/IR/IRJit.h"
+#include "Core/Util/PathUtil.h"
+
+namespace MIPSComp {
+
+IRDiskCache g_irDiskCache;
+
+#define IR_CACHE_HEADER_MAGIC 0x43524950  // "PIRC"
+#define IR_CACHE_VERSION 1
+
+// We don't want the file to grow without bounds if a game generates lots of code.
+static const u32 IR_CACHE_MAX_INSTRUCTIONS = 4 * 1024 * 1024;
+
+struct IRCacheHeader {
+	u32 magic;
+	u32 version;
+	// Op numbering and replacement function indices can change between builds.
+	u64 buildHash;
+	u32 instSize;
+	u32 disableFlags;
+	u8 unalignedLoadStore;
+	u8 unalignedLoadStoreVec4;
+	u8 preferVec4;
+	u8 preferVec4Dot;
+	u8 optimizeForInterpreter;
+	u8 pad[3];
+	u32 numEntries;
+	u32 numInstructions;
+};
+
+struct IRCacheEntryHeader {
+	u32 emAddr;
+	u32 origSize;
+	u64 hash;
+	u32 flags;
+	u32 numInstructions;
+};
+
+static u64 BuildHash() {
+	return XXH3_64bits(PPSSPP_GIT_VERSION, strlen(PPSSPP_GIT_VERSION));
+}
+
+static void FillHeaderOptions(IRCacheHeader &header, const IROptions &opts) {
+	header.disableFlags = opts.disableFlags;
+	header.unalignedLoadStore = opts.unalignedLoadStore;
+	header.unalignedLoadStoreVec4 = opts.unalignedLoadStoreVec4;
+	header.preferVec4 = opts.preferVec4;
+	header.preferVec4Dot = opts.preferVec4Dot;
+	header.optimizeForInterpreter = opts.optimizeForInterpreter;
+}
+
+void IRDiskCache::Load(const std::string &discID, const IROptions &opts) {
+	std::lock_guard<std::mutex> guard(lock_);
+	entries_.clear();
+	arena_.clear();
+	dirty_ = false;
+	opts_ = opts;
+	filename_.clear();
+
+	if (discID.empty())
+		return;
+
+	File::CreateFullPath(GetSysDirectory(DIRECTORY_APP_CACHE));
+	filename_ = GetSysDirectory(DIRECTORY_APP_CACHE) / (discID + ".ircache");
+
+	FILE *f = File::OpenCFile(filename_, "rb");
+	if (!f)
+		return;
+	bool success = LoadFile(f);
+	fclose(f);
+
+	if (!success) {
+		WARN_LOG(Log::JIT, "IR disk cache %s is stale or corrupt, starting over", filename_.c_str());
+		entries_.clear();
+		arena_.clear();
+		// Make sure we overwrite it on the next save.
+		dirty_ = true;
+	} else {
+		INFO_LOG(Log::JIT, "Loaded %d blocks (%d IR instructions) from the IR disk cache", (int)entries_.size(), (int)arena_.size());
+	}
+}
+
+bool IRDiskCache::LoadFile(FILE *f) {
+	IRCacheHeader header{};
+	if (fread(&header, sizeof(header), 1, f) != 1)
+		return false;
+
+	if (header.magic != IR_CACHE_HEADER_MAGIC || header.version != IR_CACHE_VERSION)
+		return false;
+	if (header.buildHash != BuildHash() || header.instSize != sizeof(IRInst))
+		return false;
+
+	IROptions fileOpts{};
+	fileOpts.disableFlags = header.disableFlags;
+	fileOpts.unalignedLoadStore = header.unalignedLoadStore != 0;
+	fileOpts.unalignedLoadStoreVec4 = header.unalignedLoadStoreVec4 != 0;
+	fileOpts.preferVec4 = header.preferVec4 != 0;
+	fileOpts.preferVec4Dot = header.preferVec4Dot != 0;
+	fileOpts.optimizeForInterpreter = header.optimizeForInterpreter != 0;
+	if (!Matches(fileOpts))
+		return false;
+	if (header.numInstructions > IR_CACHE_MAX_INSTRUCTIONS)
+		return false;
+
+	arena_.resize(header.numInstructions);
+	if (header.numInstructions != 0 && fread(&arena_[0], sizeof(IRInst), header.numInstructions, f) != header.numInstructions)
+		return false;
+
+	entries_.reserve(header.numEntries);
+	for (u32 i = 0; i < header.numEntries; ++i) {
+		IRCacheEntryHeader e;
+		if (fread(&e, sizeof(e), 1, f) != 1)
+			return false;
+		u32 offset = 0;
+		if (fread(&offset, sizeof(offset), 1, f) != 1)
+			return false;
+		if (e.numInstructions == 0 || offset > arena_.size() || e.numInstructions > arena_.size() - offset)
+			return false;
+		entries_.emplace(e.emAddr, Entry{ e.hash, e.origSize, e.flags, offset, e.numInstructions });
+	}
+	return true;
+}
+
+void IRDiskCache::Save() {
+	std::lock_guard<std::mutex> guard(lock_);
+	if (filename_.empty() || !dirty_)
+		return;
+
+	FILE *f = File::OpenCFile(filename_, "wb");
+	if (!f)
+		return;
+
+	IRCacheHeader header{};
+	header.magic = IR_CACHE_HEADER_MAGIC;
+	header.version = IR_CACHE_VERSION;
+	header.buildHash = BuildHash();
+	header.instSize = sizeof(IRInst);
+	FillHeaderOptions(header, opts_);
+	header.numEntries = (u32)entries_.size();
+	header.numInstructions = (u32)arena_.size();
+
+	bool writeFailed = fwrite(&header, sizeof(header), 1, f) != 1;
+	if (!arena_.empty())
+		writeFailed = writeFailed || fwrite(&arena_[0], sizeof(IRInst), arena_.size(), f) != arena_.size();
+	for (const auto &it : entries_) {
+		IRCacheEntryHeader e{ it.first, it.second.origSize, it.second.hash, it.second.flags, it.second.numInstructions };
+		writeFailed = writeFailed || fwrite(&e, sizeof(e), 1, f) != 1;
+		writeFailed = writeFailed || fwrite(&it.second.arenaOffset, sizeof(u32), 1, f) != 1;
+	}
+	fclose(f);
+
+	if (writeFailed) {
+		ERROR_LOG(Log::JIT, "Failed to write IR disk cache, deleting %s", filename_.c_str());
+		File::Delete(filename_);
+	} else {
+		INFO_LOG(Log::JIT, "Saved %d blocks to the IR disk cache", (int)entries_.size());
+		dirty_ = false;
+	}
+}
+
+void IRDiskCache::Clear() {
+	std::lock_guard<std::mutex> guard(lock_);
+	entries_.clear();
+	arena_.clear();
+	arena_.shrink_to_fit();
+	filename_.clear();
+	dirty_ = false;
+}
+
+bool IRDiskCache::Matches(const IROptions &opts) const {
+	return opts.disableFlags == opts_.disableFlags && opts.unalignedLoadStore == opts_.unalignedLoadStore &&
+		opts.unalignedLoadStoreVec4 == opts_.unalignedLoadStoreVec4 && opts.preferVec4 == opts_.preferVec4 &&
+		opts.preferVec4Dot == opts_.preferVec4Dot && opts.optimizeForInterpreter == opts_.optimizeForInterpreter;
+}
+
+void IRDiskCache::AddEntry(u32 emAddr, u64 hash, u32 origSize, u32 flags, const IRInst *insts, u32 numInstructions) {
+	auto range = entries_.equal_range(emAddr);
+	for (auto it = range.first; it != range.second; ++it) {
+		const Entry &e = it->second;
+		if (e.hash == hash && e.origSize == origSize && (e.flags & IRDISKCACHE_MATCH_MASK) == (flags & IRDISKCACHE_MATCH_MASK))
+			return;
+	}
+	if (arena_.size() + numInstructions > IR_CACHE_MAX_INSTRUCTIONS)
+		return;
+
+	u32 offset = (u32)arena_.size();
+	arena_.insert(arena_.end(), insts, insts + numInstructions);
+	entries_.emplace(emAddr, Entry{ hash, origSize, flags, offset, numInstructions });
+	dirty_ = true;
+}
+
+void IRDiskCache::AddBlocks(const IRBlockCache &blocks) {
+	std::lock_guard<std::mutex> guard(lock_);
+	if (filename_.empty())
+		return;
+
+	for (int i = 0; i < blocks.GetNumBlocks(); ++i) {
+		const IRBlock *b = blocks.GetBlock(i);
+		if (!b->IsValid() || b->GetHash() == 0 || !b->HashMatches())
+			continue;
+
+		const IRInst *insts = blocks.GetBlockInstructionPtr(*b);
+		u32 blockFlags = b->GetDiskCacheFlags();
+		bool skip = false;
+		for (int j = 0; j < b->GetNumIRInstructions(); ++j) {
+			switch (insts[j].op) {
+			case IROp::Breakpoint:
+			case IROp::MemoryCheck:
+			case IROp::LogIRBlock:
+				// Debugging aids, these depend on state we don't track.
+				skip = true;
+				break;
+			case IROp::UpdateRoundingMode:
+				blockFlags |= IRDISKCACHE_SETS_ROUNDING;
+				break;
+			default:
+				break;
+			}
+		}
+		if (skip)
+			continue;
+
+		u32 start, size;
+		b->GetRange(&start, &size);
+		AddEntry(start, b->GetHash(), size, blockFlags, insts, (u32)b->GetNumIRInstructions());
+	}
+}
+
+bool IRDiskCache::Lookup(u32 emAddr, u32 flags, std::vector<IRInst> &instructions, u32 &mipsBytes, u32 *blockFlags) {
+	std::lock_guard<std::mutex> guard(lock_);
+	auto range = entries_.equal_range(emAddr);
+	u32 hashedSize = 0;
+	u64 hash = 0;
+	for (auto it = range.first; it != range.second; ++it) {
+		const Entry &e = it->second;
+		if ((e.flags & IRDISKCACHE_MATCH_MASK) != (flags & IRDISKCACHE_MATCH_MASK))
+			continue;
+		if (!Memory::IsValidRange(emAddr, e.origSize))
+			continue;
+		if (hashedSize != e.origSize) {
+			hash = IRBlock::HashRange(emAddr, e.origSize);
+			hashedSize = e.origSize;
+		}
+		if (hash != e.hash)
+			continue;
+
+		instructions.assign(arena_.begin() + e.arenaOffset, arena_.begin() + e.arenaOffset + e.numInstructions);
+		mipsBytes = e.origSize;
+		*blockFlags = e.flags;
+		return true;
+	}
+	return false;
+}
+
+}  // namespace MIPSComp
@@ -0,0 +1,84 @@
+// Copyright (c) 2026- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/File/Path.h"
+#include "Core/MIPS/IR/IRInst.h"
+
+namespace MIPSComp {
+
+class IRBlockCache;
+
+// Frontend state that affects the IR generated for a block. A cached block is only
+// reused if these match the state the frontend is in when the block is requested.
+enum IRDiskCacheFlags : u32 {
+	IRDISKCACHE_HAS_SET_ROUNDING = 1,
+	IRDISKCACHE_START_DEFAULT_PREFIX = 2,
+	// Not part of the match - the block itself sets the rounding mode, so the frontend has to know.
+	IRDISKCACHE_SETS_ROUNDING = 4,
+
+	IRDISKCACHE_MATCH_MASK = IRDISKCACHE_HAS_SET_ROUNDING | IRDISKCACHE_START_DEFAULT_PREFIX,
+};
+
+// Optimized IR for blocks seen in earlier sessions of the same game, so warm boots can skip
+// the frontend and the simplify passes. Entries are keyed by start address and validated
+// against a hash of the MIPS code (the same one IRBlock uses) before being handed out.
+class IRDiskCache {
+public:
+	// Loads the cache file for a game. Anything already in memory is dropped.
+	void Load(const std::string &discID, const IROptions &opts);
+	// Writes back to the file we loaded from, if anything was added.
+	void Save();
+	void Clear();
+
+	bool IsLoaded() const { return !filename_.empty(); }
+	bool Matches(const IROptions &opts) const;
+
+	// Call with the emuhack ops cleared, so block hashes can be compared against memory.
+	void AddBlocks(const IRBlockCache &blocks);
+	bool Lookup(u32 emAddr, u32 flags, std::vector<IRInst> &instructions, u32 &mipsBytes, u32 *blockFlags);
+
+private:
+	struct Entry {
+		u64 hash;
+		u32 origSize;
+		u32 flags;
+		u32 arenaOffset;
+		u32 numInstructions;
+	};
+
+	void AddEntry(u32 emAddr, u64 hash, u32 origSize, u32 flags, const IRInst *insts, u32 numInstructions);
+	bool LoadFile(FILE *f);
+
+	std::mutex lock_;
+	Path filename_;
+	IROptions opts_{};
+	std::unordered_multimap<u32, Entry> entries_;
+	std::vector<IRInst> arena_;
+	bool dirty_ = false;
+};
+
+extern IRDiskCache g_irDiskCache;
+
+}  // namespace MIPSComp
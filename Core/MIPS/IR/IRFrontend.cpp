@@ -27,6 +27,7 @@
 #include "Core/MIPS/IR/IRFrontend.h"
 #include "Core/MIPS/IR/IRRegCache.h"
 #include "Core/MIPS/IR/IRPassSimplify.h"
+#include "Core/MIPS/IR/IRDiskCache.h"
 #include "Core/MIPS/IR/IRInterpreter.h"
 #include "Core/MIPS/MIPSTracer.h"
 
@@ -141,6 +142,21 @@ bool IRFrontend::CheckRounding(u32 blockAddress) {
 	return cleanSlate;
 }
 
+u32 IRFrontend::GetDiskCacheFlags() const {
+	u32 flags = 0;
+	if (js.hasSetRounding)
+		flags |= IRDISKCACHE_HAS_SET_ROUNDING;
+	if (js.startDefaultPrefix)
+		flags |= IRDISKCACHE_START_DEFAULT_PREFIX;
+	return flags;
+}
+
+void IRFrontend::ApplyCachedBlockFlags(u32 blockFlags) {
+	// Same as what UpdateRoundingMode() would have done while compiling it.
+	if (blockFlags & IRDISKCACHE_SETS_ROUNDING)
+		js.hasSetRounding = true;
+}
+
 void IRFrontend::Comp_ReplacementFunc(MIPSOpcode op) {
 	int index = op.encoding & MIPS_EMUHACK_VALUE_MASK;
 
@@ -241,7 +257,28 @@ MIPSOpcode IRFrontend::GetOffsetInstruction(int offset) {
 	return Memory::Read_Instruction(GetCompilerPC() + 4 * offset);
 }
 
-void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &mipsBytes) {
+bool IRFrontend::OptimizeIR(const IRWriter &in, IRWriter &out, const IROptions &opts) {
+	std::vector<IRPassFunc> passes{
+		&ApplyMemoryValidation,
+		&RemoveLoadStoreLeftRight,
+		&OptimizeFPMoves,
+		&PropagateConstants,
+		&PurgeTemps,
+		&ReduceVec4Flush,
+		&OptimizeLoadsAfterStores,
+		// &ReorderLoadStore,
+		// &MergeLoadStore,
+		// &ThreeOpToTwoOp,
+	};
+
+	if (opts.optimizeForInterpreter) {
+		// Add special passes here.
+		passes.push_back(&OptimizeForInterpreter);
+	}
+	return IRApplyPasses(passes.data(), passes.size(), in, out, opts);
+}
+
+void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &mipsBytes, std::vector<IRInst> *unoptimized) {
 	js.cancel = false;
 	js.blockStart = em_address;
 	js.compilerPC = em_address;
@@ -260,6 +297,8 @@ void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &m
 	ir.Reserve(64); // Estimate a reasonable number of IR instructions per block
 
 	js.numInstructions = 0;
+	size_t segmentStart = 0;
+	int segments = 1;
 	while (js.compiling) {
 		// Jit breakpoints are quite fast, so let's do them in release too.
 		CheckBreakpoint(GetCompilerPC());
@@ -269,6 +308,11 @@ void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &m
 		MIPSCompileOp(inst, this);
 		js.compilerPC += 4;
 		js.numInstructions++;
+
+		if (!js.compiling && superblocks_ && ContinueTrace(em_address, segmentStart, segments)) {
+			segmentStart = ir.GetInstructions().size();
+			segments++;
+		}
 	}
 
 	if (js.cancel) {
@@ -280,25 +324,14 @@ void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &m
 
 	IRWriter simplified;
 	IRWriter *code = &ir;
-	if (!js.hadBreakpoints) {
-		std::vector<IRPassFunc> passes{
-			&ApplyMemoryValidation,
-			&RemoveLoadStoreLeftRight,
-			&OptimizeFPMoves,
-			&PropagateConstants,
-			&PurgeTemps,
-			&ReduceVec4Flush,
-			&OptimizeLoadsAfterStores,
-			// &ReorderLoadStore,
-			// &MergeLoadStore,
-			// &ThreeOpToTwoOp,
-		};
-
-		if (opts.optimizeForInterpreter) {
-			// Add special passes here.
-			passes.push_back(&OptimizeForInterpreter);
-		}
-		if (IRApplyPasses(passes.data(), passes.size(), ir, simplified, opts))
+	if (unoptimized) {
+		// The caller will do the rest of the passes later, we just need the block to behave.
+		*unoptimized = ir.GetInstructions();
+		IRPassFunc validation = &ApplyMemoryValidation;
+		IRApplyPasses(&validation, 1, ir, simplified, opts);
+		code = &simplified;
+	} else if (!js.hadBreakpoints) {
+		if (OptimizeIR(ir, simplified, opts))
 			logBlocks = 1;
 		code = &simplified;
 		//if (ir.GetInstructions().size() >= 24)
@@ -353,6 +386,76 @@ void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &m
 		dontLogBlocks--;
 }
 
+// Superblocks are a single range for invalidation, so we only follow forward exits,
+// and not too far - everything we skip over is part of the range too.
+static const u32 MAX_TRACE_GAP = 256;
+static const int MAX_TRACE_SEGMENTS = 4;
+static const int MAX_TRACE_INSTRUCTIONS = 256;
+
+bool IRFrontend::AddHotExit(u32 blockStart, u32 blockEnd, u32 target) {
+	if (target < blockEnd || target - blockEnd > MAX_TRACE_GAP)
+		return false;
+	auto range = hotExits_.equal_range(blockStart);
+	for (auto it = range.first; it != range.second; ++it) {
+		if (it->second == target)
+			return false;
+	}
+	hotExits_.emplace(blockStart, target);
+	return true;
+}
+
+bool IRFrontend::ContinueTrace(u32 blockStart, size_t segmentStart, int segments) {
+	// The tracer logs the block range instruction by instruction, so don't confuse it.
+	if (js.cancel || js.hadBreakpoints || mipsTracer.tracing_enabled)
+		return false;
+	if (segments >= MAX_TRACE_SEGMENTS || js.numInstructions >= MAX_TRACE_INSTRUCTIONS)
+		return false;
+
+	const std::vector<IRInst> &insts = ir.GetInstructions();
+	if (insts.empty() || insts.back().op != IROp::ExitToConst)
+		return false;
+	u32 target = insts.back().constant;
+	if (target < GetCompilerPC() || target - GetCompilerPC() > MAX_TRACE_GAP || !Memory::IsValid4AlignedAddress(target))
+		return false;
+
+	bool hot = false;
+	auto range = hotExits_.equal_range(blockStart);
+	for (auto it = range.first; it != range.second; ++it) {
+		if (it->second == target)
+			hot = true;
+	}
+
+	if (!hot) {
+		// Without profile data, only follow exits that are always taken (j, jal, b.)
+		for (size_t i = segmentStart; i < insts.size() - 1; ++i) {
+			const IRInst &inst = insts[i];
+			switch (inst.op) {
+			case IROp::ExitToConstIfNeq:
+				// beq zero, zero writes one of these that can never exit.
+				if (inst.src1 != inst.src2)
+					return false;
+				break;
+			case IROp::ExitToConstIfEq:
+			case IROp::ExitToConstIfGtZ:
+			case IROp::ExitToConstIfGeZ:
+			case IROp::ExitToConstIfLtZ:
+			case IROp::ExitToConstIfLeZ:
+			case IROp::ExitToConstIfFpTrue:
+			case IROp::ExitToConstIfFpFalse:
+				return false;
+			default:
+				break;
+			}
+		}
+	}
+
+	// Everything was flushed before the exit, so we can just carry on from the target.
+	ir.DropLast();
+	js.compilerPC = target;
+	js.compiling = true;
+	return true;
+}
+
 void IRFrontend::Comp_RunBlock(MIPSOpcode op) {
 	// This shouldn't be necessary, the dispatcher should catch us before we get here.
 	ERROR_LOG(Log::JIT, "Comp_RunBlock should never be reached!");
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <unordered_map>
+
 #include "Common/CommonTypes.h"
 #include "Core/MIPS/JitCommon/JitCommon.h"
 #include "Core/MIPS/JitCommon/JitState.h"
@@ -89,7 +91,10 @@ class IRFrontend : public MIPSFrontendInterface {
 	void DoState(PointerWrap &p);
 	bool CheckRounding(u32 blockAddress);  // returns true if we need a do-over
 
-	void DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &mipsBytes);
+	// If unoptimized is set, only the passes needed for correctness are run, and the raw IR is
+	// returned too so that OptimizeIR() can be run on it later (possibly on another thread.)
+	void DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &mipsBytes, std::vector<IRInst> *unoptimized = nullptr);
+	static bool OptimizeIR(const IRWriter &in, IRWriter &out, const IROptions &opts);
 
 	void EatPrefix() override {
 		js.EatPrefix();
@@ -98,6 +103,25 @@ class IRFrontend : public MIPSFrontendInterface {
 	void SetOptions(const IROptions &o) {
 		opts = o;
 	}
+	const IROptions &GetOptions() const {
+		return opts;
+	}
+
+	// For the IR disk cache, which hands out blocks without going through DoJit().
+	u32 GetDiskCacheFlags() const;
+	void ApplyCachedBlockFlags(u32 blockFlags);
+
+	// Superblocks: instead of ending a block at its final exit, keep compiling at the target
+	// if it's a short forward hop. Done for unconditional jumps, and for exits the IR
+	// interpreter has found to be hot.
+	void EnableSuperblocks(bool enable) {
+		superblocks_ = enable;
+	}
+	// Returns false if the exit can't be turned into a trace.
+	bool AddHotExit(u32 blockStart, u32 blockEnd, u32 target);
+	bool HasHotExits(u32 blockStart) const {
+		return hotExits_.count(blockStart) != 0;
+	}
 
 private:
 	void RestoreRoundingMode(bool force = false);
@@ -114,6 +138,7 @@ class IRFrontend : public MIPSFrontendInterface {
 
 	void CheckBreakpoint(u32 addr);
 	void CheckMemoryBreakpoint(int rs, int offset);
+	bool ContinueTrace(u32 blockStart, size_t segmentStart, int segments);
 
 	// Utility compilation functions
 	void BranchFPFlag(MIPSOpcode op, IRComparison cc, bool likely);
@@ -141,6 +166,10 @@ class IRFrontend : public MIPSFrontendInterface {
 
 	int dontLogBlocks = 0;
 	int logBlocks = 0;
+
+	bool superblocks_ = false;
+	// Block start -> exit target.
+	std::unordered_multimap<u32, u32> hotExits_;
 };
 
 }  // namespace
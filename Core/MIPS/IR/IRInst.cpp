@@ -165,6 +165,7 @@ static const IRMeta irMeta[] = {
 	{ IROp::Vec2Pack31To16, "Vec2Pack31To16", "F2" },
 
 	{ IROp::Interpret, "Interpret", "_C", IRFLAG_BARRIER },
+	{ IROp::InterpretBlock, "InterpretBlock", "_C", IRFLAG_EXIT },
 	{ IROp::Downcount, "Downcount", "_C" },
 	{ IROp::ExitToPC, "ExitToPC", "", IRFLAG_EXIT },
 	{ IROp::ExitToConst, "Exit", "C", IRFLAG_EXIT },
@@ -203,6 +203,8 @@ enum class IROp : uint8_t {
 
 	// Fake/System instructions
 	Interpret,
+	// Native backends only. Runs the IR at arena offset const in the interpreter, see IRBlockCache::AllocateInterpretedBlock.
+	InterpretBlock,
 
 	// Emit this before you exit. Semantic is to set the downcount
 	// that will be used at the actual exit.
@@ -400,6 +402,9 @@ class IRWriter {
 	void Clear() {
 		insts_.clear();
 	}
+	void DropLast() {
+		insts_.pop_back();
+	}
 	void ReplaceConstant(size_t instNumber, u32 newConstant);
 
 	const std::vector<IRInst> &GetInstructions() const { return insts_; }
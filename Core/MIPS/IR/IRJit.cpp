@@ -18,6 +18,7 @@
 #include "ppsspp_config.h"
 #include <set>
 #include <algorithm>
+#include <cstring>
 
 #include "ext/xxhash.h"
 #include "Common/Profiler/Profiler.h"
@@ -25,10 +26,13 @@
 #include "Common/Log.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/StringUtils.h"
+#include "Common/Thread/ThreadManager.h"
 
 #include "Core/Config.h"
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
+#include "Core/Debugger/Breakpoints.h"
+#include "Core/ELF/ParamSFO.h"
 #include "Core/HLE/sceKernelMemory.h"
 #include "Core/MemMap.h"
 #include "Core/MIPS/MIPS.h"
@@ -36,11 +40,13 @@
 #include "Core/MIPS/Interpreter.h"
 #include "Core/MIPS/MIPSTables.h"
 #include "Core/MIPS/IR/IRRegCache.h"
+#include "Core/MIPS/IR/IRDiskCache.h"
 #include "Core/MIPS/IR/IRInterpreter.h"
 #include "Core/MIPS/IR/IRJit.h"
 #include "Core/MIPS/IR/IRNativeCommon.h"
 #include "Core/MIPS/JitCommon/JitCommon.h"
 #include "Core/Reporting.h"
+#include "Core/System.h"
 #include "Common/TimeUtil.h"
 #include "Core/MIPS/MIPSTracer.h"
 
@@ -75,9 +81,22 @@ IRJit::IRJit(MIPSState *mipsState, bool actualJit) : frontend_(mipsState->HasDef
 #endif
 	opts.optimizeForInterpreter = jo.optimizeForInterpreter;
 	frontend_.SetOptions(opts);
+	frontend_.EnableSuperblocks(g_Config.bIRSuperblocks);
+	// The native backends link exits directly, so they don't come back to our dispatcher to be counted.
+	profileExits_ = g_Config.bIRSuperblocks && !actualJit;
+	backgroundCompile_ = g_Config.bIRBackgroundCompile;
+
+	useDiskCache_ = g_Config.bIRDiskCache;
+	if (useDiskCache_ && (!g_irDiskCache.IsLoaded() || !g_irDiskCache.Matches(opts))) {
+		// Switched cores, most likely. Keep what we have and start on the file for this config.
+		g_irDiskCache.Save();
+		g_irDiskCache.Load(g_paramSFO.GetDiscID(), opts);
+	}
 }
 
 IRJit::~IRJit() {
+	WaitForBackgroundCompiles();
+	SaveBlocksToDiskCache();
 }
 
 void IRJit::DoState(PointerWrap &p) {
@@ -89,7 +108,140 @@ void IRJit::UpdateFCR31() {
 
 void IRJit::ClearCache() {
 	INFO_LOG(Log::JIT, "IRJit: Clearing the block cache!");
+	SaveBlocksToDiskCache();
 	blocks_.Clear();
+	// Anything still in flight refers to blocks that are now gone.
+	backgroundGeneration_++;
+}
+
+void IRJit::SaveBlocksToDiskCache() {
+	if (!useDiskCache_ || blocks_.GetNumBlocks() == 0 || !Memory::IsActive())
+		return;
+	// The block hashes are of the original code, so take our emuhacks out while comparing.
+	std::vector<u32> saved = blocks_.SaveAndClearEmuHackOps();
+	g_irDiskCache.AddBlocks(blocks_);
+	blocks_.RestoreSavedEmuHackOps(saved);
+}
+
+class IRBackgroundCompileTask : public Task {
+public:
+	IRBackgroundCompileTask(IRJit *jit, IRBackgroundBlock &&block, const IROptions &opts) : jit_(jit), block_(std::move(block)), opts_(opts) {}
+
+	TaskType Type() const override { return TaskType::CPU_COMPUTE; }
+	TaskPriority Priority() const override { return TaskPriority::HIGH; }
+
+	void Run() override {
+		IRWriter in;
+		in.Reserve(block_.instructions.size());
+		for (const IRInst &inst : block_.instructions)
+			in.Write(inst);
+
+		IRWriter out;
+		IRFrontend::OptimizeIR(in, out, opts_);
+		block_.instructions = out.GetInstructions();
+		jit_->FinishBackgroundCompile(std::move(block_));
+	}
+
+private:
+	IRJit *jit_;
+	IRBackgroundBlock block_;
+	IROptions opts_;
+};
+
+void IRJit::QueueBackgroundCompile(IRBackgroundBlock &&block) {
+	{
+		std::lock_guard<std::mutex> guard(backgroundLock_);
+		backgroundPending_++;
+	}
+	g_threadManager.EnqueueTask(new IRBackgroundCompileTask(this, std::move(block), frontend_.GetOptions()));
+}
+
+void IRJit::FinishBackgroundCompile(IRBackgroundBlock &&block) {
+	std::lock_guard<std::mutex> guard(backgroundLock_);
+	backgroundDone_.push_back(std::move(block));
+	backgroundReady_ = true;
+	backgroundPending_--;
+	backgroundCond_.notify_all();
+}
+
+void IRJit::WaitForBackgroundCompiles() {
+	std::unique_lock<std::mutex> guard(backgroundLock_);
+	backgroundCond_.wait(guard, [&] { return backgroundPending_ == 0; });
+	backgroundDone_.clear();
+	backgroundReady_ = false;
+}
+
+// Swaps in optimized blocks from the workers. Must be called between dispatches, since the
+// arena can move and the old block's emuhack is replaced.
+void IRJit::PublishBackgroundBlocks() {
+	std::vector<IRBackgroundBlock> done;
+	{
+		std::lock_guard<std::mutex> guard(backgroundLock_);
+		done.swap(backgroundDone_);
+		backgroundReady_ = false;
+	}
+
+	for (IRBackgroundBlock &result : done) {
+		const IRBlock *oldBlock = blocks_.GetBlock(result.blockNum);
+		// It may have been invalidated (or turned into a superblock) in the meantime.
+		if (result.generation != backgroundGeneration_ || !oldBlock || !oldBlock->IsValid() || oldBlock->GetOriginalStart() != result.emAddr)
+			continue;
+
+		int block_num = blocks_.AllocateBlock(result.emAddr, result.mipsBytes, result.instructions);
+		if ((block_num & ~MIPS_EMUHACK_VALUE_MASK) != 0) {
+			// Out of room, keep the unoptimized ones until the cache is cleared.
+			break;
+		}
+		// Same for code space. The unfinalized block is never looked up, and the next compile clears the cache.
+		if (!CompileNativeBlock(&blocks_, block_num))
+			break;
+
+		IRBlock *old = blocks_.GetBlock(result.blockNum);
+		blocks_.RemoveBlockFromPageLookup(result.blockNum);
+		old->Destroy(compileToNative_ ? old->GetNativeOffset() : old->GetIRArenaOffset());
+
+		IRBlock *b = blocks_.GetBlock(block_num);
+		if (useDiskCache_) {
+			b->UpdateHash();
+			b->SetDiskCacheFlags(result.diskCacheFlags);
+		}
+		// Also relinks the native exits that went to the placeholder.
+		blocks_.FinalizeBlock(block_num);
+		FinalizeNativeBlock(&blocks_, block_num);
+	}
+}
+
+// The native code for a block waiting on a worker is just an InterpretBlock, which comes here.
+// It's a call out of the jit like any other, so it's a safe point to publish native code too,
+// as long as it doesn't clear the cache: the placeholder we return to is left alone.
+u32 IRJit::RunInterpretedBlock(u32 irOffset) {
+	if (backgroundReady_) {
+		PublishBackgroundBlocks();
+	}
+	// Publishing may have moved the arena.
+	return IRInterpret(mips_, blocks_.GetArenaPtr() + irOffset);
+}
+
+void IRJit::FormSuperblock(u32 offset, u32 target) {
+	int blockNum = blocks_.GetBlockNumFromIRArenaOffset(offset);
+	IRBlock *block = blocks_.GetBlock(blockNum);
+	if (!block || !block->IsValid())
+		return;
+
+	// Only the final exit can be continued, side exits stay as they are.
+	const IRInst &last = blocks_.GetBlockInstructionPtr(*block)[block->GetNumIRInstructions() - 1];
+	if (last.op != IROp::ExitToConst || last.constant != target)
+		return;
+
+	u32 start, size;
+	block->GetRange(&start, &size);
+	if (!frontend_.AddHotExit(start, start + size, target))
+		return;
+
+	// The next dispatch to this address will compile it again, this time through the hot exit.
+	DEBUG_LOG(Log::JIT, "IRJit: Forming superblock at %08x through %08x", start, target);
+	blocks_.RemoveBlockFromPageLookup(blockNum);
+	block->Destroy(block->GetIRArenaOffset());
 }
 
 void IRJit::InvalidateCacheAt(u32 em_address, int length) {
@@ -136,10 +288,26 @@ void IRJit::Compile(u32 em_address) {
 bool IRJit::CompileBlock(u32 em_address, std::vector<IRInst> &instructions, u32 &mipsBytes) {
 	_dbg_assert_(compilerEnabled_);
 
-	frontend_.DoJit(em_address, instructions, mipsBytes);
+	// Cached blocks wouldn't have any breakpoint checks or tracing hooks in them.
+	bool diskCacheUsable = useDiskCache_ && !mipsTracer.tracing_enabled && !g_breakpoints.HasBreakPoints() && !g_breakpoints.HasMemChecks();
+	u32 diskCacheFlags = frontend_.GetDiskCacheFlags();
+	u32 cachedBlockFlags = 0;
+	// A cached block wouldn't include the hot exits we've found since.
+	bool background = false;
+	std::vector<IRInst> unoptimized;
+	if (diskCacheUsable && !frontend_.HasHotExits(em_address) && g_irDiskCache.Lookup(em_address, diskCacheFlags, instructions, mipsBytes, &cachedBlockFlags)) {
+		frontend_.ApplyCachedBlockFlags(cachedBlockFlags);
+	} else if (backgroundCompile_ && !mipsTracer.tracing_enabled && !g_breakpoints.HasBreakPoints() && !g_breakpoints.HasMemChecks()) {
+		// Run it right away as is, and optimize it on a worker.
+		frontend_.DoJit(em_address, instructions, mipsBytes, &unoptimized);
+		background = !unoptimized.empty();
+	} else {
+		frontend_.DoJit(em_address, instructions, mipsBytes);
+	}
 	_dbg_assert_(!instructions.empty());
 
-	int block_num = blocks_.AllocateBlock(em_address, mipsBytes, instructions);
+	// Native code for the unoptimized block would be thrown away soon, so the backends interpret it instead.
+	int block_num = background && compileToNative_ ? blocks_.AllocateInterpretedBlock(em_address, mipsBytes, instructions) : blocks_.AllocateBlock(em_address, mipsBytes, instructions);
 	if ((block_num & ~MIPS_EMUHACK_VALUE_MASK) != 0) {
 		WARN_LOG(Log::JIT, "Failed to allocate block for %08x (%d instructions)", em_address, (int)instructions.size());
 		// Out of block numbers.  Caller will handle.
@@ -147,10 +315,12 @@ bool IRJit::CompileBlock(u32 em_address, std::vector<IRInst> &instructions, u32
 	}
 
 	IRBlock *b = blocks_.GetBlock(block_num);
-	if (mipsTracer.tracing_enabled) {
+	// Unoptimized blocks shouldn't end up in the disk cache, the background result gets the hash instead.
+	if (mipsTracer.tracing_enabled || (diskCacheUsable && !background)) {
 		// Hash, then only update page stats, don't link yet.
 		// TODO: Should we always hash?  Then we can reuse blocks.
 		b->UpdateHash();
+		b->SetDiskCacheFlags(diskCacheFlags);
 	}
 
 	if (!CompileNativeBlock(&blocks_, block_num))
@@ -163,6 +333,10 @@ bool IRJit::CompileBlock(u32 em_address, std::vector<IRInst> &instructions, u32
 	// Updates stats, also patches the first MIPS instruction into an emuhack if 'preload == false'
 	blocks_.FinalizeBlock(block_num);
 	FinalizeNativeBlock(&blocks_, block_num);
+
+	if (background) {
+		QueueBackgroundCompile(IRBackgroundBlock{ em_address, mipsBytes, block_num, backgroundGeneration_, diskCacheFlags, std::move(unoptimized) });
+	}
 	return true;
 }
 
@@ -180,6 +354,9 @@ void IRJit::RunLoopUntil(u64 globalticks) {
 		if (coreState != 0) {
 			break;
 		}
+		if (backgroundReady_) {
+			PublishBackgroundBlocks();
+		}
 
 #ifdef _DEBUG
 		compilerEnabled_ = false;
@@ -213,6 +390,9 @@ void IRJit::RunLoopUntil(u64 globalticks) {
 					Core_ExecException(mips->pc, block->GetOriginalStart(), ExecExceptionType::JUMP);
 					break;
 				}
+				if (profileExits_ && blocks_.CountExit(offset, mips->pc)) {
+					FormSuperblock(offset, mips->pc);
+				}
 			} else {
 				// RestoreRoundingMode(true);
 #ifdef _DEBUG
@@ -255,13 +435,16 @@ void IRBlockCache::Clear() {
 	byPage_.clear();
 	arena_.clear();
 	arena_.shrink_to_fit();
+	// Arena offsets get reused.
+	memset(exitCounts_, 0, sizeof(exitCounts_));
 }
 
 IRBlockCache::IRBlockCache(bool compileToNative) : compileToNative_(compileToNative) {}
 
+// We have 24 bits to represent offsets with.
+static const u32 MAX_ARENA_SIZE = 0x1000000 - 1;
+
 int IRBlockCache::AllocateBlock(int emAddr, u32 origSize, const std::vector<IRInst> &insts) {
-	// We have 24 bits to represent offsets with.
-	const u32 MAX_ARENA_SIZE = 0x1000000 - 1;
 	int offset = (int)arena_.size();
 	if (offset >= MAX_ARENA_SIZE) {
 		WARN_LOG(Log::JIT, "Filled JIT arena, restarting");
@@ -276,6 +459,21 @@ int IRBlockCache::AllocateBlock(int emAddr, u32 origSize, const std::vector<IRIn
 	return newBlockIndex;
 }
 
+int IRBlockCache::AllocateInterpretedBlock(int emAddr, u32 origSize, const std::vector<IRInst> &insts) {
+	int offset = (int)arena_.size();
+	if (offset >= MAX_ARENA_SIZE) {
+		WARN_LOG(Log::JIT, "Filled JIT arena, restarting");
+		return -1;
+	}
+	// The block itself is only the first op. Linked native exits don't set the PC, so set it first.
+	arena_.push_back(IRInst{ IROp::InterpretBlock, { 0 }, 0, 0, (u32)offset + 1 });
+	arena_.push_back(IRInst{ IROp::SetPCConst, { 0 }, 0, 0, (u32)emAddr });
+	arena_.insert(arena_.end(), insts.begin(), insts.end());
+	int newBlockIndex = (int)blocks_.size();
+	blocks_.push_back(IRBlock(emAddr, origSize, offset, 1));
+	return newBlockIndex;
+}
+
 int IRBlockCache::GetBlockNumFromIRArenaOffset(int offset) const {
 	// Block offsets are always in rising order (we don't go back and replace them when invalidated). So we can binary search.
 	int low = 0;
@@ -574,21 +772,25 @@ void IRBlock::Destroy(int cookie) {
 
 u64 IRBlock::CalculateHash() const {
 	if (origAddr_) {
-		// This is unfortunate. In case there are emuhacks, we have to make a copy.
-		// If we could hash while reading we could avoid this.
-		std::vector<u32> buffer;
-		buffer.resize(origSize_ / 4);
-		size_t pos = 0;
-		for (u32 off = 0; off < origSize_; off += 4) {
-			// Let's actually hash the replacement, if any.
-			MIPSOpcode instr = Memory::ReadUnchecked_Instruction(origAddr_ + off, false);
-			buffer[pos++] = instr.encoding;
-		}
-		return XXH3_64bits(&buffer[0], origSize_);
+		return HashRange(origAddr_, origSize_);
 	}
 	return 0;
 }
 
+u64 IRBlock::HashRange(u32 addr, u32 size) {
+	// This is unfortunate. In case there are emuhacks, we have to make a copy.
+	// If we could hash while reading we could avoid this.
+	std::vector<u32> buffer;
+	buffer.resize(size / 4);
+	size_t pos = 0;
+	for (u32 off = 0; off < size; off += 4) {
+		// Let's actually hash the replacement, if any.
+		MIPSOpcode instr = Memory::ReadUnchecked_Instruction(addr + off, false);
+		buffer[pos++] = instr.encoding;
+	}
+	return XXH3_64bits(&buffer[0], size);
+}
+
 bool IRBlock::OverlapsRange(u32 addr, u32 size) const {
 	addr &= 0x3FFFFFFF;
 	u32 origAddr = origAddr_ & 0x3FFFFFFF;
@@ -17,7 +17,10 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <cstring>
+#include <mutex>
 #include <unordered_map>
 
 #include "Common/CommonTypes.h"
@@ -60,6 +63,7 @@ class IRBlock {
 		origFirstOpcode_ = b.origFirstOpcode_;
 		nativeOffset_ = b.nativeOffset_;
 		numIRInstructions_ = b.numIRInstructions_;
+		diskCacheFlags_ = b.diskCacheFlags_;
 		b.arenaOffset_ = 0xFFFFFFFF;
 	}
 
@@ -95,6 +99,15 @@ class IRBlock {
 	u64 GetHash() const {
 		return hash_;
 	}
+	void SetDiskCacheFlags(u32 flags) {
+		diskCacheFlags_ = flags;
+	}
+	u32 GetDiskCacheFlags() const {
+		return diskCacheFlags_;
+	}
+
+	// Hashes MIPS code the same way blocks do, ignoring our emuhacks.
+	static u64 HashRange(u32 addr, u32 size);
 
 	void Finalize(int number);
 	void Destroy(int number);
@@ -115,6 +128,8 @@ class IRBlock {
 	u32 origSize_ = 0;
 	MIPSOpcode origFirstOpcode_ = MIPSOpcode(0x68FFFFFF);
 	u32 numIRInstructions_ = 0;
+	// Frontend state this was compiled with, see IRDiskCacheFlags.
+	u32 diskCacheFlags_ = 0;
 };
 
 class IRBlockCache : public JitBlockCacheDebugInterface {
@@ -129,6 +144,8 @@ class IRBlockCache : public JitBlockCacheDebugInterface {
 	void FinalizeBlock(int blockNum);
 	int GetNumBlocks() const override { return (int)blocks_.size(); }
 	int AllocateBlock(int emAddr, u32 origSize, const std::vector<IRInst> &inst);
+	// For the native backends: a block that's just an InterpretBlock op, with the IR it runs after it.
+	int AllocateInterpretedBlock(int emAddr, u32 origSize, const std::vector<IRInst> &inst);
 	IRBlock *GetBlock(int blockNum) {
 		if (blockNum >= 0 && blockNum < (int)blocks_.size()) {
 			return &blocks_[blockNum];
@@ -163,6 +180,15 @@ class IRBlockCache : public JitBlockCacheDebugInterface {
 
 	int FindPreloadBlock(u32 em_address);
 
+	// Counts dispatches from the block at an arena offset to a target address, for superblock
+	// formation. Returns true once, when the exit becomes hot (collisions can hide some exits.)
+	bool CountExit(u32 offset, u32 target) {
+		u16 &count = exitCounts_[((offset ^ (target >> 2)) * 0x9E3779B1) >> (32 - EXIT_COUNT_BITS)];
+		if (count >= HOT_EXIT_COUNT)
+			return false;
+		return ++count == HOT_EXIT_COUNT;
+	}
+
 	// "Cookie" means the 24 bits we inject into the first instruction of each block.
 	int FindByCookie(int cookie);
 
@@ -197,11 +223,27 @@ class IRBlockCache : public JitBlockCacheDebugInterface {
 	}
 
 private:
+	enum {
+		EXIT_COUNT_BITS = 12,
+		HOT_EXIT_COUNT = 500,
+	};
+
 	u32 AddressToPage(u32 addr) const;
 	bool compileToNative_;
 	std::vector<IRBlock> blocks_;
 	std::vector<IRInst> arena_;
 	std::unordered_map<u32, std::vector<int>> byPage_;
+	u16 exitCounts_[1 << EXIT_COUNT_BITS]{};
+};
+
+// A block that was compiled with minimal passes, waiting for the rest on a worker thread.
+struct IRBackgroundBlock {
+	u32 emAddr;
+	u32 mipsBytes;
+	int blockNum;
+	int generation;
+	u32 diskCacheFlags;
+	std::vector<IRInst> instructions;
 };
 
 class IRJit : public JitInterface {
@@ -243,8 +285,17 @@ class IRJit : public JitInterface {
 	// This gets overridden by the native-backed IR jits.
 	const u8 *GetCodeBase() const override { return nullptr; }
 
+	// Called by the native backends for InterpretBlock. Returns the new PC.
+	u32 RunInterpretedBlock(u32 irOffset);
+
 protected:
 	bool CompileBlock(u32 em_address, std::vector<IRInst> &instructions, u32 &mipsBytes);
+	void SaveBlocksToDiskCache();
+	void FormSuperblock(u32 offset, u32 target);
+	void QueueBackgroundCompile(IRBackgroundBlock &&block);
+	void FinishBackgroundCompile(IRBackgroundBlock &&block);
+	void PublishBackgroundBlocks();
+	void WaitForBackgroundCompiles();
 	virtual bool CompileNativeBlock(IRBlockCache *irBlockCache, int block_num) { return true; }
 	virtual void FinalizeNativeBlock(IRBlockCache *irBlockCache, int block_num) {}
 
@@ -258,6 +309,20 @@ class IRJit : public JitInterface {
 	MIPSState *mips_;
 
 	bool compilerEnabled_ = true;
+	bool useDiskCache_ = false;
+	bool profileExits_ = false;
+
+	// Background compile tier. The interpreter runs the unoptimized block meanwhile, and the native
+	// backends interpret it too (InterpretBlock) so only the optimized block gets native code.
+	bool backgroundCompile_ = false;
+	int backgroundGeneration_ = 0;
+	std::mutex backgroundLock_;
+	std::condition_variable backgroundCond_;
+	int backgroundPending_ = 0;
+	std::vector<IRBackgroundBlock> backgroundDone_;
+	std::atomic<bool> backgroundReady_{};
+
+	friend class IRBackgroundCompileTask;
 
 	// where to write branch-likely trampolines. not used atm
 	// u32 blTrampolines_;
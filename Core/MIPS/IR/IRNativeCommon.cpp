@@ -164,6 +164,12 @@ uint32_t IRNativeBackend::DoIRInst(uint64_t value) {
 	return IRInterpret(currentMIPS, &inst[0]);
 }
 
+uint32_t IRNativeBackend::DoInterpretBlock(IRJit *jit, uint32_t irOffset) {
+	if constexpr (enableDebugStats)
+		debugSeenNotCompiledIR[(uint8_t)IROp::InterpretBlock]++;
+	return jit->RunInterpretedBlock(irOffset);
+}
+
 int IRNativeBackend::ReportBadAddress(uint32_t addr, uint32_t alignment, uint32_t isWrite) {
 	const auto toss = [&](MemoryExceptionType t) {
 		Core_MemoryException(addr, alignment, currentMIPS->pc, t);
@@ -439,6 +445,10 @@ void IRNativeBackend::CompileIRInst(IRInst inst) {
 		CompIR_Interpret(inst);
 		break;
 
+	case IROp::InterpretBlock:
+		CompIR_Generic(inst);
+		break;
+
 	case IROp::Syscall:
 	case IROp::SyscallUnresolved:
 	case IROp::CallReplacement:
@@ -487,6 +497,7 @@ IRNativeJit::IRNativeJit(MIPSState *mipsState)
 
 void IRNativeJit::Init(IRNativeBackend &backend) {
 	backend_ = &backend;
+	backend_->SetJit(this);
 	debugInterface_.Init(backend_);
 	backend_->GenerateFixedCode(mips_);
 
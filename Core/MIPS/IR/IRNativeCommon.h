@@ -83,6 +83,11 @@ class IRNativeBackend {
 		return hooks_;
 	}
 
+	// InterpretBlock ops run IR from this jit's arena.
+	void SetJit(IRJit *jit) {
+		jit_ = jit;
+	}
+
 	const IRNativeBlock *GetNativeBlock(int block_num) const;
 	void SetBlockCheckedOffset(int block_num, int offset);
 
@@ -148,12 +153,16 @@ class IRNativeBackend {
 	// Callback to log AND perform an IR interpreter inst.  Returns 0 or a PC to jump to.
 	static uint32_t DoIRInst(uint64_t inst);
 
+	// Callback to run an InterpretBlock's IR at irOffset in jit's arena.  Returns the new PC.
+	static uint32_t DoInterpretBlock(IRJit *jit, uint32_t irOffset);
+
 	static int ReportBadAddress(uint32_t addr, uint32_t alignment, uint32_t isWrite);
 
 	void AddLinkableExit(int block_num, uint32_t pc, int exitStartOffset, int exitLen);
 	void EraseAllLinks(int block_num);
 
 	IRNativeHooks hooks_;
+	IRJit *jit_ = nullptr;
 	IRBlockCache &blocks_;
 	std::vector<IRNativeBlock> nativeBlocks_;
 	std::unordered_multimap<uint32_t, int> linksTo_;
@@ -0,0 +1,175 @@
+// Copyright (c) 2026- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+#include <cstring>
+
+#include "Core/MIPS/IR/IRAnalysis.h"
+#include "Core/MIPS/IR/IRRegAlloc.h"
+
+// Enough for a V destination plus two V sources and a V src3, and some GPRs.
+static const int MAX_USES_PER_INST = 32;
+
+static int CollectUses(const IRInst &inst, int keys[MAX_USES_PER_INST], bool reads[MAX_USES_PER_INST]) {
+	const IRInstMeta meta = GetIRMeta(inst);
+	int c = 0;
+
+	IRReg regs[16];
+	// These return -1 for ops that flush everything, which we treat as no direct uses.
+	int n = IRReadsFromGPRs(meta, regs);
+	for (int i = 0; i < n; ++i) {
+		keys[c] = regs[i];
+		reads[c++] = true;
+	}
+	n = IRReadsFromFPRs(meta, regs);
+	for (int i = 0; i < n; ++i) {
+		keys[c] = 256 + regs[i];
+		reads[c++] = true;
+	}
+
+	int dest = IRDestGPR(meta);
+	if (dest != -1) {
+		keys[c] = dest;
+		reads[c++] = false;
+	}
+	n = IRDestFPRs(meta, regs);
+	for (int i = 0; i < n; ++i) {
+		keys[c] = 256 + regs[i];
+		reads[c++] = false;
+	}
+	return c;
+}
+
+void IRRegAllocHints::Clear() {
+	valid_ = false;
+	memset(resident_, 0, sizeof(resident_));
+	memset(readStart_, 0, sizeof(readStart_));
+	memset(readCount_, 0, sizeof(readCount_));
+	readPositions_.clear();
+}
+
+void IRRegAllocHints::Compute(const IRInst *instructions, int count, int numGPRs, int numFPRs) {
+	Clear();
+
+	int first[NUM_KEYS];
+	int last[NUM_KEYS];
+	int uses[NUM_KEYS]{};
+	for (int i = 0; i < NUM_KEYS; ++i) {
+		first[i] = -1;
+		last[i] = -1;
+	}
+
+	int keys[MAX_USES_PER_INST];
+	bool reads[MAX_USES_PER_INST];
+	for (int i = 0; i < count; ++i) {
+		int n = CollectUses(instructions[i], keys, reads);
+		for (int j = 0; j < n; ++j) {
+			int k = keys[j];
+			if (first[k] == -1)
+				first[k] = i;
+			last[k] = i;
+			uses[k]++;
+			if (reads[j])
+				readCount_[k]++;
+		}
+	}
+
+	// Lay out the read positions for each reg after each other, in instruction order.
+	int total = 0;
+	for (int k = 0; k < NUM_KEYS; ++k) {
+		readStart_[k] = total;
+		total += readCount_[k];
+	}
+	readPositions_.resize(total);
+	int filled[NUM_KEYS]{};
+	for (int i = 0; i < count; ++i) {
+		int n = CollectUses(instructions[i], keys, reads);
+		for (int j = 0; j < n; ++j) {
+			int k = keys[j];
+			if (!reads[j])
+				continue;
+			// The same reg can be read twice by one instruction.
+			if (filled[k] != 0 && readPositions_[readStart_[k] + filled[k] - 1] == i) {
+				readCount_[k]--;
+				continue;
+			}
+			readPositions_[readStart_[k] + filled[k]++] = i;
+		}
+	}
+
+	std::vector<Interval> gprs;
+	std::vector<Interval> fprs;
+	for (int k = 0; k < NUM_KEYS; ++k) {
+		if (first[k] == -1)
+			continue;
+		if (k < 256)
+			gprs.push_back(Interval{ first[k], last[k], uses[k], k });
+		else
+			fprs.push_back(Interval{ first[k], last[k], uses[k], k });
+	}
+	Scan(gprs, numGPRs);
+	Scan(fprs, numFPRs);
+
+	valid_ = true;
+}
+
+// Uses per instruction covered.  Compares a < b without dividing.
+static bool LessDense(int aUses, int aLength, int bUses, int bLength) {
+	return (int64_t)aUses * bLength < (int64_t)bUses * aLength;
+}
+
+void IRRegAllocHints::Scan(std::vector<Interval> &intervals, int numRegs) {
+	if (numRegs <= 0)
+		return;
+
+	std::sort(intervals.begin(), intervals.end(), [](const Interval &a, const Interval &b) {
+		return a.start < b.start;
+	});
+
+	std::vector<const Interval *> active;
+	active.reserve(numRegs);
+	for (const Interval &cur : intervals) {
+		active.erase(std::remove_if(active.begin(), active.end(), [&](const Interval *a) {
+			return a->end < cur.start;
+		}), active.end());
+
+		if ((int)active.size() < numRegs) {
+			active.push_back(&cur);
+			resident_[cur.key] = true;
+			continue;
+		}
+
+		// No room, so the least densely used interval loses its register.
+		auto weakest = std::min_element(active.begin(), active.end(), [](const Interval *a, const Interval *b) {
+			return LessDense(a->uses, a->end - a->start + 1, b->uses, b->end - b->start + 1);
+		});
+		const Interval *w = *weakest;
+		if (LessDense(w->uses, w->end - w->start + 1, cur.uses, cur.end - cur.start + 1)) {
+			resident_[w->key] = false;
+			resident_[cur.key] = true;
+			*weakest = &cur;
+		}
+	}
+}
+
+int IRRegAllocHints::NextRead(IRReg r, bool fpr, int index) const {
+	int k = Key(r, fpr);
+	const int *begin = readPositions_.data() + readStart_[k];
+	const int *end = begin + readCount_[k];
+	const int *it = std::lower_bound(begin, end, index);
+	return it == end ? NO_READ : *it;
+}
@@ -0,0 +1,68 @@
+// Copyright (c) 2026- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Core/MIPS/IR/IRInst.h"
+
+// Block-wide allocation hints for the native reg caches. We run a linear scan over the live
+// intervals of every IR reg in the block, weighted by how often each is used. The reg cache
+// still maps greedily, but uses these to decide what to spill: regs that lost out in the scan
+// go first, and otherwise the one read furthest away.
+class IRRegAllocHints {
+public:
+	// numGPRs and numFPRs are the number of native regs the backend can allocate for each.
+	void Compute(const IRInst *instructions, int count, int numGPRs, int numFPRs);
+	void Clear();
+
+	bool IsValid() const {
+		return valid_;
+	}
+
+	// Index of the next instruction at or after index that reads the reg, or NO_READ.
+	int NextRead(IRReg r, bool fpr, int index) const;
+	// Whether the scan kept the reg in a native reg for its whole interval.
+	bool IsResident(IRReg r, bool fpr) const {
+		return resident_[Key(r, fpr)];
+	}
+
+	static constexpr int NO_READ = 0x7FFFFFFF;
+
+private:
+	static constexpr int NUM_KEYS = 512;
+
+	struct Interval {
+		int start;
+		int end;
+		int uses;
+		int key;
+	};
+
+	static int Key(IRReg r, bool fpr) {
+		return fpr ? 256 + r : r;
+	}
+	void Scan(std::vector<Interval> &intervals, int numRegs);
+
+	bool valid_ = false;
+	bool resident_[NUM_KEYS]{};
+	int readStart_[NUM_KEYS]{};
+	int readCount_[NUM_KEYS]{};
+	std::vector<int> readPositions_;
+};
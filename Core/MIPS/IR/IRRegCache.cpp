@@ -132,6 +132,15 @@ void IRNativeRegCacheBase::Start(MIPSComp::IRBlockCache *irBlockCache, int block
 	irBlockNum_ = blockNum;
 	irBlockCache_ = irBlockCache;
 	irIndex_ = 0;
+
+	if (!jo_->Disabled(MIPSComp::JitDisable::REGALLOC_HINTS)) {
+		int numGPRs = 0, numFPRs = 0, base = 0;
+		GetAllocationOrder(MIPSLoc::REG, MIPSMap::INIT, numGPRs, base);
+		GetAllocationOrder(MIPSLoc::FREG, MIPSMap::INIT, numFPRs, base);
+		hints_.Compute(irBlockCache->GetBlockInstructionPtr(blockNum), irBlock_->GetNumIRInstructions(), numGPRs, numFPRs);
+	} else {
+		hints_.Clear();
+	}
 }
 
 void IRNativeRegCacheBase::SetupInitialRegs() {
@@ -481,6 +490,8 @@ IRNativeReg IRNativeRegCacheBase::FindBestToSpill(MIPSLoc type, MIPSMap flags, b
 	info.numInstructions = irBlock_->GetNumIRInstructions();
 
 	*clobbered = false;
+	IRNativeReg best = -1;
+	int bestScore = -1;
 	for (int i = 0; i < allocCount; i++) {
 		IRNativeReg nreg = IRNativeReg(allocOrder[i] - base);
 		if (nr[nreg].mipsReg != IRREG_INVALID && mr[nr[nreg].mipsReg].spillLockIRIndex >= irIndex_)
@@ -509,14 +520,44 @@ IRNativeReg IRNativeRegCacheBase::FindBestToSpill(MIPSLoc type, MIPSMap flags, b
 
 		// Not awesome.  A used reg.  Let's try to avoid spilling.
 		if (!unusedOnly || usage == IRUsage::UNUSED) {
-			// TODO: Use age or something to choose which register to spill?
-			// TODO: Spill dirty regs first? or opposite?
-			*clobbered = mipsReg == MIPS_REG_ZERO;
-			return nreg;
+			if (!hints_.IsValid()) {
+				// TODO: Spill dirty regs first? or opposite?
+				*clobbered = mipsReg == MIPS_REG_ZERO;
+				return nreg;
+			}
+
+			int score = SpillScore(type, nreg);
+			if (score > bestScore) {
+				best = nreg;
+				bestScore = score;
+			}
 		}
 	}
 
-	return -1;
+	if (best != -1)
+		*clobbered = nr[best].mipsReg == MIPS_REG_ZERO;
+	return best;
+}
+
+int IRNativeRegCacheBase::SpillScore(MIPSLoc type, IRNativeReg nreg) const {
+	IRReg first = nr[nreg].mipsReg;
+	if (first == IRREG_INVALID)
+		return 0x7FFFFFFF;
+
+	// Prefer regs the allocation hints didn't keep, then the one read furthest away.
+	bool fpr = type == MIPSLoc::FREG || type == MIPSLoc::VREG;
+	const int MAX_DISTANCE = 0x3FFF;
+	int distance = MAX_DISTANCE;
+	bool resident = false;
+	for (IRReg m = first; m < IRREG_INVALID && (m == first || mr[m].nReg == nreg); ++m) {
+		// mr has the FPRs after the 32 GPRs, but the hints use the IR's own numbering.
+		IRReg r = fpr ? m - 32 : m;
+		int next = hints_.NextRead(r, fpr, irIndex_);
+		if (next != IRRegAllocHints::NO_READ)
+			distance = std::min(distance, next - irIndex_);
+		resident = resident || hints_.IsResident(r, fpr);
+	}
+	return (resident ? 0 : MAX_DISTANCE + 1) + distance;
 }
 
 bool IRNativeRegCacheBase::IsNativeRegCompatible(IRNativeReg nreg, MIPSLoc type, MIPSMap flags, int lanes) {
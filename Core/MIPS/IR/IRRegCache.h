@@ -23,6 +23,7 @@
 #include "Common/CommonTypes.h"
 #include "Core/MIPS/MIPS.h"
 #include "Core/MIPS/IR/IRAnalysis.h"
+#include "Core/MIPS/IR/IRRegAlloc.h"
 
 
 // Have to account for all of them due to temps, etc.
@@ -211,6 +212,7 @@ class IRNativeRegCacheBase {
 	IRNativeReg AllocateReg(MIPSLoc type, MIPSMap flags);
 	IRNativeReg FindFreeReg(MIPSLoc type, MIPSMap flags) const;
 	IRNativeReg FindBestToSpill(MIPSLoc type, MIPSMap flags, bool unusedOnly, bool *clobbered) const;
+	int SpillScore(MIPSLoc type, IRNativeReg nreg) const;
 	virtual bool IsNativeRegCompatible(IRNativeReg nreg, MIPSLoc type, MIPSMap flags, int lanes);
 	virtual void DiscardNativeReg(IRNativeReg nreg);
 	virtual void FlushNativeReg(IRNativeReg nreg);
@@ -267,4 +269,6 @@ class IRNativeRegCacheBase {
 	RegStatusMIPS mrInitial_[TOTAL_MAPPABLE_IRREGS];
 
 	bool initialReady_ = false;
+
+	IRRegAllocHints hints_;
 };
@@ -226,10 +226,18 @@ void LoongArch64JitBackend::CompIR_Generic(IRInst inst) {
 	memcpy(&value, &inst, sizeof(inst));
 
 	FlushAll();
-	LI(R4, value);
+	if (inst.op == IROp::InterpretBlock) {
+		LI(R4, jit_);
+		LI(R5, inst.constant);
+	} else {
+		LI(R4, value);
+	}
 	SaveStaticRegisters();
 	WriteDebugProfilerStatus(IRProfilerStatus::IR_INTERPRET);
-	QuickCallFunction(&DoIRInst, SCRATCH2);
+	if (inst.op == IROp::InterpretBlock)
+		QuickCallFunction(&DoInterpretBlock, SCRATCH2);
+	else
+		QuickCallFunction(&DoIRInst, SCRATCH2);
 	WriteDebugProfilerStatus(IRProfilerStatus::IN_JIT);
 	LoadStaticRegisters();
 
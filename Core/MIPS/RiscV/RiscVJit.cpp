@@ -227,10 +227,18 @@ void RiscVJitBackend::CompIR_Generic(IRInst inst) {
 	memcpy(&value, &inst, sizeof(inst));
 
 	FlushAll();
-	LI(X10, value, SCRATCH2);
+	if (inst.op == IROp::InterpretBlock) {
+		LI(X10, jit_, SCRATCH2);
+		LI(X11, inst.constant);
+	} else {
+		LI(X10, value, SCRATCH2);
+	}
 	SaveStaticRegisters();
 	WriteDebugProfilerStatus(IRProfilerStatus::IR_INTERPRET);
-	QuickCallFunction(&DoIRInst, SCRATCH2);
+	if (inst.op == IROp::InterpretBlock)
+		QuickCallFunction(&DoInterpretBlock, SCRATCH2);
+	else
+		QuickCallFunction(&DoIRInst, SCRATCH2);
 	WriteDebugProfilerStatus(IRProfilerStatus::IN_JIT);
 	LoadStaticRegisters();
 
@@ -229,11 +229,15 @@ void X64JitBackend::CompIR_Generic(IRInst inst) {
 	FlushAll();
 	SaveStaticRegisters();
 	WriteDebugProfilerStatus(IRProfilerStatus::IR_INTERPRET);
+	if (inst.op == IROp::InterpretBlock) {
+		ABI_CallFunctionPA((const void *)&DoInterpretBlock, jit_, Imm32(inst.constant));
+	} else {
 #if PPSSPP_ARCH(AMD64)
-	ABI_CallFunctionP((const void *)&DoIRInst, (void *)value);
+		ABI_CallFunctionP((const void *)&DoIRInst, (void *)value);
 #else
-	ABI_CallFunctionCC((const void *)&DoIRInst, (u32)(value & 0xFFFFFFFF), (u32)(value >> 32));
+		ABI_CallFunctionCC((const void *)&DoIRInst, (u32)(value & 0xFFFFFFFF), (u32)(value >> 32));
 #endif
+	}
 	WriteDebugProfilerStatus(IRProfilerStatus::IN_JIT);
 	LoadStaticRegisters();
 
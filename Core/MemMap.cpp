@@ -381,8 +381,171 @@ static void DoMemoryVoid(PointerWrap &p, uint32_t start, uint32_t size) {
 	storage += size;
 }
 
+// Incremental savestates compare against the reference in pages of this size.
+static const u32 INCREMENTAL_PAGE_SIZE = 4096;
+
+// RAM followed by VRAM. Page numbers used with the reference count through both the same way.
+static std::vector<u8> g_incrementalRef;
+// Stored in incremental states, so we can tell whether they were made against the current contents.
+// Never reused, so a stale state can't match by accident.
+static u64 g_incrementalRefId;
+static u64 g_nextIncrementalRefId = 1;
+
+struct IncrementalRegion {
+	// Pages that differ from the reference, kept for the next save so its measure and write passes
+	// don't have to compare again. Set by capturing or updating the reference, or by MODE_MEASURE.
+	std::vector<u32> dirty;
+	bool measured = false;
+};
+static IncrementalRegion g_incrementalRegions[2];
+
+static bool IncrementalReferenceValid() {
+	return g_incrementalRef.size() == (size_t)g_MemorySize + VRAM_SIZE;
+}
+
+static u8 *IncrementalPagePtr(u32 page) {
+	const u32 ramPages = g_MemorySize / INCREMENTAL_PAGE_SIZE;
+	if (page < ramPages)
+		return GetPointerWriteOrException(PSP_GetKernelMemoryBase()) + page * INCREMENTAL_PAGE_SIZE;
+	return GetPointerWriteOrException(PSP_GetVidMemBase()) + (page - ramPages) * INCREMENTAL_PAGE_SIZE;
+}
+
+static void FindDirtyPages(std::vector<u32> &dirty, const u8 *d, const u8 *ref, u32 numPages, u32 firstPage) {
+	std::vector<u8> flags(numPages);
+	ParallelRangeLoop(&g_threadManager, [&](int l, int h) {
+		for (int i = l; i < h; i++)
+			flags[i] = memcmp(d + i * INCREMENTAL_PAGE_SIZE, ref + i * INCREMENTAL_PAGE_SIZE, INCREMENTAL_PAGE_SIZE) != 0;
+	}, 0, numPages, 64);
+
+	for (u32 i = 0; i < numPages; i++) {
+		if (flags[i])
+			dirty.push_back(firstPage + i);
+	}
+}
+
+// The reference was just made to match memory, so no pages differ.
+static void MarkIncrementalRegionsClean() {
+	for (auto &region : g_incrementalRegions) {
+		region.dirty.clear();
+		region.measured = true;
+	}
+}
+
+void CaptureIncrementalReference() {
+	g_incrementalRef.resize(g_MemorySize + VRAM_SIZE);
+	ParallelMemcpy(&g_threadManager, &g_incrementalRef[0], GetPointerWriteOrException(PSP_GetKernelMemoryBase()), g_MemorySize);
+	ParallelMemcpy(&g_threadManager, &g_incrementalRef[g_MemorySize], GetPointerWriteOrException(PSP_GetVidMemBase()), VRAM_SIZE);
+	g_incrementalRefId = g_nextIncrementalRefId++;
+	MarkIncrementalRegionsClean();
+}
+
+bool UpdateIncrementalReference(std::vector<u32> *pages, std::vector<u8> *oldData) {
+	pages->clear();
+	oldData->clear();
+	if (!IncrementalReferenceValid())
+		return false;
+
+	FindDirtyPages(*pages, GetPointerWriteOrException(PSP_GetKernelMemoryBase()), &g_incrementalRef[0], g_MemorySize / INCREMENTAL_PAGE_SIZE, 0);
+	FindDirtyPages(*pages, GetPointerWriteOrException(PSP_GetVidMemBase()), &g_incrementalRef[g_MemorySize], VRAM_SIZE / INCREMENTAL_PAGE_SIZE, g_MemorySize / INCREMENTAL_PAGE_SIZE);
+
+	oldData->resize(pages->size() * INCREMENTAL_PAGE_SIZE);
+	ParallelRangeLoop(&g_threadManager, [&](int l, int h) {
+		for (int i = l; i < h; i++) {
+			u8 *refPage = &g_incrementalRef[(size_t)(*pages)[i] * INCREMENTAL_PAGE_SIZE];
+			memcpy(&(*oldData)[(size_t)i * INCREMENTAL_PAGE_SIZE], refPage, INCREMENTAL_PAGE_SIZE);
+			memcpy(refPage, IncrementalPagePtr((*pages)[i]), INCREMENTAL_PAGE_SIZE);
+		}
+	}, 0, (int)pages->size(), 16);
+
+	g_incrementalRefId = g_nextIncrementalRefId++;
+	MarkIncrementalRegionsClean();
+	return true;
+}
+
+bool RevertIncrementalReference(const std::vector<u32> &pages, const u8 *oldData, size_t size, u64 id) {
+	if (!IncrementalReferenceValid() || size != pages.size() * INCREMENTAL_PAGE_SIZE)
+		return false;
+	const u32 numPages = (u32)(g_incrementalRef.size() / INCREMENTAL_PAGE_SIZE);
+	for (u32 page : pages) {
+		if (page >= numPages)
+			return false;
+	}
+
+	for (size_t i = 0; i < pages.size(); i++)
+		memcpy(&g_incrementalRef[(size_t)pages[i] * INCREMENTAL_PAGE_SIZE], oldData + i * INCREMENTAL_PAGE_SIZE, INCREMENTAL_PAGE_SIZE);
+	g_incrementalRefId = id;
+	for (auto &region : g_incrementalRegions)
+		region.measured = false;
+	return true;
+}
+
+void ClearIncrementalReference() {
+	g_incrementalRef.clear();
+	g_incrementalRef.shrink_to_fit();
+	g_incrementalRefId = 0;
+	for (auto &region : g_incrementalRegions) {
+		region.dirty.clear();
+		region.measured = false;
+	}
+}
+
+bool HasIncrementalReference() {
+	return !g_incrementalRef.empty();
+}
+
+u64 GetIncrementalReferenceId() {
+	return g_incrementalRefId;
+}
+
+// Like DoMemoryVoid, but only the pages that differ from ref are stored.
+static void DoMemoryPages(PointerWrap &p, IncrementalRegion &region, uint32_t start, uint32_t size, const u8 *ref) {
+	uint8_t *d = GetPointerWriteOrException(start);
+	const u32 numPages = size / INCREMENTAL_PAGE_SIZE;
+
+	if ((p.mode == PointerWrap::MODE_MEASURE || p.mode == PointerWrap::MODE_WRITE) && !region.measured) {
+		region.dirty.clear();
+		FindDirtyPages(region.dirty, d, ref, numPages, 0);
+		region.measured = true;
+	}
+	// Only good for this save, memory will change before the next.
+	if (p.mode == PointerWrap::MODE_WRITE)
+		region.measured = false;
+
+	u32 count = (u32)region.dirty.size();
+	Do(p, count);
+	if (p.mode == PointerWrap::MODE_READ) {
+		if (count > numPages) {
+			ERROR_LOG(Log::SaveState, "Incremental savestate has too many pages (%d)", count);
+			p.SetError(PointerWrap::ERROR_FAILURE);
+			return;
+		}
+		region.dirty.resize(count);
+	}
+	if (count != 0)
+		DoArray(p, &region.dirty[0], count);
+
+	if (p.mode == PointerWrap::MODE_READ) {
+		// Validate before touching memory.
+		for (u32 page : region.dirty) {
+			if (page >= numPages) {
+				ERROR_LOG(Log::SaveState, "Incremental savestate has a bad page index (%d)", page);
+				p.SetError(PointerWrap::ERROR_FAILURE);
+				return;
+			}
+		}
+		ParallelMemcpy(&g_threadManager, d, ref, size);
+	}
+
+	for (u32 page : region.dirty)
+		p.DoVoid(d + page * INCREMENTAL_PAGE_SIZE, INCREMENTAL_PAGE_SIZE);
+
+	if (p.mode == PointerWrap::MODE_READ)
+		region.dirty.clear();
+}
+
 void DoState(PointerWrap &p) {
-	auto s = p.Section("Memory", 1, 3);
+	// Only incremental (rewind) states need version 4, so regular states stay loadable by older builds.
+	auto s = p.Section("Memory", 1, p.mode == PointerWrap::MODE_READ || p.incrementalMemory ? 4 : 3);
 	if (!s)
 		return;
 
@@ -413,11 +576,35 @@ void DoState(PointerWrap &p) {
 		}
 	}
 
-	DoMemoryVoid(p, PSP_GetKernelMemoryBase(), g_MemorySize);
-	p.DoMarker("RAM");
+	u8 incremental = 0;
+	u64 refId = g_incrementalRefId;
+	if (s >= 4) {
+		if (p.mode == PointerWrap::MODE_WRITE || p.mode == PointerWrap::MODE_MEASURE)
+			incremental = p.incrementalMemory && IncrementalReferenceValid();
+		Do(p, incremental);
+		if (incremental)
+			Do(p, refId);
+	}
+
+	if (incremental) {
+		if (p.mode == PointerWrap::MODE_READ && (!IncrementalReferenceValid() || refId != g_incrementalRefId)) {
+			ERROR_LOG(Log::SaveState, "Incremental savestate doesn't match the current reference, can't load it");
+			p.SetError(PointerWrap::ERROR_FAILURE);
+			return;
+		}
+
+		DoMemoryPages(p, g_incrementalRegions[0], PSP_GetKernelMemoryBase(), g_MemorySize, &g_incrementalRef[0]);
+		p.DoMarker("RAM");
 
-	DoMemoryVoid(p, PSP_GetVidMemBase(), VRAM_SIZE);
-	p.DoMarker("VRAM");
+		DoMemoryPages(p, g_incrementalRegions[1], PSP_GetVidMemBase(), VRAM_SIZE, &g_incrementalRef[g_MemorySize]);
+		p.DoMarker("VRAM");
+	} else {
+		DoMemoryVoid(p, PSP_GetKernelMemoryBase(), g_MemorySize);
+		p.DoMarker("RAM");
+
+		DoMemoryVoid(p, PSP_GetVidMemBase(), VRAM_SIZE);
+		p.DoMarker("VRAM");
+	}
 	DoArray(p, m_pPhysicalScratchPad, SCRATCHPAD_SIZE);
 	p.DoMarker("ScratchPad");
 }
@@ -425,6 +612,7 @@ void DoState(PointerWrap &p) {
 void Shutdown() {
 	CoreShutdownLock coreLock = Core_LockAgainstShutdown();
 	u32 flags = 0;
+	ClearIncrementalReference();
 	MemoryMap_Shutdown();
 	base = nullptr;
 	DEBUG_LOG(Log::MemMap, "Memory system shut down.");
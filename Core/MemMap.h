@@ -21,6 +21,7 @@
 
 #include <cstring>
 #include <cstdint>
+#include <vector>
 #ifndef offsetof
 #include <stddef.h>
 #endif
@@ -133,6 +134,19 @@ bool Init(MemMapSetupFlags flags);
 void Shutdown();
 void DoState(PointerWrap &p);
 
+// Incremental savestates. CaptureIncrementalReference() keeps a copy of RAM and VRAM, and states
+// saved with PointerWrap::incrementalMemory set then only contain the pages that differ from it.
+// Loading such a state requires the reference to still have the same contents (and ID.)
+void CaptureIncrementalReference();
+// Copies the pages that changed since into the reference. Their numbers (RAM first, then VRAM)
+// go in pages, and their previous contents in oldData. False if there's no usable reference.
+bool UpdateIncrementalReference(std::vector<u32> *pages, std::vector<u8> *oldData);
+// Undoes an UpdateIncrementalReference, given what it returned and the ID from before it.
+bool RevertIncrementalReference(const std::vector<u32> &pages, const u8 *oldData, size_t size, u64 id);
+void ClearIncrementalReference();
+bool HasIncrementalReference();
+u64 GetIncrementalReferenceId();
+
 // False when shutdown has already been called.
 bool IsActive();
 
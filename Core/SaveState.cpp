@@ -116,6 +116,50 @@ struct Operation {
 
 static std::vector<Operation> g_pendingOperations;
 
+// Saves are written in the background, but finishing them (renaming into place, config updates,
+// callbacks) happens back on the emu thread in Process, or before slot files are undone or deleted.
+struct FinishedSave {
+	Callback callback;
+	CChunkFileReader::Error error;
+	std::string slotPrefix;
+};
+
+static std::mutex g_finishedSavesMutex;
+static std::vector<FinishedSave> g_finishedSaves;
+// Held while finished saves are renamed into place, and while slot files are undone or deleted,
+// so that a save finishing later can't bring back or overwrite the files.
+static std::mutex g_slotFilesMutex;
+
+// Call with g_slotFilesMutex held.
+static void FinishSavesLocked() {
+	std::vector<FinishedSave> finished;
+	{
+		std::lock_guard<std::mutex> guard(g_finishedSavesMutex);
+		finished.swap(g_finishedSaves);
+	}
+
+	auto sc = GetI18NCategory(I18NCat::SCREEN);
+	for (const auto &save : finished) {
+		// The callbacks may enqueue more operations, so g_finishedSavesMutex isn't held here.
+		if (save.error == CChunkFileReader::ERROR_NONE)
+			save.callback(Status::SUCCESS, save.slotPrefix + std::string(sc->T("Saved State")), "");
+		else
+			save.callback(Status::FAILURE, sc->T("Failed to save state"), "");
+	}
+}
+
+static void FinishSaves() {
+	std::lock_guard<std::mutex> guard(g_slotFilesMutex);
+	FinishSavesLocked();
+}
+
+// Waits for the background writes, and then finishes them so the files are in place.
+static void FinishPendingSaves() {
+	std::lock_guard<std::mutex> guard(g_slotFilesMutex);
+	CChunkFileReader::WaitForPendingSaves();
+	FinishSavesLocked();
+}
+
 int g_screenshotFailures;
 
 	CChunkFileReader::Error SaveToRam(std::vector<u8> &data) {
@@ -123,6 +167,11 @@ int g_screenshotFailures;
 		return CChunkFileReader::MeasureAndSavePtr(state, &data);
 	}
 
+	CChunkFileReader::Error SaveToRamIncremental(std::vector<u8> &data) {
+		SaveStart state;
+		return CChunkFileReader::MeasureAndSavePtr(state, &data, true);
+	}
+
 	CChunkFileReader::Error LoadFromRam(std::vector<u8> &data, std::string *errorString) {
 		SaveStart state;
 		return CChunkFileReader::LoadPtr(&data[0], data.size(), state, errorString);
@@ -510,11 +559,8 @@ int g_screenshotFailures;
 		Rescan(gamePrefix);
 	}
 
-	bool UndoSaveSlot(std::string_view gamePrefix, int slot) {
-		if (!NetworkAllowSaveState()) {
-			return false;
-		}
-
+	// Call with g_slotFilesMutex held, and saves finished.
+	static bool UndoSaveSlotFiles(std::string_view gamePrefix, int slot) {
 		Path fnUndo = GenerateSaveSlotPath(gamePrefix, slot, UNDO_STATE_EXTENSION);
 
 		// Do nothing if there's no undo.
@@ -527,12 +573,28 @@ int g_screenshotFailures;
 			SwapIfExists(fnUndo, fn);
 			return true;
 		}
+		return false;
+	}
+
+	bool UndoSaveSlot(std::string_view gamePrefix, int slot) {
+		if (!NetworkAllowSaveState()) {
+			return false;
+		}
 
+		std::lock_guard<std::mutex> guard(g_slotFilesMutex);
+		CChunkFileReader::WaitForPendingSaves();
+		FinishSavesLocked();
+
+		bool retval = UndoSaveSlotFiles(gamePrefix, slot);
 		Rescan(gamePrefix);
-		return false;
+		return retval;
 	}
 
 	void DeleteSlot(std::string_view gamePrefix, int slot) {
+		std::lock_guard<std::mutex> guard(g_slotFilesMutex);
+		CChunkFileReader::WaitForPendingSaves();
+		FinishSavesLocked();
+
 		Path fn = GenerateSaveSlotPath(gamePrefix, slot, STATE_EXTENSION);
 		Path shot = GenerateSaveSlotPath(gamePrefix, slot, SCREENSHOT_EXTENSION);
 
@@ -548,10 +610,15 @@ int g_screenshotFailures;
 			return false;
 		}
 
+		std::lock_guard<std::mutex> guard(g_slotFilesMutex);
+		CChunkFileReader::WaitForPendingSaves();
+		// This may change the last save slot.
+		FinishSavesLocked();
+
 		if (g_Config.sStateUndoLastSaveGame != gamePrefix)
 			return false;
 
-		bool retval = UndoSaveSlot(gamePrefix, g_Config.iStateUndoLastSaveSlot);
+		bool retval = UndoSaveSlotFiles(gamePrefix, g_Config.iStateUndoLastSaveSlot);
 		Rescan(gamePrefix);
 		return retval;
 	}
@@ -796,6 +863,7 @@ int g_screenshotFailures;
 	// *must* not run further, in order not to disturb the current state operation.
 	void Process() {
 		rewindStates.Process();
+		FinishSaves();
 
 		if (!needsProcess)
 			return;
@@ -826,6 +894,8 @@ int g_screenshotFailures;
 			switch (op.type) {
 			case OperationType::Load:
 				INFO_LOG(Log::SaveState, "Loading state from '%s'", op.path.c_str());
+				// It might be a state we're still writing.
+				FinishPendingSaves();
 				// Use the state's latest version as a guess for saveStateInitialGitVersion.
 				result = CChunkFileReader::Load(op.path, &saveStateInitialGitVersion, state, &errorString);
 				if (result == CChunkFileReader::ERROR_NONE) {
@@ -871,10 +941,16 @@ int g_screenshotFailures;
 					std::size_t lslash = title.find_last_of('/');
 					title = title.substr(lslash + 1);
 				}
-				result = CChunkFileReader::Save(op.path, title, PPSSPP_GIT_VERSION, state);
+				// The state is snapshotted right away, compressing and writing happen in the background.
+				result = CChunkFileReader::SaveAsync(op.path, title, PPSSPP_GIT_VERSION, state, [callback = op.callback, slot_prefix](CChunkFileReader::Error error) {
+					if (error != CChunkFileReader::ERROR_NONE)
+						ERROR_LOG(Log::SaveState, "Failed to write save state");
+					if (callback) {
+						std::lock_guard<std::mutex> guard(g_finishedSavesMutex);
+						g_finishedSaves.push_back(FinishedSave{ callback, error, slot_prefix });
+					}
+				});
 				if (result == CChunkFileReader::ERROR_NONE) {
-					callbackMessage = slot_prefix + std::string(sc->T("Saved State"));
-					callbackResult = Status::SUCCESS;
 #ifndef MOBILE_DEVICE
 					if (g_Config.bSaveLoadResetsAVdumping) {
 						if (g_Config.bDumpFrames) {
@@ -887,6 +963,8 @@ int g_screenshotFailures;
 					}
 #endif
 					g_lastSaveTime = time_now_d();
+					// The callback will be called from Process once it's written.
+					continue;
 				} else if (result == CChunkFileReader::ERROR_BROKEN_STATE) {
 					// TODO: What else might we want to do here? This should be very unusual.
 					callbackMessage = i18nSaveFailure;
@@ -982,6 +1060,7 @@ int g_screenshotFailures;
 	}
 
 	void Shutdown() {
+		FinishPendingSaves();
 		std::lock_guard<std::mutex> guard(mutex);
 		rewindStates.Clear();
 	}
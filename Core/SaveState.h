@@ -87,6 +87,10 @@ namespace SaveState {
 	void Save(const Path &filename, int slot, Callback callback = Callback());
 
 	CChunkFileReader::Error SaveToRam(std::vector<u8> &state);
+	// Only stores the RAM and VRAM pages that differ from the incremental reference (see
+	// Memory::CaptureIncrementalReference), or everything if there isn't one.
+	// LoadFromRam can load it as long as the reference is still the same.
+	CChunkFileReader::Error SaveToRamIncremental(std::vector<u8> &state);
 	CChunkFileReader::Error LoadFromRam(std::vector<u8> &state, std::string *errorString);
 
 	// For testing / automated tests.  Runs a save state verification pass (async.)
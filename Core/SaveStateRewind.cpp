@@ -1,73 +1,155 @@
+#include <algorithm>
+#include <cstring>
+
+#include <zstd.h>
+
 #include "Common/Thread/ThreadUtil.h"
+#include "Common/Thread/ParallelLoop.h"
 #include "Common/Data/Text/I18n.h"
+#include "Common/Log.h"
+#include "Common/Math/CrossSIMD.h"
 #include "Common/StringUtils.h"
 #include "Core/SaveState.h"
 #include "Core/SaveStateRewind.h"
 #include "Core/Core.h"
 #include "Core/Config.h"
+#include "Core/MemMap.h"
 
 namespace SaveState {
 
+// Compares 64 bytes at a time. Blocks are a multiple of that, except possibly the last one of a state.
+static bool BlocksEqual(const u8 *a, const u8 *b, size_t size) {
+	size_t i = 0;
+	for (; i + 64 <= size; i += 64) {
+		Vec4S32 diff = Vec4S32::Load((const int *)(a + i)) ^ Vec4S32::Load((const int *)(b + i));
+		diff |= Vec4S32::Load((const int *)(a + i + 16)) ^ Vec4S32::Load((const int *)(b + i + 16));
+		diff |= Vec4S32::Load((const int *)(a + i + 32)) ^ Vec4S32::Load((const int *)(b + i + 32));
+		diff |= Vec4S32::Load((const int *)(a + i + 48)) ^ Vec4S32::Load((const int *)(b + i + 48));
+		if (!AllCompareBitsSet(diff.CompareEq(Vec4S32::Zero())))
+			return false;
+	}
+	return memcmp(a + i, b + i, size - i) == 0;
+}
+
+static void CompressSegments(std::vector<std::vector<u8>> &segments, const u8 *data, size_t size, size_t segmentSize) {
+	const int numSegments = (int)((size + segmentSize - 1) / segmentSize);
+	segments.resize(numSegments);
+	ParallelRangeLoop(&g_threadManager, [&](int lower, int upper) {
+		for (int seg = lower; seg < upper; ++seg) {
+			const size_t offset = (size_t)seg * segmentSize;
+			const size_t rawSize = std::min(segmentSize, size - offset);
+			std::vector<u8> &out = segments[seg];
+			out.resize(ZSTD_compressBound(rawSize));
+			size_t written = ZSTD_compress(&out[0], out.size(), data + offset, rawSize, 1);
+			_dbg_assert_(!ZSTD_isError(written));
+			out.resize(ZSTD_isError(written) ? 0 : written);
+			out.shrink_to_fit();
+		}
+	}, 0, numSegments, 1);
+}
+
+static bool DecompressSegments(u8 *data, size_t size, const std::vector<std::vector<u8>> &segments, size_t segmentSize) {
+	if (segments.size() != (size + segmentSize - 1) / segmentSize)
+		return false;
+
+	std::atomic<bool> failed{};
+	ParallelRangeLoop(&g_threadManager, [&](int lower, int upper) {
+		for (int seg = lower; seg < upper; ++seg) {
+			const size_t offset = (size_t)seg * segmentSize;
+			const size_t rawSize = std::min(segmentSize, size - offset);
+			const std::vector<u8> &compressed = segments[seg];
+			if (compressed.empty() || ZSTD_decompress(data + offset, rawSize, &compressed[0], compressed.size()) != rawSize)
+				failed = true;
+		}
+	}, 0, (int)segments.size(), 1);
+	return !failed;
+}
+
+size_t StateRingbuffer::RewindDelta::MemoryUsage() const {
+	size_t total = sizeof(RewindDelta) + changed.capacity() * sizeof(u32) + segments.capacity() * sizeof(StateBuffer);
+	for (const StateBuffer &segment : segments)
+		total += segment.capacity();
+	total += memPages.capacity() * sizeof(u32) + memSegments.capacity() * sizeof(StateBuffer);
+	for (const StateBuffer &segment : memSegments)
+		total += segment.capacity();
+	return total;
+}
+
 CChunkFileReader::Error StateRingbuffer::Save() {
 	rewindLastTime_ = time_now_d();
 
 	// Make sure we're not processing a previous save. That'll cause a hitch though, but at least won't
-	// crash due to contention over buffer_.
+	// crash due to contention over pending_.
 	if (compressThread_.joinable())
 		compressThread_.join();
 
-	std::lock_guard<std::mutex> guard(lock_);
+	// Bring the memory reference up to date, keeping what the head had in the changed pages.
+	if (head_.empty() || !Memory::UpdateIncrementalReference(&pendingMemPages_, &pendingMemOld_)) {
+		// Either there's nothing to step back to, or the reference is gone (memory was resized, say.)
+		if (!head_.empty()) {
+			WARN_LOG(Log::SaveState, "Rewind: Memory reference lost, dropping older states");
+			std::lock_guard<std::mutex> guard(lock_);
+			DropStates();
+		}
+		Memory::CaptureIncrementalReference();
+		pendingMemPages_.clear();
+		pendingMemOld_.clear();
+	}
 
-	int n = next_++ % size_;
-	if ((next_ % size_) == first_)
-		++first_;
-
-	std::vector<u8> *compressBuffer = &buffer_;
-	CChunkFileReader::Error err;
-
-	if (base_ == -1 || ++baseUsage_ > BASE_USAGE_INTERVAL)
-	{
-		base_ = (base_ + 1) % ARRAY_SIZE(bases_);
-		baseUsage_ = 0;
-		err = SaveToRam(bases_[base_]);
-		// Let's not bother savestating twice.
-		compressBuffer = &bases_[base_];
-	} else
-		err = SaveToRam(buffer_);
-
-	if (err == CChunkFileReader::ERROR_NONE) {
-		ScheduleCompress(&states_[n].stateBuffer, compressBuffer, &bases_[base_]);
-		states_[n].savedTime = time_now_d();
-	} else {
-		states_[n].clear();
+	CChunkFileReader::Error err = SaveToRamIncremental(pending_);
+	if (err != CChunkFileReader::ERROR_NONE) {
+		// The reference already moved on, so the head can't be loaded anymore.
+		std::lock_guard<std::mutex> guard(lock_);
+		DropStates();
+		return err;
 	}
 
-	baseMapping_[n] = base_;
+	pendingMemRefId_ = Memory::GetIncrementalReferenceId();
+	pendingTime_ = time_now_d();
+	ScheduleCompress();
 	return err;
 }
 
 CChunkFileReader::Error StateRingbuffer::Restore(std::string *errorString, std::string *metadata) {
+	// The newest state might still be on its way in.
+	if (compressThread_.joinable())
+		compressThread_.join();
+
 	std::lock_guard<std::mutex> guard(lock_);
 
 	// No valid states left.
-	if (Empty())
-		return CChunkFileReader::ERROR_BAD_FILE;
-
-	int n = (--next_ + size_) % size_;
-	if (states_[n].empty())
+	if (head_.empty())
 		return CChunkFileReader::ERROR_BAD_FILE;
 
 	auto pa = GetI18NCategory(I18NCat::PAUSE);
 
-	static std::vector<u8> buffer;
-	LockedDecompress(buffer, states_[n].stateBuffer, bases_[baseMapping_[n]]);
-	CChunkFileReader::Error error = LoadFromRam(buffer, errorString);
+	CChunkFileReader::Error error = LoadFromRam(head_, errorString);
+	double savedTime = headTime_;
 	*metadata = pa->T("Rewind");
 
-	if (states_[n].savedTime) {
+	// Step back one state for next time.
+	if (!deltas_.empty()) {
+		RewindDelta &delta = deltas_.back();
+		if (Decode(pending_, delta, head_) && RevertMemory(delta)) {
+			head_.swap(pending_);
+			headTime_ = delta.savedTime;
+			headMemRefId_ = delta.memRefId;
+			pending_.clear();
+			deltaMemory_ -= delta.MemoryUsage();
+			deltas_.pop_back();
+		} else {
+			ERROR_LOG(Log::SaveState, "Rewind: Failed to decompress state, dropping the rest");
+			DropStates();
+		}
+	} else {
+		DropStates();
+	}
+	numStates_ = head_.empty() ? 0 : (int)deltas_.size() + 1;
+
+	if (savedTime) {
 		auto di = GetI18NCategory(I18NCat::DIALOG);
 		metadata->append(" (");
-		metadata->append(ApplySafeSubstitutions(di->T("%1 seconds ago"), static_cast<int>(time_now_d() - states_[n].savedTime)));
+		metadata->append(ApplySafeSubstitutions(di->T("%1 seconds ago"), static_cast<int>(time_now_d() - savedTime)));
 		metadata->append(")");
 	}
 
@@ -75,84 +157,184 @@ CChunkFileReader::Error StateRingbuffer::Restore(std::string *errorString, std::
 	return error;
 }
 
-void StateRingbuffer::ScheduleCompress(std::vector<u8> *result, const std::vector<u8> *state, const std::vector<u8> *base) {
+void StateRingbuffer::ScheduleCompress() {
 	if (compressThread_.joinable())
 		compressThread_.join();
 	compressThread_ = std::thread([=] {
 		SetCurrentThreadName("SaveStateCompress");
 
 		// Should do no I/O, so no JNI thread context needed.
-		Compress(*result, *state, *base);
+		Compress();
 	});
 }
 
-void StateRingbuffer::Compress(std::vector<u8> &result, const std::vector<u8> &state, const std::vector<u8> &base) {
+void StateRingbuffer::Compress() {
 	std::lock_guard<std::mutex> guard(lock_);
 	// Bail if we were cleared before locking.
-	if (first_ == 0 && next_ == 0)
+	if (pending_.empty())
 		return;
 
 	double start_time = time_now_d();
-	result.clear();
-	result.reserve(512 * 1024);
-	for (size_t i = 0; i < state.size(); i += BLOCK_SIZE)
-	{
-		int blockSize = std::min(BLOCK_SIZE, (int)(state.size() - i));
-		if (i + blockSize > base.size() || memcmp(&state[i], &base[i], blockSize) != 0) {
-			result.push_back(1);
-			result.insert(result.end(), state.begin() + i, state.begin() + i + blockSize);
-		} else {
-			result.push_back(0);
-		}
+	size_t deltaSize = 0;
+	if (!head_.empty()) {
+		// The old head becomes a delta against the new one.
+		RewindDelta delta;
+		Encode(delta, head_, pending_);
+		delta.memPages.swap(pendingMemPages_);
+		delta.memSize = (u32)pendingMemOld_.size();
+		CompressSegments(delta.memSegments, pendingMemOld_.data(), pendingMemOld_.size(), (size_t)SEGMENT_BLOCKS * BLOCK_SIZE);
+		delta.memRefId = headMemRefId_;
+		delta.savedTime = headTime_;
+		deltaSize = delta.MemoryUsage();
+		deltaMemory_ += deltaSize;
+		deltas_.push_back(std::move(delta));
 	}
 
+	// Keep the old buffer around (in pending_), it's the right size for the next save.
+	head_.swap(pending_);
+	headTime_ = pendingTime_;
+	headMemRefId_ = pendingMemRefId_;
+	pending_.clear();
+	// This one can be as large as all of memory, though.
+	pendingMemPages_.clear();
+	pendingMemOld_.clear();
+	pendingMemOld_.shrink_to_fit();
+
+	TrimToBudget();
+	numStates_ = (int)deltas_.size() + 1;
+
 	double taken_s = time_now_d() - start_time;
-	DEBUG_LOG(Log::SaveState, "Rewind: Compressed save from %d bytes to %d in %0.2f ms.", (int)state.size(), (int)result.size(), taken_s * 1000.0);
-}
-
-void StateRingbuffer::LockedDecompress(std::vector<u8> &result, const std::vector<u8> &compressed, const std::vector<u8> &base) {
-	result.clear();
-	result.reserve(base.size());
-	auto basePos = base.begin();
-	for (size_t i = 0; i < compressed.size(); ) {
-		if (compressed[i] == 0) {
-			++i;
-			int blockSize = std::min(BLOCK_SIZE, (int)(base.size() - result.size()));
-			result.insert(result.end(), basePos, basePos + blockSize);
-			basePos += blockSize;
-		} else {
-			++i;
-			int blockSize = std::min(BLOCK_SIZE, (int)(compressed.size() - i));
-			result.insert(result.end(), compressed.begin() + i, compressed.begin() + i + blockSize);
-			i += blockSize;
-			// This check is to avoid advancing basePos out of range, which MSVC catches.
-			// When this happens, we're at the end of decoding anyway.
-			if (base.end() - basePos >= blockSize) {
-				basePos += blockSize;
+	DEBUG_LOG(Log::SaveState, "Rewind: Compressed save from %d bytes to %d in %0.2f ms (%d states, %d bytes)", (int)head_.size(), (int)deltaSize, taken_s * 1000.0, (int)numStates_, (int)deltaMemory_);
+}
+
+void StateRingbuffer::Encode(RewindDelta &delta, const StateBuffer &state, const StateBuffer &newer) {
+	// Segments never share a word of the changed mask, so they can be written in parallel.
+	static_assert((SEGMENT_BLOCKS % 32) == 0, "Segments must cover whole words of the mask");
+
+	const size_t numBlocks = (state.size() + BLOCK_SIZE - 1) / BLOCK_SIZE;
+	const int numSegments = (int)((numBlocks + SEGMENT_BLOCKS - 1) / SEGMENT_BLOCKS);
+	delta.size = (u32)state.size();
+	delta.changed.assign((numBlocks + 31) / 32, 0);
+	delta.segments.resize(numSegments);
+
+	ParallelRangeLoop(&g_threadManager, [&](int lower, int upper) {
+		StateBuffer raw;
+		for (int seg = lower; seg < upper; ++seg) {
+			raw.clear();
+			const size_t lastBlock = std::min(numBlocks, (size_t)(seg + 1) * SEGMENT_BLOCKS);
+			for (size_t b = (size_t)seg * SEGMENT_BLOCKS; b < lastBlock; ++b) {
+				const size_t offset = b * BLOCK_SIZE;
+				const size_t blockSize = std::min((size_t)BLOCK_SIZE, state.size() - offset);
+				if (offset + blockSize <= newer.size() && BlocksEqual(&state[offset], &newer[offset], blockSize))
+					continue;
+				delta.changed[b / 32] |= 1U << (b & 31);
+				raw.insert(raw.end(), state.begin() + offset, state.begin() + offset + blockSize);
+			}
+			if (raw.empty())
+				continue;
+
+			StateBuffer &out = delta.segments[seg];
+			out.resize(ZSTD_compressBound(raw.size()));
+			size_t written = ZSTD_compress(&out[0], out.size(), &raw[0], raw.size(), 1);
+			_dbg_assert_(!ZSTD_isError(written));
+			out.resize(ZSTD_isError(written) ? 0 : written);
+			out.shrink_to_fit();
+		}
+	}, 0, numSegments, 1);
+}
+
+bool StateRingbuffer::Decode(StateBuffer &result, const RewindDelta &delta, const StateBuffer &newer) {
+	const size_t numBlocks = (delta.size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+	const int numSegments = (int)delta.segments.size();
+	result.resize(delta.size);
+
+	std::atomic<bool> failed{};
+	ParallelRangeLoop(&g_threadManager, [&](int lower, int upper) {
+		StateBuffer raw;
+		for (int seg = lower; seg < upper; ++seg) {
+			const size_t firstBlock = (size_t)seg * SEGMENT_BLOCKS;
+			const size_t lastBlock = std::min(numBlocks, firstBlock + SEGMENT_BLOCKS);
+			auto blockChanged = [&](size_t b) {
+				return (delta.changed[b / 32] & (1U << (b & 31))) != 0;
+			};
+			auto blockSize = [&](size_t b) {
+				return std::min((size_t)BLOCK_SIZE, (size_t)delta.size - b * BLOCK_SIZE);
+			};
+
+			size_t rawSize = 0;
+			for (size_t b = firstBlock; b < lastBlock; ++b) {
+				if (blockChanged(b))
+					rawSize += blockSize(b);
+			}
+			if (rawSize != 0) {
+				const StateBuffer &compressed = delta.segments[seg];
+				raw.resize(rawSize);
+				if (compressed.empty() || ZSTD_decompress(&raw[0], rawSize, &compressed[0], compressed.size()) != rawSize) {
+					failed = true;
+					return;
+				}
+			}
+
+			size_t rawPos = 0;
+			for (size_t b = firstBlock; b < lastBlock; ++b) {
+				const size_t offset = b * BLOCK_SIZE;
+				const size_t size = blockSize(b);
+				if (blockChanged(b)) {
+					memcpy(&result[offset], &raw[rawPos], size);
+					rawPos += size;
+				} else if (offset + size <= newer.size()) {
+					memcpy(&result[offset], &newer[offset], size);
+				} else {
+					failed = true;
+					return;
+				}
 			}
 		}
+	}, 0, numSegments, 1);
+
+	return !failed;
+}
+
+bool StateRingbuffer::RevertMemory(const RewindDelta &delta) {
+	StateBuffer oldData(delta.memSize);
+	if (!DecompressSegments(oldData.data(), oldData.size(), delta.memSegments, (size_t)SEGMENT_BLOCKS * BLOCK_SIZE))
+		return false;
+	return Memory::RevertIncrementalReference(delta.memPages, oldData.data(), oldData.size(), delta.memRefId);
+}
+
+void StateRingbuffer::TrimToBudget() {
+	const size_t budget = (size_t)std::max(g_Config.iRewindMemoryBudgetMB, 1) * 1024 * 1024;
+	while (!deltas_.empty() && (deltaMemory_ > budget || (int)deltas_.size() > MAX_DELTAS)) {
+		deltaMemory_ -= deltas_.front().MemoryUsage();
+		deltas_.pop_front();
 	}
 }
 
+// Call with lock_ held.
+void StateRingbuffer::DropStates() {
+	head_.clear();
+	pending_.clear();
+	pendingMemPages_.clear();
+	pendingMemOld_.clear();
+	deltas_.clear();
+	deltaMemory_ = 0;
+	numStates_ = 0;
+	// Nothing is saved against it anymore.
+	Memory::ClearIncrementalReference();
+}
+
 void StateRingbuffer::Clear() {
 	if (compressThread_.joinable())
 		compressThread_.join();
 
 	// This lock is mainly for shutdown.
 	std::lock_guard<std::mutex> guard(lock_);
-	first_ = 0;
-	next_ = 0;
-	for (auto &b : bases_) {
-		b.clear();
-	}
-	baseMapping_.clear();
-	baseMapping_.resize(size_);
-	for (auto &s : states_) {
-		s.clear();
-	}
-	buffer_.clear();
-	base_ = -1;
-	baseUsage_ = 0;
+	DropStates();
+	head_.shrink_to_fit();
+	pending_.shrink_to_fit();
+	pendingMemOld_.shrink_to_fit();
+	headTime_ = 0.0;
+	pendingTime_ = 0.0;
 	rewindLastTime_ = time_now_d();
 }
 
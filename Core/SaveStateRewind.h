@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <deque>
 #include <mutex>
 #include <thread>
 #include "Common/Serialize/Serializer.h"
@@ -9,17 +11,18 @@
 namespace SaveState {
 
 // This ring buffer of states is for rewind save states, which are kept in RAM.
-// Save states are compressed against one of two reference saves (bases_), and the reference
-// is switched to a fresh save every N saves, where N is BASE_USAGE_INTERVAL.
-// The compression is a simple block based scheme where 0 means to copy a block from the base,
-// and 1 means that the following bytes are the next block. See Compress/LockedDecompress.
+// Only the newest state is kept in full (head_). Each older state is stored as a delta against
+// the state saved after it, so rewinding walks back through the chain one delta at a time.
+// A delta records which blocks differ, and stores those blocks zstd-compressed in segments that
+// are diffed and compressed in parallel. The oldest deltas are dropped to stay within the memory
+// budget (RewindMemoryBudget in the ini.) See Encode/Decode.
+//
+// RAM and VRAM are kept out of the states. The Memory incremental reference is kept equal to the
+// head's memory, and states are saved incrementally against it, so saving only copies the pages
+// that changed. Those pages' old contents go in the delta, to step the reference back on rewind.
 class StateRingbuffer {
 public:
-	StateRingbuffer() {
-		size_ = REWIND_NUM_STATES;
-		states_.resize(size_);
-		baseMapping_.resize(size_);
-	}
+	StateRingbuffer() {}
 
 	~StateRingbuffer() {
 		if (compressThread_.joinable()) {
@@ -29,13 +32,10 @@ class StateRingbuffer {
 
 	CChunkFileReader::Error Save();
 	CChunkFileReader::Error Restore(std::string *errorString, std::string *metadata);
-	void ScheduleCompress(std::vector<u8> *result, const std::vector<u8> *state, const std::vector<u8> *base);
-	void Compress(std::vector<u8> &result, const std::vector<u8> &state, const std::vector<u8> &base);
-	void LockedDecompress(std::vector<u8> &result, const std::vector<u8> &compressed, const std::vector<u8> &base);
 	void Clear();
 
 	bool Empty() const {
-		return next_ == first_;
+		return numStates_ == 0;
 	}
 
 	void Process();
@@ -44,34 +44,58 @@ class StateRingbuffer {
 	double NextStateTimestamp() const;
 
 private:
-	const int BLOCK_SIZE = 8192;
-	const int REWIND_NUM_STATES = 20;
-	// TODO: Instead, based on size of compressed state?
-	const int BASE_USAGE_INTERVAL = 15;
+	static constexpr int BLOCK_SIZE = 4096;
+	// Blocks per segment. Segments are the unit of parallel work and of zstd compression.
+	static constexpr int SEGMENT_BLOCKS = 64;
+	// Even with plenty of budget, there's not much point going further back than this.
+	static constexpr int MAX_DELTAS = 1200;
 
 	typedef std::vector<u8> StateBuffer;
 
-	struct RewindState {
-		StateBuffer stateBuffer;
-		double savedTime;
-
-		bool empty() const { return stateBuffer.empty(); }
-		void clear() { stateBuffer.clear(); savedTime = 0.0; }
+	struct RewindDelta {
+		// Size of the state this rebuilds.
+		u32 size = 0;
+		// One bit per block, set if it's stored here rather than copied from the newer state.
+		std::vector<u32> changed;
+		// Changed blocks of each segment, one after another, zstd compressed. Empty if none changed.
+		std::vector<StateBuffer> segments;
+		// Memory pages that differ in the newer state, and their contents here, compressed in segments.
+		std::vector<u32> memPages;
+		u32 memSize = 0;
+		std::vector<StateBuffer> memSegments;
+		// The Memory incremental reference ID this state was saved against.
+		u64 memRefId = 0;
+		double savedTime = 0.0;
+
+		size_t MemoryUsage() const;
 	};
 
-	int first_ = 0;
-	int next_ = 0;
-	int size_;
+	void ScheduleCompress();
+	void Compress();
+	void Encode(RewindDelta &delta, const StateBuffer &state, const StateBuffer &newer);
+	bool Decode(StateBuffer &result, const RewindDelta &delta, const StateBuffer &newer);
+	bool RevertMemory(const RewindDelta &delta);
+	void TrimToBudget();
+	void DropStates();
 
-	std::vector<RewindState> states_;
-	StateBuffer bases_[2];
-	std::vector<int> baseMapping_;
 	std::mutex lock_;
 	std::thread compressThread_;
-	std::vector<u8> buffer_;
 
-	int base_ = -1;
-	int baseUsage_ = 0;
+	// The newest state, in full, and when it was saved.
+	StateBuffer head_;
+	double headTime_ = 0.0;
+	u64 headMemRefId_ = 0;
+	// Saved on the emu thread, waiting to become the new head.
+	StateBuffer pending_;
+	double pendingTime_ = 0.0;
+	u64 pendingMemRefId_ = 0;
+	// Memory pages the pending state changed, and their contents in the head.
+	std::vector<u32> pendingMemPages_;
+	StateBuffer pendingMemOld_;
+	// Oldest first.
+	std::deque<RewindDelta> deltas_;
+	size_t deltaMemory_ = 0;
+	std::atomic<int> numStates_{};
 
 	double rewindLastTime_ = 0.0f;
 };
@@ -50,6 +50,7 @@
 #include "Core/MIPS/MIPS.h"
 #include "Core/MIPS/MIPSAnalyst.h"
 #include "Core/MIPS/MIPSVFPUUtils.h"
+#include "Core/MIPS/IR/IRDiskCache.h"
 #include "Core/Debugger/LineInfo.h"
 #include "Core/Debugger/SymbolMap.h"
 #include "Core/System.h"
@@ -617,6 +618,11 @@ void CPU_Shutdown(bool success) {
 	pspFileSystem.Shutdown();  // This unmounts all filesystems.
 
 	mipsr4k.Shutdown();
+	// The jit handed its blocks over when it was destroyed above.
+	if (success) {
+		MIPSComp::g_irDiskCache.Save();
+	}
+	MIPSComp::g_irDiskCache.Clear();
 	Memory::Shutdown();
 	HLEPlugins::Shutdown();
 
@@ -13,19 +13,43 @@ DepthScissor DepthScissor::Tile(int tile, int numTiles) const {
 		return *this;
 	}
 	// First tiling algorithm: Split into vertical slices.
-	int w = x2 - x1;
-	int tileW = (w / numTiles) & ~3;  // Round to four pixels.
-
-	// TODO: Should round x1 to four pixels as well! except the first one
+	// The triangle rasterizer loads and stores aligned groups of four pixels, even partially covered ones,
+	// so the edges between tiles have to be on such a group boundary, or neighbours would race.
+	const int w = x2 - x1 + 1;
+	auto edge = [&](int t) -> int {
+		if (t == 0) {
+			return x1;
+		} else if (t >= numTiles) {
+			return x2 + 1;
+		}
+		return std::max((int)x1, (x1 + w * t / numTiles) & ~3);
+	};
 
 	DepthScissor scissor;
-	scissor.x1 = x1 + tileW * tile;
-	scissor.x2 = (tile == numTiles - 1) ? x2 : (x1 + tileW * (tile + 1));
+	const int left = edge(tile);
+	const int right = edge(tile + 1);
+	if (left >= right) {
+		// Too narrow to give this tile anything.
+		scissor.x1 = 1;
+		scissor.x2 = 0;
+	} else {
+		scissor.x1 = left;
+		scissor.x2 = right - 1;
+	}
 	scissor.y1 = y1;
 	scissor.y2 = y2;
 	return scissor;
 }
 
+DepthScissor DepthScissor::Intersect(const DepthScissor &other) const {
+	DepthScissor scissor;
+	scissor.x1 = std::max(x1, other.x1);
+	scissor.y1 = std::max(y1, other.y1);
+	scissor.x2 = std::min(x2, other.x2);
+	scissor.y2 = std::min(y2, other.y2);
+	return scissor;
+}
+
 // x1/x2 etc are the scissor rect.
 static void DepthRasterRect(uint16_t *dest, int stride, const DepthScissor scissor, int v1x, int v1y, int v2x, int v2y, short depthValue, ZCompareMode compareMode) {
 	// Swap coordinates if needed, we don't back-face-cull rects.
@@ -566,7 +590,7 @@ int DepthRasterClipIndexedTriangles(int *tx, int *ty, float *tz, const float *tr
 }
 
 // Rasterizes screen-space vertices.
-void DepthRasterScreenVerts(uint16_t *depth, int depthStride, const int *tx, const int *ty, const float *tz, int count, const DepthDraw &draw, const DepthScissor scissor, bool lowQ) {
+void DepthRasterScreenVerts(uint16_t *depth, int depthStride, const int *tx, const int *ty, const float *tz, int count, const DepthDraw &draw, const DepthScissor scissor, bool lowQ, DepthRasterStats *stats) {
 	// Prim should now be either TRIANGLES or RECTs.
 	_dbg_assert_(draw.prim == GE_PRIM_RECTANGLES || draw.prim == GE_PRIM_TRIANGLES);
 
@@ -578,32 +602,34 @@ void DepthRasterScreenVerts(uint16_t *depth, int depthStride, const int *tx, con
 			// We remove the subpixel information here.
 			DepthRasterRect(depth, depthStride, scissor, tx[i], ty[i], tx[i + 1], ty[i + 1], z, draw.compareMode);
 		}
-		gpuStats.perFrame.numDepthRasterPrims += count / 2;
+		if (stats) {
+			stats->prims += count / 2;
+		}
 		break;
 	case GE_PRIM_TRIANGLES:
 	{
-		int stats[3]{};
+		int triStats[3]{};
 		// Batches of 4 triangles, as output by the clip function.
 		if (lowQ) {
 			switch (draw.compareMode) {
 			case ZCompareMode::Greater:
 			{
 				for (int i = 0; i < count; i += 12) {
-					DepthRaster4Triangles<ZCompareMode::Greater, true>(stats, depth, depthStride, scissor, &tx[i], &ty[i], &tz[i]);
+					DepthRaster4Triangles<ZCompareMode::Greater, true>(triStats, depth, depthStride, scissor, &tx[i], &ty[i], &tz[i]);
 				}
 				break;
 			}
 			case ZCompareMode::Less:
 			{
 				for (int i = 0; i < count; i += 12) {
-					DepthRaster4Triangles<ZCompareMode::Less, true>(stats, depth, depthStride, scissor, &tx[i], &ty[i], &tz[i]);
+					DepthRaster4Triangles<ZCompareMode::Less, true>(triStats, depth, depthStride, scissor, &tx[i], &ty[i], &tz[i]);
 				}
 				break;
 			}
 			case ZCompareMode::Always:
 			{
 				for (int i = 0; i < count; i += 12) {
-					DepthRaster4Triangles<ZCompareMode::Always, true>(stats, depth, depthStride, scissor, &tx[i], &ty[i], &tz[i]);
+					DepthRaster4Triangles<ZCompareMode::Always, true>(triStats, depth, depthStride, scissor, &tx[i], &ty[i], &tz[i]);
 				}
 				break;
 			}
@@ -613,32 +639,70 @@ void DepthRasterScreenVerts(uint16_t *depth, int depthStride, const int *tx, con
 			case ZCompareMode::Greater:
 			{
 				for (int i = 0; i < count; i += 12) {
-					DepthRaster4Triangles<ZCompareMode::Greater, false>(stats, depth, depthStride, scissor, &tx[i], &ty[i], &tz[i]);
+					DepthRaster4Triangles<ZCompareMode::Greater, false>(triStats, depth, depthStride, scissor, &tx[i], &ty[i], &tz[i]);
 				}
 				break;
 			}
 			case ZCompareMode::Less:
 			{
 				for (int i = 0; i < count; i += 12) {
-					DepthRaster4Triangles<ZCompareMode::Less, false>(stats, depth, depthStride, scissor, &tx[i], &ty[i], &tz[i]);
+					DepthRaster4Triangles<ZCompareMode::Less, false>(triStats, depth, depthStride, scissor, &tx[i], &ty[i], &tz[i]);
 				}
 				break;
 			}
 			case ZCompareMode::Always:
 			{
 				for (int i = 0; i < count; i += 12) {
-					DepthRaster4Triangles<ZCompareMode::Always, false>(stats, depth, depthStride, scissor, &tx[i], &ty[i], &tz[i]);
+					DepthRaster4Triangles<ZCompareMode::Always, false>(triStats, depth, depthStride, scissor, &tx[i], &ty[i], &tz[i]);
 				}
 				break;
 			}
 			}
 		}
-		gpuStats.perFrame.numDepthRasterNoPixels += stats[(int)TriangleStat::NoPixels];
-		gpuStats.perFrame.numDepthRasterTooSmall += stats[(int)TriangleStat::SmallOrBackface];
-		gpuStats.perFrame.numDepthRasterPrims += stats[(int)TriangleStat::OK];
+		if (stats) {
+			stats->noPixels += triStats[(int)TriangleStat::NoPixels];
+			stats->tooSmall += triStats[(int)TriangleStat::SmallOrBackface];
+			stats->prims += triStats[(int)TriangleStat::OK];
+		}
 		break;
 	}
 	default:
 		_dbg_assert_(false);
 	}
 }
+
+// Classifies the triangles the same way DepthRaster4Triangles does, without drawing anything.
+void DepthRasterCountScreenVerts(const int *tx, const int *ty, int count, const DepthDraw &draw, const DepthScissor scissor, bool lowQ, DepthRasterStats *stats) {
+	switch (draw.prim) {
+	case GE_PRIM_RECTANGLES:
+		stats->prims += count / 2;
+		break;
+	case GE_PRIM_TRIANGLES:
+		// Batches of 4 triangles, as output by the clip function.
+		for (int i = 0; i < count; i += 12) {
+			for (int t = 0; t < 4; t++) {
+				const int x0 = tx[i + t], x1 = tx[i + 4 + t], x2 = tx[i + 8 + t];
+				int y0 = ty[i + t], y1 = ty[i + 4 + t], y2 = ty[i + 8 + t];
+				if (lowQ) {
+					y0 &= ~1;
+					y1 &= ~1;
+					y2 &= ~1;
+				}
+				const int minX = std::max(std::min(std::min(x0, x1), x2), (int)scissor.x1);
+				const int maxX = std::min(std::max(std::max(x0, x1), x2), (int)scissor.x2);
+				const int minY = std::max(std::min(std::min(y0, y1), y2), (int)scissor.y1);
+				const int maxY = std::min(std::max(std::max(y0, y1), y2), (int)scissor.y2);
+				if (maxX <= minX || maxY <= minY) {
+					stats->noPixels++;
+				} else if ((x1 - x0) * (y2 - y0) - (x2 - x0) * (y1 - y0) < MIN_TWICE_TRI_AREA) {
+					stats->tooSmall++;
+				} else {
+					stats->prims++;
+				}
+			}
+		}
+		break;
+	default:
+		_dbg_assert_(false);
+	}
+}
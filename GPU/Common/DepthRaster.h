@@ -27,7 +27,17 @@ struct DepthScissor {
 	u16 x2;
 	u16 y2;
 
+	// Vertical slice of the scissor. The inner edges are aligned to four pixels, so that tiles
+	// can be rasterized in parallel without touching each other's pixels. May be empty (x1 > x2).
 	DepthScissor Tile(int tile, int numTiles) const;
+	DepthScissor Intersect(const DepthScissor &other) const;
+	bool IsEmpty() const { return x1 > x2 || y1 > y2; }
+};
+
+struct DepthRasterStats {
+	int prims;
+	int noPixels;
+	int tooSmall;
 };
 
 struct DepthDraw {
@@ -56,4 +66,7 @@ int DepthRasterClipIndexedRectangles(int *tx, int *ty, float *tz, const float *t
 void DecodeAndTransformForDepthRaster(float *dest, const float *worldviewproj, const void *vertexData, int indexLowerBound, int indexUpperBound, const VertexDecoder *dec, u32 vertTypeID);
 void TransformPredecodedForDepthRaster(float *dest, const float *worldviewproj, const void *decodedVertexData, const VertexDecoder *dec, int count);
 void ConvertPredecodedThroughForDepthRaster(float *dest, const void *decodedVertexData, const VertexDecoder *dec, int count);
-void DepthRasterScreenVerts(uint16_t *depth, int depthStride, const int *tx, const int *ty, const float *tz, int count, const DepthDraw &draw, const DepthScissor scissor, bool lowQ);
+// stats may be null. When rasterizing in tiles, use DepthRasterCountScreenVerts once per draw instead,
+// or triangles that span several tiles get counted in each.
+void DepthRasterScreenVerts(uint16_t *depth, int depthStride, const int *tx, const int *ty, const float *tz, int count, const DepthDraw &draw, const DepthScissor scissor, bool lowQ, DepthRasterStats *stats);
+void DepthRasterCountScreenVerts(const int *tx, const int *ty, int count, const DepthDraw &draw, const DepthScissor scissor, bool lowQ, DepthRasterStats *stats);
@@ -25,9 +25,12 @@
 #include "Common/Math/SIMDHeaders.h"
 #include "Common/Math/CrossSIMD.h"
 #include "Common/Math/lin/matrix4x4.h"
+#include "Common/Thread/ParallelLoop.h"
+#include "Common/Thread/ThreadManager.h"
 #include "Common/TimeUtil.h"
 #include "Core/System.h"
 #include "Core/Config.h"
+#include "ext/xxhash.h"
 #include "GPU/GPUCommon.h"
 #include "GPU/Common/DrawEngineCommon.h"
 #include "GPU/GPUStateSIMDUtil.h"
@@ -43,7 +46,13 @@ enum {
 	TRANSFORMED_VERTEX_BUFFER_SIZE = VERTEX_BUFFER_MAX * sizeof(TransformedVertex),
 };
 
-DrawEngineCommon::DrawEngineCommon() : decoderMap_(32) {
+// Below this, hashing and looking up costs about as much as just decoding.
+static const int DECODE_CACHE_MIN_VERTS = 128;
+static const size_t DECODE_CACHE_MAX_BYTES = 32 * 1024 * 1024;
+// Entries not drawn with for this many frames are dropped.
+static const int DECODE_CACHE_DECIMATE_AGE = 120;
+
+DrawEngineCommon::DrawEngineCommon() : decoderMap_(32), decodeCache_(64) {
 	if (g_Config.bVertexDecoderJit && (g_Config.iCpuCore == (int)CPUCore::JIT || g_Config.iCpuCore == (int)CPUCore::JIT_IR)) {
 		decJitCache_ = new VertexDecoderJitCache();
 	}
@@ -68,6 +77,7 @@ DrawEngineCommon::~DrawEngineCommon() {
 	FreeMemoryPages(transformed_, TRANSFORMED_VERTEX_BUFFER_SIZE);
 	FreeMemoryPages(transformedExpanded_, 3 * TRANSFORMED_VERTEX_BUFFER_SIZE);
 	ShutdownDepthRaster();
+	ClearDecodeCache();
 	delete decJitCache_;
 	decoderMap_.Iterate([&](const uint32_t vtype, VertexDecoder *decoder) {
 		delete decoder;
@@ -113,8 +123,12 @@ void DrawEngineCommon::NotifyConfigChanged() {
 		delete decoder;
 	});
 	decoderMap_.Clear();
+	// The entries point at the decoders we just deleted.
+	ClearDecodeCache();
 
 	useHWTransform_ = g_Config.bHardwareTransform;
+	useDecodeCache_ = g_Config.bVertexDecodeCache;
+	useTessCache_ = g_Config.bTessellationCache;
 }
 
 void DrawEngineCommon::DispatchSubmitImm(GEPrimitiveType prim, TransformedVertex *buffer, int vertexCount, int cullMode, bool continuation) {
@@ -930,13 +944,104 @@ void DrawEngineCommon::DecodeVerts(const VertexDecoder *dec, u8 *dest) {
 
 		// Decode the verts (and at the same time apply morphing/skinning). Simple.
 		const u8 *startPos = (const u8 *)dv.verts + indexLowerBound * dec->VertexSize();
-		dec->DecodeVerts(dest + numDecodedVerts * stride, startPos, &dv.uvScale, count);
+		if (useDecodeCache_ && CanUseDecodeCache(dec, count)) {
+			DecodeVertsCached(dec, dv, startPos, count, dest + numDecodedVerts * stride);
+		} else {
+			dec->DecodeVerts(dest + numDecodedVerts * stride, startPos, &dv.uvScale, count);
+		}
 		numDecodedVerts += count;
 	}
 	numDecodedVerts_ = numDecodedVerts;
 	decodeVertsCounter_ = i;
 }
 
+bool DrawEngineCommon::CanUseDecodeCache(const VertexDecoder *dec, int count) const {
+	if (count < DECODE_CACHE_MIN_VERTS)
+		return false;
+	// Skinning and morphing depend on more state than the vertices, and through mode decodes
+	// update the UV bounds as a side effect.  These are rarely big static meshes anyway.
+	return !dec->skinInDecode && dec->morphcount <= 1 && !dec->throughmode;
+}
+
+void DrawEngineCommon::DecodeVertsCached(const VertexDecoder *dec, const DeferredVerts &dv, const u8 *startPos, int count, u8 *dest) {
+	const int frame = gpuStats.totals.numFlips;
+	if (frame != decodeCacheFrame_) {
+		decodeCacheFrame_ = frame;
+		DecimateDecodeCache();
+	}
+
+	const size_t srcSize = (size_t)count * dec->VertexSize();
+	const size_t decodedSize = (size_t)count * dec->GetDecVtxFmt().stride;
+	const u64 hash = XXH3_64bits(startPos, srcSize);
+	const u64 key = (u64)(uintptr_t)startPos ^ ((u64)dec->VertexType() << 32) ^ ((u64)count << 16);
+
+	DecodeCacheEntry *entry = nullptr;
+	if (decodeCache_.Get(key, &entry)) {
+		if (entry->verts == startPos && entry->dec == dec && entry->count == count && !memcmp(&entry->uvScale, &dv.uvScale, sizeof(UVScale))) {
+			entry->lastFrame = frame;
+			if (entry->hash == hash) {
+				memcpy(dest, entry->decoded.data(), decodedSize);
+				gstate_c.vertexFullAlpha = gstate_c.vertexFullAlpha && entry->fullAlpha;
+				return;
+			}
+		} else {
+			// Some other draw with the same key.  Replace it, the newest one is more likely to be drawn again.
+			decodeCacheBytes_ -= entry->decoded.size();
+			decodeCache_.Remove(key);
+			delete entry;
+			entry = nullptr;
+		}
+	}
+
+	// Decode with full alpha set, so we can tell what this draw alone did to it.
+	const bool prevFullAlpha = gstate_c.vertexFullAlpha;
+	gstate_c.vertexFullAlpha = true;
+	dec->DecodeVerts(dest, startPos, &dv.uvScale, count);
+	const bool fullAlpha = gstate_c.vertexFullAlpha;
+	gstate_c.vertexFullAlpha = prevFullAlpha && fullAlpha;
+
+	if (!entry) {
+		if (decodeCacheBytes_ + decodedSize > DECODE_CACHE_MAX_BYTES)
+			return;
+		entry = new DecodeCacheEntry();
+		entry->verts = startPos;
+		entry->dec = dec;
+		entry->uvScale = dv.uvScale;
+		entry->count = count;
+		entry->decoded.resize(decodedSize);
+		decodeCacheBytes_ += decodedSize;
+		decodeCache_.Insert(key, entry);
+	}
+	entry->hash = hash;
+	entry->lastFrame = frame;
+	entry->fullAlpha = fullAlpha;
+	memcpy(entry->decoded.data(), dest, decodedSize);
+}
+
+void DrawEngineCommon::DecimateDecodeCache() {
+	std::vector<u64> expired;
+	decodeCache_.Iterate([&](u64 key, DecodeCacheEntry *entry) {
+		if (entry->lastFrame + DECODE_CACHE_DECIMATE_AGE < decodeCacheFrame_ || entry->lastFrame > decodeCacheFrame_)
+			expired.push_back(key);
+	});
+	for (u64 key : expired) {
+		DecodeCacheEntry *entry = nullptr;
+		decodeCache_.Get(key, &entry);
+		decodeCacheBytes_ -= entry->decoded.size();
+		decodeCache_.Remove(key);
+		delete entry;
+	}
+	decodeCache_.Maintain();
+}
+
+void DrawEngineCommon::ClearDecodeCache() {
+	decodeCache_.Iterate([&](u64 key, DecodeCacheEntry *entry) {
+		delete entry;
+	});
+	decodeCache_.Clear();
+	decodeCacheBytes_ = 0;
+}
+
 int DrawEngineCommon::DecodeInds() {
 	// Note that this should be able to continue a partial decode - we don't necessarily start from zero here (although we do most of the time).
 
@@ -1011,6 +1116,9 @@ enum {
 	DEPTH_SCREENVERTS_COMPONENT_BYTES = DEPTH_SCREENVERTS_COMPONENT_COUNT * sizeof(int) + 384,
 	DEPTH_SCREENVERTS_TOTAL_BYTES = DEPTH_SCREENVERTS_COMPONENT_BYTES * 3,
 	DEPTH_INDEXBUFFER_BYTES = DEPTH_TRANSFORMED_MAX_VERTS * 3 * sizeof(uint16_t),  // hmmm
+	// Below this many clipped vertices in a batch, it's not worth waking up other threads.
+	DEPTH_RASTER_PARALLEL_MIN_VERTS = 1536,
+	DEPTH_RASTER_MAX_TILES = 8,
 };
 
 // We process vertices for depth rendering in several stages:
@@ -1018,7 +1126,9 @@ enum {
 // Then, we group and cull the vertices into four-triangle groups, which are placed in
 // depthScreenVerts_, with x, y and z separated into different part of the array.
 // (Alternatively, if drawing rectangles, they're just added linearly).
-// After that, we send these groups out for SIMD setup and rasterization.
+// After that, we send these groups out for SIMD setup and rasterization. When there's enough
+// of them, the screen is split into vertical tiles that are rasterized on separate threads,
+// each going through all the draws in order.
 void DrawEngineCommon::InitDepthRaster() {
 	switch ((DepthRasterMode)g_Config.iDepthRasterMode) {
 	case DepthRasterMode::DEFAULT:
@@ -1034,6 +1144,7 @@ void DrawEngineCommon::InitDepthRaster() {
 
 	if (useDepthRaster_) {
 		depthDraws_.reserve(256);
+		depthClipped_.reserve(256);
 		depthTransformed_ = (float *)AllocateMemoryPages(DEPTH_TRANSFORMED_BYTES, MEM_PROT_READ | MEM_PROT_WRITE);
 		depthScreenVerts_ = (int *)AllocateMemoryPages(DEPTH_SCREENVERTS_TOTAL_BYTES, MEM_PROT_READ | MEM_PROT_WRITE);
 		depthIndices_ = (uint16_t *)AllocateMemoryPages(DEPTH_INDEXBUFFER_BYTES, MEM_PROT_READ | MEM_PROT_WRITE);
@@ -1236,26 +1347,38 @@ void DrawEngineCommon::FlushQueuedDepth() {
 
 	const bool collectStats = g_coreCollectDebugStats;
 	const bool lowQ = g_Config.iDepthRasterMode == (int)DepthRasterMode::LOW_QUALITY;
-	for (const auto &draw : depthDraws_) {
-		int *tx = depthScreenVerts_;
-		int *ty = depthScreenVerts_ + DEPTH_SCREENVERTS_COMPONENT_COUNT;
-		float *tz = (float *)(depthScreenVerts_ + DEPTH_SCREENVERTS_COMPONENT_COUNT * 2);
+	int *tx = depthScreenVerts_;
+	int *ty = depthScreenVerts_ + DEPTH_SCREENVERTS_COMPONENT_COUNT;
+	float *tz = (float *)(depthScreenVerts_ + DEPTH_SCREENVERTS_COMPONENT_COUNT * 2);
+
+	// Clip as many draws as fit in the screen vertex buffer, then rasterize them together.
+	int screenVertCount = 0;
+	for (int i = 0; i < (int)depthDraws_.size(); i++) {
+		const DepthDraw &draw = depthDraws_[i];
+		if (!Memory::IsValid4AlignedAddress(draw.depthAddr)) {
+			continue;
+		}
+
+		// Triangles come out in groups of four, doubled if culling is off. Rectangles stay the same.
+		const int maxOutVertCount = draw.vertexCount * 2 + 24;
+		if (screenVertCount != 0 && screenVertCount + maxOutVertCount > DEPTH_SCREENVERTS_COMPONENT_COUNT) {
+			RasterizeClippedDepth(screenVertCount, lowQ);
+			screenVertCount = 0;
+		}
 
 		int outVertCount = 0;
 
 		const float *vertices = depthTransformed_ + 4 * draw.vertexOffset;
 		const uint16_t *indices = depthIndices_ + draw.indexOffset;
 
-		DepthScissor tileScissor = draw.scissor.Tile(0, 1);
-
 		{
 			TimeCollector collectStat(&gpuStats.perFrame.msCullDepth, collectStats);
 			switch (draw.prim) {
 			case GE_PRIM_RECTANGLES:
-				outVertCount = DepthRasterClipIndexedRectangles(tx, ty, tz, vertices, indices, draw, tileScissor);
+				outVertCount = DepthRasterClipIndexedRectangles(tx + screenVertCount, ty + screenVertCount, tz + screenVertCount, vertices, indices, draw, draw.scissor);
 				break;
 			case GE_PRIM_TRIANGLES:
-				outVertCount = DepthRasterClipIndexedTriangles(tx, ty, tz, vertices, indices, draw, tileScissor);
+				outVertCount = DepthRasterClipIndexedTriangles(tx + screenVertCount, ty + screenVertCount, tz + screenVertCount, vertices, indices, draw, draw.scissor);
 				break;
 			default:
 				_dbg_assert_(false);
@@ -1263,17 +1386,81 @@ void DrawEngineCommon::FlushQueuedDepth() {
 			}
 		}
 		if (outVertCount > 0) {
-			TimeCollector collectStat(&gpuStats.perFrame.msRasterizeDepth, collectStats);
-			if (!Memory::IsValid4AlignedAddress(draw.depthAddr)) {
-				continue;
-			}
-			u16 *depthPtr = (uint16_t *)Memory::GetPointerWriteUnchecked(draw.depthAddr);
-			DepthRasterScreenVerts(depthPtr, draw.depthStride, tx, ty, tz, outVertCount, draw, tileScissor, lowQ);
+			depthClipped_.push_back(ClippedDepthDraw{ i, screenVertCount, outVertCount });
+			// Keep the next draw 16-byte aligned.
+			screenVertCount += (outVertCount + 3) & ~3;
 		}
 	}
 
+	if (screenVertCount != 0) {
+		RasterizeClippedDepth(screenVertCount, lowQ);
+	}
+
 	// Reset queue
 	depthIndexCount_ = 0;
 	depthVertexCount_ = 0;
 	depthDraws_.clear();
 }
+
+void DrawEngineCommon::RasterizeClippedDepth(int screenVertCount, bool lowQ) {
+	TimeCollector collectStat(&gpuStats.perFrame.msRasterizeDepth, g_coreCollectDebugStats);
+
+	const int *tx = depthScreenVerts_;
+	const int *ty = depthScreenVerts_ + DEPTH_SCREENVERTS_COMPONENT_COUNT;
+	const float *tz = (const float *)(depthScreenVerts_ + DEPTH_SCREENVERTS_COMPONENT_COUNT * 2);
+
+	int numTiles = 1;
+	if (screenVertCount >= DEPTH_RASTER_PARALLEL_MIN_VERTS) {
+		numTiles = std::min(g_threadManager.GetNumLooperThreads(), (int)DEPTH_RASTER_MAX_TILES);
+		numTiles = std::max(numTiles, 1);
+	}
+
+	// The columns are split once for the whole batch, from the union of the scissors, so that a tile owns
+	// the same pixels in every draw. Each tile then goes through the draws in order, since that matters
+	// for the depth test (and with Always, for the result.)
+	DepthScissor bounds = depthDraws_[depthClipped_[0].drawIndex].scissor;
+	for (const ClippedDepthDraw &clipped : depthClipped_) {
+		const DepthScissor &scissor = depthDraws_[clipped.drawIndex].scissor;
+		bounds.x1 = std::min(bounds.x1, scissor.x1);
+		bounds.y1 = std::min(bounds.y1, scissor.y1);
+		bounds.x2 = std::max(bounds.x2, scissor.x2);
+		bounds.y2 = std::max(bounds.y2, scissor.y2);
+	}
+
+	// With several tiles, a triangle would be counted once per tile it touches, so count per draw instead.
+	DepthRasterStats stats{};
+	auto rasterizeTiles = [&](int lower, int upper) {
+		for (int tile = lower; tile < upper; tile++) {
+			const DepthScissor tileScissor = bounds.Tile(tile, numTiles);
+			for (const ClippedDepthDraw &clipped : depthClipped_) {
+				const DepthDraw &draw = depthDraws_[clipped.drawIndex];
+				const DepthScissor scissor = draw.scissor.Intersect(tileScissor);
+				if (scissor.IsEmpty()) {
+					continue;
+				}
+				u16 *depthPtr = (uint16_t *)Memory::GetPointerWriteUnchecked(draw.depthAddr);
+				const int offset = clipped.screenVertOffset;
+				DepthRasterScreenVerts(depthPtr, draw.depthStride, tx + offset, ty + offset, tz + offset, clipped.screenVertCount, draw, scissor, lowQ, numTiles == 1 ? &stats : nullptr);
+			}
+		}
+	};
+
+	if (numTiles == 1) {
+		rasterizeTiles(0, 1);
+	} else {
+		ParallelRangeLoop(&g_threadManager, rasterizeTiles, 0, numTiles, 1);
+		if (g_coreCollectDebugStats) {
+			for (const ClippedDepthDraw &clipped : depthClipped_) {
+				const DepthDraw &draw = depthDraws_[clipped.drawIndex];
+				const int offset = clipped.screenVertOffset;
+				DepthRasterCountScreenVerts(tx + offset, ty + offset, clipped.screenVertCount, draw, draw.scissor, lowQ, &stats);
+			}
+		}
+	}
+
+	gpuStats.perFrame.numDepthRasterPrims += stats.prims;
+	gpuStats.perFrame.numDepthRasterNoPixels += stats.noPixels;
+	gpuStats.perFrame.numDepthRasterTooSmall += stats.tooSmall;
+
+	depthClipped_.clear();
+}
@@ -170,6 +170,7 @@ class DrawEngineCommon {
 	void DepthRasterSubmitRaw(GEPrimitiveType prim, const VertexDecoder *dec, uint32_t vertTypeID, int vertexCount);
 	void DepthRasterPredecoded(GEPrimitiveType prim, const void *inVerts, int numDecoded, const VertexDecoder *dec, int vertexCount);
 	bool CalculateDepthDraw(DepthDraw *draw, GEPrimitiveType prim, int vertexCount);
+	void RasterizeClippedDepth(int screenVertCount, bool lowQ);
 
 	static inline int IndexSize(u32 vtype) {
 		const u32 indexType = (vtype & GE_VTYPE_IDX_MASK);
@@ -307,6 +308,30 @@ class DrawEngineCommon {
 	uint32_t drawVertexOffsets_[MAX_DEFERRED_DRAW_VERTS];
 	DeferredInds drawInds_[MAX_DEFERRED_DRAW_INDS];
 
+	// Decoded vertices of larger draws, kept across frames for static meshes.  Entries are
+	// checked against a hash of the source data on every use, so changed data is just decoded again.
+	struct DecodeCacheEntry {
+		const void *verts;
+		const VertexDecoder *dec;
+		UVScale uvScale;
+		int count;
+		u64 hash;
+		int lastFrame;
+		// Whether all the decoded colors had full alpha, since we skip the decoder's check on a hit.
+		bool fullAlpha;
+		std::vector<u8> decoded;
+	};
+	bool CanUseDecodeCache(const VertexDecoder *dec, int count) const;
+	void DecodeVertsCached(const VertexDecoder *dec, const DeferredVerts &dv, const u8 *startPos, int count, u8 *dest);
+	void DecimateDecodeCache();
+	void ClearDecodeCache();
+
+	DenseHashMap<u64, DecodeCacheEntry *> decodeCache_;
+	size_t decodeCacheBytes_ = 0;
+	int decodeCacheFrame_ = 0;
+	bool useDecodeCache_ = false;
+	bool useTessCache_ = false;
+
 	const VertexDecoder *dec_ = nullptr;
 	u32 lastVType_ = -1;  // corresponds to dec_.  Could really just pick it out of dec_...
 	int numDrawVerts_ = 0;
@@ -351,6 +376,14 @@ class DrawEngineCommon {
 	int depthIndexCount_ = 0;
 	std::vector<DepthDraw> depthDraws_;
 
+	// Draws clipped into depthScreenVerts_, waiting to be rasterized.
+	struct ClippedDepthDraw {
+		int drawIndex;
+		int screenVertOffset;
+		int screenVertCount;
+	};
+	std::vector<ClippedDepthDraw> depthClipped_;
+
 	double rasterTimeStart_ = 0.0;
 
 	bool lastUseHwTransform_ = true;
@@ -19,7 +19,7 @@
 
 #include "ppsspp_config.h"
 
-#include "Common/Math/SIMDHeaders.h"
+#include "Common/Math/CrossSIMD.h"
 #include "GPU/Common/IndexGenerator.h"
 
 // Points don't need indexing...
@@ -45,11 +45,32 @@ void IndexGenerator::AddPrim(int prim, int vertexCount, int indexOffset, bool cl
 	}
 }
 
+alignas(16) static const u16 offsets_sequential[8] = {
+	0, 1, 2, 3, 4, 5, 6, 7,
+};
+
+// Points, line lists and rectangles all come out as indexOffset + 0, 1, 2, ...
+static u16 *AddSequential(u16 *outInds, int count, int indexOffset) {
+	int i = 0;
+#ifndef CROSSSIMD_SLOW
+	// 16 indices per iteration.
+	Vec8U16 ind0 = Vec8U16::Load(offsets_sequential) + Vec8U16::Splat(indexOffset);
+	Vec8U16 ind1 = ind0 + Vec8U16::Splat(8);
+	const Vec8U16 increment = Vec8U16::Splat(16);
+	for (; i + 16 <= count; i += 16) {
+		ind0.Store(outInds + i);
+		ind1.Store(outInds + i + 8);
+		ind0 += increment;
+		ind1 += increment;
+	}
+#endif
+	for (; i < count; i++)
+		outInds[i] = indexOffset + i;
+	return outInds + count;
+}
+
 void IndexGenerator::AddPoints(int numVerts, int indexOffset) {
-	u16 *outInds = inds_;
-	for (int i = 0; i < numVerts; i++)
-		*outInds++ = indexOffset + i;
-	inds_ = outInds;
+	inds_ = AddSequential(inds_, numVerts, indexOffset);
 }
 
 void IndexGenerator::AddList(int numVerts, int indexOffset, bool clockwise) {
@@ -91,62 +112,36 @@ void IndexGenerator::AddStrip(int numVerts, int indexOffset, bool clockwise) {
 	if (numTris <= 0) {
 		return;
 	}
-#ifdef _M_SSE
-	// In an SSE2 register we can fit 8 16-bit integers.
+#ifndef CROSSSIMD_SLOW
+	// In a 128-bit register we can fit 8 16-bit integers.
 	// However, we need to output a multiple of 3 indices.
 	// The first such multiple is 24, which means we'll generate 24 indices per cycle,
 	// which corresponds to 8 triangles. That's pretty cool.
 
 	// We allow ourselves to write some extra indices to avoid the fallback loop.
 	// That's alright as we're appending to a buffer - they will get overwritten anyway.
-	__m128i ibase8 = _mm_set1_epi16(indexOffset);
-	const __m128i *offsets = (const __m128i *)(clockwise ? offsets_clockwise : offsets_counter_clockwise);
-	__m128i *dst = (__m128i *)inds_;
-	__m128i offsets0 = _mm_add_epi16(ibase8, _mm_load_si128(offsets));
-	// A single store is always enough for two triangles, which is a very common case.
-	_mm_storeu_si128(dst, offsets0);
-	if (numTris > 2) {
-		__m128i offsets1 = _mm_add_epi16(ibase8, _mm_load_si128(offsets + 1));
-		_mm_storeu_si128(dst + 1, offsets1);
-		if (numTris > 5) {
-			__m128i offsets2 = _mm_add_epi16(ibase8, _mm_load_si128(offsets + 2));
-			_mm_storeu_si128(dst + 2, offsets2);
-			__m128i increment = _mm_set1_epi16(8);
-			int numChunks = (numTris + 7) >> 3;
-			for (int i = 1; i < numChunks; i++) {
-				dst += 3;
-				offsets0 = _mm_add_epi16(offsets0, increment);
-				offsets1 = _mm_add_epi16(offsets1, increment);
-				offsets2 = _mm_add_epi16(offsets2, increment);
-				_mm_storeu_si128(dst, offsets0);
-				_mm_storeu_si128(dst + 1, offsets1);
-				_mm_storeu_si128(dst + 2, offsets2);
-			}
-		}
-	}
-	inds_ += numTris * 3;
-#elif PPSSPP_ARCH(ARM_NEON)
-	uint16x8_t ibase8 = vdupq_n_u16(indexOffset);
+	const Vec8U16 ibase8 = Vec8U16::Splat(indexOffset);
 	const u16 *offsets = clockwise ? offsets_clockwise : offsets_counter_clockwise;
 	u16 *dst = inds_;
-	uint16x8_t offsets0 = vaddq_u16(ibase8, vld1q_u16(offsets));
-	vst1q_u16(dst, offsets0);
+	Vec8U16 offsets0 = ibase8 + Vec8U16::Load(offsets);
+	// A single store is always enough for two triangles, which is a very common case.
+	offsets0.Store(dst);
 	if (numTris > 2) {
-		uint16x8_t offsets1 = vaddq_u16(ibase8, vld1q_u16(offsets + 8));
-		vst1q_u16(dst + 8, offsets1);
+		Vec8U16 offsets1 = ibase8 + Vec8U16::Load(offsets + 8);
+		offsets1.Store(dst + 8);
 		if (numTris > 5) {
-			uint16x8_t offsets2 = vaddq_u16(ibase8, vld1q_u16(offsets + 16));
-			vst1q_u16(dst + 16, offsets2);
-			uint16x8_t increment = vdupq_n_u16(8);
+			Vec8U16 offsets2 = ibase8 + Vec8U16::Load(offsets + 16);
+			offsets2.Store(dst + 16);
+			const Vec8U16 increment = Vec8U16::Splat(8);
 			int numChunks = (numTris + 7) >> 3;
 			for (int i = 1; i < numChunks; i++) {
 				dst += 3 * 8;
-				offsets0 = vaddq_u16(offsets0, increment);
-				offsets1 = vaddq_u16(offsets1, increment);
-				offsets2 = vaddq_u16(offsets2, increment);
-				vst1q_u16(dst, offsets0);
-				vst1q_u16(dst + 8, offsets1);
-				vst1q_u16(dst + 16, offsets2);
+				offsets0 += increment;
+				offsets1 += increment;
+				offsets2 += increment;
+				offsets0.Store(dst);
+				offsets1.Store(dst + 8);
+				offsets2.Store(dst + 16);
 			}
 		}
 	}
@@ -177,13 +172,54 @@ void IndexGenerator::AddStrip(int numVerts, int indexOffset, bool clockwise) {
 #endif
 }
 
-// God of War uses this for text. Otherwise rare, not much reason to optimize.
+// Like the strip tables, 8 triangles per 24 indices. The first index of each stays at the center.
+alignas(16) static const u16 fan_offsets_clockwise[24] = {
+	0, 1, 2, 0, 2, 3, 0, 3,
+	4, 0, 4, 5, 0, 5, 6, 0,
+	6, 7, 0, 7, 8, 0, 8, 9,
+};
+
+alignas(16) static const u16 fan_offsets_counter_clockwise[24] = {
+	0, 2, 1, 0, 3, 2, 0, 4,
+	3, 0, 5, 4, 0, 6, 5, 0,
+	7, 6, 0, 8, 7, 0, 9, 8,
+};
+
+alignas(16) static const u16 fan_increments[24] = {
+	0, 8, 8, 0, 8, 8, 0, 8,
+	8, 0, 8, 8, 0, 8, 8, 0,
+	8, 8, 0, 8, 8, 0, 8, 8,
+};
+
+// God of War uses this for text, and some games use small fans for sprites.
 void IndexGenerator::AddFan(int numVerts, int indexOffset, bool clockwise) {
 	const int numTris = numVerts - 2;
 	u16 *outInds = inds_;
+	int i = 0;
+#ifndef CROSSSIMD_SLOW
+	if (numTris >= 8) {
+		const Vec8U16 ibase8 = Vec8U16::Splat(indexOffset);
+		const u16 *offsets = clockwise ? fan_offsets_clockwise : fan_offsets_counter_clockwise;
+		Vec8U16 offsets0 = ibase8 + Vec8U16::Load(offsets);
+		Vec8U16 offsets1 = ibase8 + Vec8U16::Load(offsets + 8);
+		Vec8U16 offsets2 = ibase8 + Vec8U16::Load(offsets + 16);
+		const Vec8U16 increment0 = Vec8U16::Load(fan_increments);
+		const Vec8U16 increment1 = Vec8U16::Load(fan_increments + 8);
+		const Vec8U16 increment2 = Vec8U16::Load(fan_increments + 16);
+		for (; i + 8 <= numTris; i += 8) {
+			offsets0.Store(outInds);
+			offsets1.Store(outInds + 8);
+			offsets2.Store(outInds + 16);
+			offsets0 += increment0;
+			offsets1 += increment1;
+			offsets2 += increment2;
+			outInds += 3 * 8;
+		}
+	}
+#endif
 	const int v1 = clockwise ? 1 : 2;
 	const int v2 = clockwise ? 2 : 1;
-	for (int i = 0; i < numTris; i++) {
+	for (; i < numTris; i++) {
 		*outInds++ = indexOffset;
 		*outInds++ = indexOffset + i + v1;
 		*outInds++ = indexOffset + i + v2;
@@ -193,13 +229,7 @@ void IndexGenerator::AddFan(int numVerts, int indexOffset, bool clockwise) {
 
 //Lines
 void IndexGenerator::AddLineList(int numVerts, int indexOffset) {
-	u16 *outInds = inds_;
-	numVerts &= ~1;
-	for (int i = 0; i < numVerts; i += 2) {
-		*outInds++ = indexOffset + i;
-		*outInds++ = indexOffset + i + 1;
-	}
-	inds_ = outInds;
+	inds_ = AddSequential(inds_, numVerts & ~1, indexOffset);
 }
 
 void IndexGenerator::AddLineStrip(int numVerts, int indexOffset) {
@@ -213,14 +243,8 @@ void IndexGenerator::AddLineStrip(int numVerts, int indexOffset) {
 }
 
 void IndexGenerator::AddRectangles(int numVerts, int indexOffset) {
-	u16 *outInds = inds_;
 	//rectangles always need 2 vertices, disregard the last one if there's an odd number
-	numVerts = numVerts & ~1;
-	for (int i = 0; i < numVerts; i += 2) {
-		*outInds++ = indexOffset + i;
-		*outInds++ = indexOffset + i + 1;
-	}
-	inds_ = outInds;
+	inds_ = AddSequential(inds_, numVerts & ~1, indexOffset);
 }
 
 template <class ITypeLE>
@@ -278,14 +302,45 @@ void IndexGenerator::TranslateList(int numInds, const ITypeLE *inds, int indexOf
 
 template <class ITypeLE>
 void IndexGenerator::TranslateStrip(int numInds, const ITypeLE *inds, int indexOffset, bool clockwise) {
-	int wind = clockwise ? 1 : 2;
-	int numTris = numInds - 2;
+	const int numTris = numInds - 2;
 	u16 *outInds = inds_;
-	for (int i = 0; i < numTris; i++) {
+	int i = 0;
+	// Two triangles at a time, so the winding doesn't flip inside the loop.
+	if (clockwise) {
+		for (; i + 2 <= numTris; i += 2) {
+			const u16 i0 = indexOffset + inds[i];
+			const u16 i1 = indexOffset + inds[i + 1];
+			const u16 i2 = indexOffset + inds[i + 2];
+			const u16 i3 = indexOffset + inds[i + 3];
+			outInds[0] = i0;
+			outInds[1] = i1;
+			outInds[2] = i2;
+			outInds[3] = i1;
+			outInds[4] = i3;
+			outInds[5] = i2;
+			outInds += 6;
+		}
+	} else {
+		for (; i + 2 <= numTris; i += 2) {
+			const u16 i0 = indexOffset + inds[i];
+			const u16 i1 = indexOffset + inds[i + 1];
+			const u16 i2 = indexOffset + inds[i + 2];
+			const u16 i3 = indexOffset + inds[i + 3];
+			outInds[0] = i0;
+			outInds[1] = i2;
+			outInds[2] = i1;
+			outInds[3] = i1;
+			outInds[4] = i2;
+			outInds[5] = i3;
+			outInds += 6;
+		}
+	}
+	if (i < numTris) {
+		// Odd one out, with the starting winding since i is even.
+		const int wind = clockwise ? 1 : 2;
 		*outInds++ = indexOffset + inds[i];
 		*outInds++ = indexOffset + inds[i + wind];
-		wind ^= 3;  // Toggle between 1 and 2
-		*outInds++ = indexOffset + inds[i + wind];
+		*outInds++ = indexOffset + inds[i + (wind ^ 3)];
 	}
 	inds_ = outInds;
 }
@@ -16,9 +16,17 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
 #include "Common/Common.h"
 #include "Common/CPUDetect.h"
 #include "Common/Profiler/Profiler.h"
+#include "Common/Thread/ParallelLoop.h"
+#include "Common/Thread/ThreadManager.h"
+#include "ext/xxhash.h"
 #include "GPU/Common/SplineCommon.h"
 #include "GPU/Common/DrawEngineCommon.h"
 #include "GPU/Common/SoftwareTransformCommon.h"
@@ -277,6 +285,11 @@ class Spline3DWeight {
 WeightCache<Bezier3DWeight> Bezier3DWeight::weightsCache;
 WeightCache<Spline3DWeight> Spline3DWeight::weightsCache;
 
+// Below this, it's faster to just tessellate on the GPU thread.
+static const int TESS_PARALLEL_MIN_VERTS = 4096;
+// Roughly how much each task should get, so the overhead stays small.
+static const int TESS_ROW_MIN_VERTS = 1024;
+
 // Tessellate single patch (4x4 control points)
 template<typename T>
 class Tessellator {
@@ -341,9 +354,17 @@ class SubdivisionSurface {
 		const float inv_u = 1.0f / (float)surface.tess_u;
 		const float inv_v = 1.0f / (float)surface.tess_v;
 
-		for (int patch_u = 0; patch_u < surface.num_patches_u; ++patch_u) {
-			const int start_u = surface.GetTessStart(patch_u);
-			for (int patch_v = 0; patch_v < surface.num_patches_v; ++patch_v) {
+		// Each row of a patch (one tile_u) is a separate unit of work, so even a single patch with a
+		// high tessellation level can be split up.  Every vertex is written by exactly one row.
+		const int rowsPerPatch = surface.tess_u + 1;
+		auto tessellateRows = [&](int lower, int upper) {
+			for (int row = lower; row < upper; ++row) {
+				const int tile_u = row % rowsPerPatch;
+				const int patch = row / rowsPerPatch;
+				const int patch_u = patch / surface.num_patches_v;
+				const int patch_v = patch % surface.num_patches_v;
+				if (tile_u < surface.GetTessStart(patch_u))
+					continue;
 				const int start_v = surface.GetTessStart(patch_v);
 
 				// Prepare 4x4 control points to tessellate
@@ -354,53 +375,59 @@ class SubdivisionSurface {
 				Tessellator<Vec2f> tess_tex(points.tex, idx_v);
 				Tessellator<Vec3f> tess_nrm(points.pos, idx_v);
 
-				for (int tile_u = start_u; tile_u <= surface.tess_u; ++tile_u) {
-					const int index_u = surface.GetIndexU(patch_u, tile_u);
-					const Weight &wu = weights.u[index_u];
-
-					// Pre-tessellate U lines
-					tess_pos.SampleU(wu.basis);
-					if constexpr (sampleCol)
-						tess_col.SampleU(wu.basis);
-					if constexpr (sampleTex)
-						tess_tex.SampleU(wu.basis);
-					if constexpr (sampleNrm)
-						tess_nrm.SampleU(wu.deriv);
-
-					for (int tile_v = start_v; tile_v <= surface.tess_v; ++tile_v) {
-						const int index_v = surface.GetIndexV(patch_v, tile_v);
-						const Weight &wv = weights.v[index_v];
-
-						SimpleVertex &vert = output.vertices[surface.GetIndex(index_u, index_v, patch_u, patch_v)];
-
-						// Tessellate
-						vert.pos = tess_pos.SampleV(wv.basis);
-						if constexpr (sampleCol) {
-							vert.color_32 = tess_col.SampleV(wv.basis).ToRGBA();
-						} else {
-							vert.color_32 = points.defcolor;
-						}
-						if constexpr (sampleTex) {
-							tess_tex.SampleV(wv.basis).Write(vert.uv);
-						} else {
-							// Generate texcoord
-							vert.uv[0] = patch_u + tile_u * inv_u;
-							vert.uv[1] = patch_v + tile_v * inv_v;
-						}
-						if constexpr (sampleNrm) {
-							const Vec3f derivU = tess_nrm.SampleV(wv.basis);
-							const Vec3f derivV = tess_pos.SampleV(wv.deriv);
-
-							vert.nrm = Cross(derivU, derivV).Normalized(useSSE4);
-							if constexpr (patchFacing)
-								vert.nrm *= -1.0f;
-						} else {
-							vert.nrm.SetZero();
-							vert.nrm.z = 1.0f;
-						}
+				const int index_u = surface.GetIndexU(patch_u, tile_u);
+				const Weight &wu = weights.u[index_u];
+
+				// Pre-tessellate U lines
+				tess_pos.SampleU(wu.basis);
+				if constexpr (sampleCol)
+					tess_col.SampleU(wu.basis);
+				if constexpr (sampleTex)
+					tess_tex.SampleU(wu.basis);
+				if constexpr (sampleNrm)
+					tess_nrm.SampleU(wu.deriv);
+
+				for (int tile_v = start_v; tile_v <= surface.tess_v; ++tile_v) {
+					const int index_v = surface.GetIndexV(patch_v, tile_v);
+					const Weight &wv = weights.v[index_v];
+
+					SimpleVertex &vert = output.vertices[surface.GetIndex(index_u, index_v, patch_u, patch_v)];
+
+					// Tessellate
+					vert.pos = tess_pos.SampleV(wv.basis);
+					if constexpr (sampleCol) {
+						vert.color_32 = tess_col.SampleV(wv.basis).ToRGBA();
+					} else {
+						vert.color_32 = points.defcolor;
+					}
+					if constexpr (sampleTex) {
+						tess_tex.SampleV(wv.basis).Write(vert.uv);
+					} else {
+						// Generate texcoord
+						vert.uv[0] = patch_u + tile_u * inv_u;
+						vert.uv[1] = patch_v + tile_v * inv_v;
+					}
+					if constexpr (sampleNrm) {
+						const Vec3f derivU = tess_nrm.SampleV(wv.basis);
+						const Vec3f derivV = tess_pos.SampleV(wv.deriv);
+
+						vert.nrm = Cross(derivU, derivV).Normalized(useSSE4);
+						if constexpr (patchFacing)
+							vert.nrm *= -1.0f;
+					} else {
+						vert.nrm.SetZero();
+						vert.nrm.z = 1.0f;
 					}
 				}
 			}
+		};
+
+		const int numRows = surface.num_patches_u * surface.num_patches_v * rowsPerPatch;
+		const int vertsPerRow = surface.tess_v + 1;
+		if (numRows * vertsPerRow >= TESS_PARALLEL_MIN_VERTS) {
+			ParallelRangeLoop(&g_threadManager, tessellateRows, 0, numRows, std::max(1, TESS_ROW_MIN_VERTS / vertsPerRow));
+		} else {
+			tessellateRows(0, numRows);
 		}
 
 		surface.BuildIndex(output.indices, output.count);
@@ -437,6 +464,64 @@ void SoftwareTessellation(OutputBuffers &output, const Surface &surface, u32 ori
 template void SoftwareTessellation<BezierSurface>(OutputBuffers &output, const BezierSurface &surface, u32 origVertType, const ControlPoints &points);
 template void SoftwareTessellation<SplineSurface>(OutputBuffers &output, const SplineSurface &surface, u32 origVertType, const ControlPoints &points);
 
+bool TessellationCache::Lookup(const TessCacheKey &key, OutputBuffers &output, int numVerts, u32 *vertType) {
+	Decimate();
+	auto it = cache_.find(Hash(key));
+	if (it == cache_.end() || memcmp(&it->second.key, &key, sizeof(key)) != 0)
+		return false;
+	Entry &entry = it->second;
+	if ((int)entry.vertices.size() != numVerts)
+		return false;
+	memcpy(output.vertices, entry.vertices.data(), numVerts * sizeof(SimpleVertex));
+	memcpy(output.indices, entry.indices.data(), entry.indices.size() * sizeof(u16));
+	output.count = (int)entry.indices.size();
+	*vertType = entry.vertType;
+	entry.lastFrame = frame_;
+	return true;
+}
+
+void TessellationCache::Store(const TessCacheKey &key, const OutputBuffers &output, int numVerts, u32 vertType) {
+	const size_t bytes = numVerts * sizeof(SimpleVertex) + output.count * sizeof(u16);
+	Entry &entry = cache_[Hash(key)];
+	bytes_ -= entry.Bytes();
+	if (bytes_ + bytes > maxBytes_) {
+		cache_.erase(Hash(key));
+		return;
+	}
+	entry.key = key;
+	entry.vertType = vertType;
+	entry.vertices.assign(output.vertices, output.vertices + numVerts);
+	entry.indices.assign(output.indices, output.indices + output.count);
+	entry.lastFrame = frame_;
+	bytes_ += bytes;
+}
+
+void TessellationCache::Clear() {
+	cache_.clear();
+	bytes_ = 0;
+}
+
+u64 TessellationCache::Hash(const TessCacheKey &key) {
+	return XXH3_64bits(&key, sizeof(key));
+}
+
+void TessellationCache::Decimate() {
+	const int frame = gpuStats.totals.numFlips;
+	if (frame == frame_)
+		return;
+	frame_ = frame;
+	for (auto it = cache_.begin(); it != cache_.end(); ) {
+		if (it->second.lastFrame + DECIMATE_AGE < frame_ || it->second.lastFrame > frame_) {
+			bytes_ -= it->second.Bytes();
+			it = cache_.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+static TessellationCache tessCache;
+
 } // namespace Spline
 
 using namespace Spline;
@@ -444,6 +529,7 @@ using namespace Spline;
 void DrawEngineCommon::ClearSplineBezierWeights() {
 	Bezier3DWeight::weightsCache.Clear();
 	Spline3DWeight::weightsCache.Clear();
+	tessCache.Clear();
 }
 
 // Specialize to make instance (to avoid link error).
@@ -473,56 +559,77 @@ void DrawEngineCommon::SubmitCurve(const void *control_points, const void *indic
 	VertexDecoder *origVDecoder = GetVertexDecoder(vertTypeID);
 	*bytesRead = num_points * origVDecoder->VertexSize();
 
-	// Simplify away bones and morph before proceeding
-	// There are normally not a lot of control points so just splitting decoded should be reasonably safe, although not great.
-	SimpleVertex *simplified_control_points = (SimpleVertex *)managedBuf.Allocate(sizeof(SimpleVertex) * (index_upper_bound + 1));
-	if (!simplified_control_points) {
-		ERROR_LOG(Log::G3D, "Failed to allocate space for simplified control points, skipping curve draw");
-		return;
-	}
-
-	u8 *temp_buffer = managedBuf.Allocate(sizeof(SimpleVertex) * num_points);
-	if (!temp_buffer) {
-		ERROR_LOG(Log::G3D, "Failed to allocate space for temp buffer, skipping curve draw");
-		return;
-	}
+	OutputBuffers output;
+	output.vertices = (SimpleVertex *)(decoded_ + DECODED_VERTEX_BUFFER_SIZE / 2);
+	output.indices = decIndex_;
+	output.count = 0;
 
-	const u32 origVertType = vertType;
-	UVScale neutralUVScale{1.0f, 1.0f, 0.0f, 0.0f};  // Avoid rescaling UV during normalization, it will happen anyway later (in DispatchSubmitPrim). Although ideally we should avoid running Decode at all there.
-	vertType = ::NormalizeVertices(simplified_control_points, temp_buffer, (u8 *)control_points, index_lower_bound, index_upper_bound, neutralUVScale, origVDecoder, vertType);
+	const int maxVerts = DECODED_VERTEX_BUFFER_SIZE / 2 / sizeof(SimpleVertex);
 
-	VertexDecoder *vdecoder = GetVertexDecoder(vertType);
+	surface.Init(maxVerts);
 
-	int vertexSize = vdecoder->VertexSize();
-	if (vertexSize != sizeof(SimpleVertex)) {
-		ERROR_LOG(Log::G3D, "Something went really wrong, vertex size: %d vs %d", vertexSize, (int)sizeof(SimpleVertex));
+	// Skinning and morphing depend on more than the control points, so those are always tessellated.
+	const bool useCache = useTessCache_ && (vertType & (GE_VTYPE_WEIGHT_MASK | GE_VTYPE_MORPHCOUNT_MASK | GE_VTYPE_THROUGH_MASK)) == 0;
+	TessCacheKey cacheKey{};
+	if (useCache) {
+		const int vertexSize = origVDecoder->VertexSize();
+		cacheKey.dataHash = XXH3_64bits((const u8 *)control_points + index_lower_bound * vertexSize, (index_upper_bound - index_lower_bound + 1) * vertexSize);
+		if (indices)
+			cacheKey.dataHash = XXH3_64bits_withSeed(indices, num_points * IndexSize(vertType), cacheKey.dataHash);
+
+		cacheKey.vertTypeID = vertTypeID;
+		cacheKey.materialAmbient = gstate.getMaterialAmbientRGBA();
+		cacheKey.lighting = gstate.isLightingEnabled();
+		cacheKey.bounds = index_lower_bound | (index_upper_bound << 16);
+		cacheKey.tess = surface.tess_u | (surface.tess_v << 8) | (surface.num_points_u << 16) | (surface.num_points_v << 24);
+		cacheKey.types = surface.type_u | (surface.type_v << 8) | (surface.primType << 16) | (surface.patchFacing << 24);
 	}
 
-	// Make an array of pointers to the control points, to get rid of indices.
-	const SimpleVertex **points = (const SimpleVertex **)managedBuf.Allocate(sizeof(SimpleVertex *) * num_points);
-	if (!points) {
-		ERROR_LOG(Log::G3D, "Failed to allocate space for control point pointers, skipping curve draw");
-		return;
-	}
-	for (int idx = 0; idx < num_points; idx++) {
-		points[idx] = simplified_control_points + (indices ? ConvertIndex(idx) : idx);
-	}
+	if (!useCache || !tessCache.Lookup(cacheKey, output, surface.GetNumVertices(), &vertType)) {
+		// Simplify away bones and morph before proceeding
+		// There are normally not a lot of control points so just splitting decoded should be reasonably safe, although not great.
+		SimpleVertex *simplified_control_points = (SimpleVertex *)managedBuf.Allocate(sizeof(SimpleVertex) * (index_upper_bound + 1));
+		if (!simplified_control_points) {
+			ERROR_LOG(Log::G3D, "Failed to allocate space for simplified control points, skipping curve draw");
+			return;
+		}
 
-	OutputBuffers output;
-	output.vertices = (SimpleVertex *)(decoded_ + DECODED_VERTEX_BUFFER_SIZE / 2);
-	output.indices = decIndex_;
-	output.count = 0;
+		u8 *temp_buffer = managedBuf.Allocate(sizeof(SimpleVertex) * num_points);
+		if (!temp_buffer) {
+			ERROR_LOG(Log::G3D, "Failed to allocate space for temp buffer, skipping curve draw");
+			return;
+		}
 
-	const int maxVerts = DECODED_VERTEX_BUFFER_SIZE / 2 / vertexSize;
+		const u32 origVertType = vertType;
+		UVScale neutralUVScale{1.0f, 1.0f, 0.0f, 0.0f};  // Avoid rescaling UV during normalization, it will happen anyway later (in DispatchSubmitPrim). Although ideally we should avoid running Decode at all there.
+		vertType = ::NormalizeVertices(simplified_control_points, temp_buffer, (u8 *)control_points, index_lower_bound, index_upper_bound, neutralUVScale, origVDecoder, vertType);
 
-	surface.Init(maxVerts);
+		VertexDecoder *vdecoder = GetVertexDecoder(vertType);
 
-	ControlPoints cpoints(points, num_points, managedBuf);
-	if (cpoints.IsValid()) {
-		// Run the tessellation!
-		SoftwareTessellation(output, surface, origVertType, cpoints);
-	} else {
-		ERROR_LOG(Log::G3D, "Failed to allocate space for control point values, skipping curve draw");
+		int vertexSize = vdecoder->VertexSize();
+		if (vertexSize != sizeof(SimpleVertex)) {
+			ERROR_LOG(Log::G3D, "Something went really wrong, vertex size: %d vs %d", vertexSize, (int)sizeof(SimpleVertex));
+		}
+
+		// Make an array of pointers to the control points, to get rid of indices.
+		const SimpleVertex **points = (const SimpleVertex **)managedBuf.Allocate(sizeof(SimpleVertex *) * num_points);
+		if (!points) {
+			ERROR_LOG(Log::G3D, "Failed to allocate space for control point pointers, skipping curve draw");
+			return;
+		}
+		for (int idx = 0; idx < num_points; idx++) {
+			points[idx] = simplified_control_points + (indices ? ConvertIndex(idx) : idx);
+		}
+
+		ControlPoints cpoints(points, num_points, managedBuf);
+		if (cpoints.IsValid()) {
+			// Run the tessellation!
+			SoftwareTessellation(output, surface, origVertType, cpoints);
+			if (useCache && output.count)
+				tessCache.Store(cacheKey, output, surface.GetNumVertices(), vertType);
+		} else {
+			ERROR_LOG(Log::G3D, "Failed to allocate space for control point values, skipping curve draw");
+		}
 	}
 
 	u32 vertTypeWithIndex16 = (vertType & ~GE_VTYPE_IDX_MASK) | GE_VTYPE_IDX_16BIT;
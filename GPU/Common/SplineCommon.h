@@ -17,6 +17,7 @@
 
 #pragma once
 #include <unordered_map>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 #include "Common/Swap.h"
@@ -85,6 +86,8 @@ struct BezierSurface : public SurfaceInfo {
 		num_verts_per_patch = (tess_u + 1) * (tess_v + 1);
 	}
 
+	int GetNumVertices() const { return num_verts_per_patch * num_patches_u * num_patches_v; }
+
 	int GetTessStart(int patch) const { return 0; }
 
 	int GetPointIndex(int patch_u, int patch_v) const { return patch_v * 3 * num_points_u + patch_u * 3; }
@@ -123,6 +126,8 @@ struct SplineSurface : public SurfaceInfo {
 		num_vertices_u = num_patches_u * tess_u + 1;
 	}
 
+	int GetNumVertices() const { return num_vertices_u * (num_patches_v * tess_v + 1); }
+
 	int GetTessStart(int patch) const { return (patch == 0) ? 0 : 1; }
 
 	int GetPointIndex(int patch_u, int patch_v) const { return patch_v * num_points_u + patch_u; }
@@ -197,6 +202,55 @@ struct OutputBuffers {
 template<class Surface>
 void SoftwareTessellation(OutputBuffers &output, const Surface &surface, u32 origVertType, const ControlPoints &points);
 
+// Everything the tessellated output depends on.  All u32 so there's no padding to compare.
+struct TessCacheKey {
+	u64 dataHash;  // Control points and indices.
+	u32 vertTypeID;
+	u32 materialAmbient;  // Color of control points without one.
+	u32 lighting;  // Whether normals are generated.
+	u32 bounds;
+	u32 tess;
+	u32 types;
+};
+
+// Keeps the output of curves whose control points don't change between frames, which is most of them.
+// Only used when the TessellationCache setting is on.
+class TessellationCache {
+public:
+	explicit TessellationCache(size_t maxBytes = 16 * 1024 * 1024) : maxBytes_(maxBytes) {}
+
+	bool Lookup(const TessCacheKey &key, OutputBuffers &output, int numVerts, u32 *vertType);
+	void Store(const TessCacheKey &key, const OutputBuffers &output, int numVerts, u32 vertType);
+	void Clear();
+
+	size_t Bytes() const { return bytes_; }
+	size_t Count() const { return cache_.size(); }
+
+	// Entries not drawn with for this many frames are dropped.
+	static const int DECIMATE_AGE = 120;
+
+private:
+	struct Entry {
+		TessCacheKey key;
+		u32 vertType;
+		std::vector<SimpleVertex> vertices;
+		std::vector<u16> indices;
+		int lastFrame;
+
+		size_t Bytes() const {
+			return vertices.size() * sizeof(SimpleVertex) + indices.size() * sizeof(u16);
+		}
+	};
+
+	static u64 Hash(const TessCacheKey &key);
+	void Decimate();
+
+	std::unordered_map<u64, Entry> cache_;
+	size_t maxBytes_;
+	size_t bytes_ = 0;
+	int frame_ = 0;
+};
+
 } // namespace Spline
 
 // Define function object for TemplateParameterDispatcher
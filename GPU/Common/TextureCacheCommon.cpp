@@ -30,9 +30,13 @@
 #include "Common/Math/SIMDHeaders.h"
 #include "Common/TimeUtil.h"
 #include "Common/Math/math_util.h"
+#include "Common/Thread/ParallelLoop.h"
+#include "Common/Thread/Promise.h"
+#include "Common/Thread/ThreadManager.h"
 #include "Common/GPU/thin3d.h"
 #include "Core/HDRemaster.h"
 #include "Core/Config.h"
+#include "Core/ELF/ParamSFO.h"
 #include "Core/Debugger/MemBlockInfo.h"
 #include "Core/System.h"
 #include "Core/HW/Display.h"
@@ -111,6 +115,10 @@ TextureCacheCommon::TextureCacheCommon(Draw::DrawContext *draw, Draw2D *draw2D)
 	// These buffers will grow if necessary, but most won't need more than this.
 	tmpTexBuf32_.resize(512 * 512);  // 1MB
 	tmpTexBufRearrange_.resize(512 * 512);   // 1MB
+
+	if (g_Config.bTexScalingDiskCache) {
+		scalerDiskCache_.Start(g_paramSFO.GetDiscID());
+	}
 }
 
 TextureCacheCommon::~TextureCacheCommon() {
@@ -165,6 +173,7 @@ void TextureCacheCommon::StartFrame() {
 	} else {
 		Decimate(nullptr, false);
 	}
+	DecimateAsyncScaling();
 }
 
 // Produces a signed 1.23.8 value.
@@ -386,6 +395,26 @@ SamplerCacheKey GetFramebufferSamplingParams(const GEState &gstate, u16 bufferWi
 	return key;
 }
 
+// Big textures (mostly videos and 512x512 ones) are hashed in chunks on several threads, and then the
+// chunk hashes are hashed together. Gives a different result than hashing it all at once, but this
+// hash is only used within the cache, the replacer has its own.
+static const u32 TEXHASH_PARALLEL_MIN_BYTES = 256 * 1024;
+static const u32 TEXHASH_MAX_CHUNKS = 256;
+
+static u32 ParallelQuickTexHash(const u32 *checkp, u32 size) {
+	// Keep the chunks 64-byte multiples, so each takes the SIMD path.
+	const u32 chunkSize = std::max(64 * 1024U, ((size / TEXHASH_MAX_CHUNKS) + 63) & ~63U);
+	const int numChunks = (int)((size + chunkSize - 1) / chunkSize);
+	u32 chunkHashes[TEXHASH_MAX_CHUNKS];
+	ParallelRangeLoop(&g_threadManager, [&](int lower, int upper) {
+		for (int i = lower; i < upper; i++) {
+			const u32 offset = chunkSize * i;
+			chunkHashes[i] = StableQuickTexHash((const u8 *)checkp + offset, std::min(chunkSize, size - offset));
+		}
+	}, 0, numChunks, 2);
+	return (u32)XXH3_64bits(chunkHashes, numChunks * sizeof(u32));
+}
+
 static u32 ComputeTextureHash(TextureReplacer &replacer, u32 addr, int bufw, int w, int h, bool swizzled, const TexCacheEntry *entry) {
 	const GETextureFormat format = entry->format;
 	if (replacer.Enabled()) {
@@ -414,6 +443,9 @@ static u32 ComputeTextureHash(TextureReplacer &replacer, u32 addr, int bufw, int
 		gpuStats.perFrame.numTextureDataBytesHashed += sizeInRAM;
 
 		// return XXH64(checkp, sizeInRAM, 0xBACD7814);
+		if (sizeInRAM >= TEXHASH_PARALLEL_MIN_BYTES) {
+			return ParallelQuickTexHash(checkp, sizeInRAM);
+		}
 		return StableQuickTexHash(checkp, sizeInRAM);
 	} else {
 		return 0;
@@ -578,6 +610,12 @@ TextureApplyResult TextureCacheCommon::ApplyTexture(bool doBind) {
 
 	TexCache::iterator entryIter = cache_.find(cachekey);
 
+	// If the contents get hashed below and turn out changed, the new entry can reuse that hash
+	// instead of reading the whole texture again. That's every use of a video texture.
+	bool haveNewHash = false;
+	u32 newHash = 0;
+	u16 newHashMaxSeenV = 0;
+
 	// Note: It's necessary to reset needshadertexclamp, for otherwise DIRTY_TEXCLAMP won't get set later.
 	// Should probably revisit how this works..
 	gstate_c.SetNeedShaderTexclamp(false);
@@ -615,6 +653,12 @@ TextureApplyResult TextureCacheCommon::ApplyTexture(bool doBind) {
 			reason = "scaling";
 		}
 
+		if (match && (entry->status & TexStatus::SCALING_ASYNC) && AsyncScaleFinished(entry)) {
+			DEBUG_LOG(Log::TexCache, "%08x: Reloading texture to apply the scaling done in the background", texaddr);
+			match = false;
+			reason = "scaled";
+		}
+
 		if (match && (entry->status & TexStatus::TO_REPLACE) && replacementTimeThisFrame_ < replacementFrameBudgetSeconds_) {
 			int w0 = gstate.getTextureWidth(0);
 			int h0 = gstate.getTextureHeight(0);
@@ -706,6 +750,9 @@ TextureApplyResult TextureCacheCommon::ApplyTexture(bool doBind) {
 				if (newFullHash != entry->fullhash) {
 					// The texture changed. Throw it in the secondary cache. Then we'll create a new entry later.
 					gpuStats.perFrame.numTexturesChanged++;
+					haveNewHash = true;
+					newHash = newFullHash;
+					newHashMaxSeenV = entry->maxSeenV;
 					if (!isVideo) {
 						DEBUG_LOG(Log::TexCache, "%08x: Texture hash not matching: old %08x vs new %08x, reloading (%s) (w=%d h=%d maxSeenV=%d)", entry->addr, entry->fullhash, newFullHash, reason, w, h, entry->maxSeenV);
 					}
@@ -903,7 +950,12 @@ TextureApplyResult TextureCacheCommon::ApplyTexture(bool doBind) {
 
 	// TODO: Avoid hashing known video textures.
 	if (!(entry->status & TexStatus::IS_PPGE_ATLAS)) {
-		entry->fullhash = ComputeTextureHash(replacer_, entry->addr, entry->bufw, w, h, swizzled, entry);
+		// maxSeenV only affects the hashed range for 512-high textures.
+		if (haveNewHash && (h != 512 || entry->maxSeenV == newHashMaxSeenV)) {
+			entry->fullhash = newHash;
+		} else {
+			entry->fullhash = ComputeTextureHash(replacer_, entry->addr, entry->bufw, w, h, swizzled, entry);
+		}
 	}
 
 	VERBOSE_LOG(Log::TexCache, "%08x: Creating new texture, hash %08x (maxSeenV=%d), w: %d h: %d, creating", texaddr, entry->fullhash, entry->maxSeenV, w, h);
@@ -1484,6 +1536,15 @@ void TextureCacheCommon::NotifyConfigChanged() {
 	}
 
 	standardScaleFactor_ = scaleFactor;
+	// Anything in flight was scaled with the old settings.
+	asyncScaleJobs_.clear();
+	if (g_Config.bTexScalingDiskCache != scalerDiskCache_.Enabled()) {
+		if (g_Config.bTexScalingDiskCache) {
+			scalerDiskCache_.Start(g_paramSFO.GetDiscID());
+		} else {
+			scalerDiskCache_.Stop();
+		}
+	}
 
 	replacer_.NotifyConfigChanged();
 }
@@ -1819,6 +1880,130 @@ void TextureCacheCommon::PollReplacement(TexCacheEntry *entry, int *w, int *h, i
 	}
 }
 
+static void ScaleNearest(u32 *out, const u32 *src, int w, int h, int factor) {
+	const int outW = w * factor;
+	for (int y = 0; y < h; y++) {
+		u32 *row = out + outW * y * factor;
+		for (int x = 0; x < w; x++) {
+			const u32 color = src[y * w + x];
+			for (int i = 0; i < factor; i++) {
+				row[x * factor + i] = color;
+			}
+		}
+		for (int i = 1; i < factor; i++) {
+			memcpy(row + outW * i, row, outW * sizeof(u32));
+		}
+	}
+}
+
+// src must be packed (pitch w). Only level 0 is ever scaled, since we generate the mips of scaled textures.
+void TextureCacheCommon::ScaleTexture(TexCacheEntry &entry, u32 *out, u32 *src, int w, int h, int *scaledW, int *scaledH, int factor) {
+	u64 diskKey = 0;
+	bool onDisk = false;
+	if (scalerDiskCache_.Enabled()) {
+		diskKey = TextureScalerDiskCache::ComputeKey(src, w, h, factor);
+		onDisk = scalerDiskCache_.Contains(diskKey);
+	}
+
+	if (g_Config.bTexAsyncScaling && w * h >= TEXCACHE_MIN_ASYNC_SCALE_TEXELS) {
+		const u64 cacheKey = entry.CacheKey();
+		auto iter = asyncScaleJobs_.find(cacheKey);
+		if (iter != asyncScaleJobs_.end()) {
+			const AsyncScaleJob &job = *iter->second;
+			if (job.fullhash == entry.fullhash && job.w == w && job.h == h && job.factor == factor) {
+				if (job.done) {
+					*scaledW = job.scaledW;
+					*scaledH = job.scaledH;
+					memcpy(out, job.output.data(), job.scaledW * job.scaledH * sizeof(u32));
+					if (job.diskFileBad) {
+						scalerDiskCache_.Forget(job.diskKey);
+					}
+					if (job.diskKey != 0 && !job.fromDisk) {
+						scalerDiskCache_.Save(job.diskKey, job.output.data(), job.scaledW, job.scaledH);
+					}
+					entry.status &= ~TexStatus::SCALING_ASYNC;
+					asyncScaleJobs_.erase(iter);
+					return;
+				}
+				// Still busy, keep using the placeholder.
+				*scaledW = w * factor;
+				*scaledH = h * factor;
+				ScaleNearest(out, src, w, h, factor);
+				entry.status |= TexStatus::SCALING_ASYNC;
+				return;
+			}
+			// The texture changed since. If it's still running, the worker keeps the job alive until it's done.
+			asyncScaleJobs_.erase(iter);
+		}
+
+		if (asyncScaleJobs_.size() < TEXCACHE_MAX_ASYNC_SCALE_JOBS) {
+			std::shared_ptr<AsyncScaleJob> job = std::make_shared<AsyncScaleJob>();
+			job->fullhash = entry.fullhash;
+			job->w = w;
+			job->h = h;
+			job->factor = factor;
+			job->frame = gpuStats.totals.numFlips;
+			job->input.assign(src, src + w * h);
+			job->diskKey = diskKey;
+			if (onDisk) {
+				job->diskFilename = scalerDiskCache_.FilenameForKey(diskKey);
+			}
+			asyncScaleJobs_[cacheKey] = job;
+
+			// The scaler waits on its own parallel loops, so this can't go on a compute thread.
+			// Reading from the disk cache also happens here, so it doesn't stall the GPU thread.
+			g_threadManager.EnqueueTask(new IndependentTask(TaskType::IO_BLOCKING, TaskPriority::LOW, [job]() {
+				job->output.resize(job->w * job->factor * job->h * job->factor);
+				if (!job->diskFilename.empty() && TextureScalerDiskCache::LoadFile(job->diskFilename, job->diskKey, job->output.data(), job->w, job->h, job->factor, &job->diskFileBad)) {
+					job->scaledW = job->w * job->factor;
+					job->scaledH = job->h * job->factor;
+					job->fromDisk = true;
+				} else {
+					TextureScalerCommon scaler;
+					scaler.ScaleAlways(job->output.data(), job->input.data(), job->w, job->h, &job->scaledW, &job->scaledH, job->factor);
+				}
+				job->done = true;
+			}));
+
+			*scaledW = w * factor;
+			*scaledH = h * factor;
+			ScaleNearest(out, src, w, h, factor);
+			entry.status |= TexStatus::SCALING_ASYNC;
+			return;
+		}
+	}
+
+	// Small textures, or too many jobs in flight already.
+	entry.status &= ~TexStatus::SCALING_ASYNC;
+	if (onDisk && scalerDiskCache_.Load(diskKey, out, w, h, factor)) {
+		*scaledW = w * factor;
+		*scaledH = h * factor;
+		return;
+	}
+	scaler_.ScaleAlways(out, src, w, h, scaledW, scaledH, factor);
+	if (diskKey != 0) {
+		scalerDiskCache_.Save(diskKey, out, *scaledW, *scaledH);
+	}
+}
+
+bool TextureCacheCommon::AsyncScaleFinished(const TexCacheEntry *entry) const {
+	auto iter = asyncScaleJobs_.find(entry->CacheKey());
+	// If it's gone, rebuilding will start it again (or scale right away.)
+	return iter == asyncScaleJobs_.end() || iter->second->done;
+}
+
+void TextureCacheCommon::DecimateAsyncScaling() {
+	// Results nobody picked up, probably because the texture was evicted or never used again.
+	const int killAgeBase = 60;
+	for (auto iter = asyncScaleJobs_.begin(); iter != asyncScaleJobs_.end(); ) {
+		if (iter->second->frame + killAgeBase < gpuStats.totals.numFlips) {
+			iter = asyncScaleJobs_.erase(iter);
+		} else {
+			++iter;
+		}
+	}
+}
+
 // This is only used in the GLES backend, where we don't point these to video memory.
 // So we shouldn't add a check for dstBuf != srcBuf, as long as the functions we call can handle that.
 static void ReverseColors(void *dstBuf, const void *srcBuf, GETextureFormat fmt, int numPixels) {
@@ -2691,6 +2876,7 @@ void TextureCacheCommon::Clear(bool delete_them) {
 		secondCache_.clear();
 	}
 	videos_.clear();
+	asyncScaleJobs_.clear();
 
 	if (dynamicClutFbo_) {
 		dynamicClutFbo_->Release();
@@ -2875,7 +3061,8 @@ bool TextureCacheCommon::PrepareBuildTexture(BuildTexturePlan &plan, TexCacheEnt
 	}
 
 	if (plan.scaleFactor != 1) {
-		if (texelsScaledThisFrame_ >= TEXCACHE_MAX_TEXELS_SCALED && plan.slowScaler) {
+		// With async scaling, the slow part happens on a worker, so the budget doesn't apply.
+		if (texelsScaledThisFrame_ >= TEXCACHE_MAX_TEXELS_SCALED && plan.slowScaler && !g_Config.bTexAsyncScaling) {
 			entry->status |= TexStatus::TO_SCALE;
 			plan.scaleFactor = 1;
 		} else {
@@ -2943,7 +3130,7 @@ bool TextureCacheCommon::PrepareBuildTexture(BuildTexturePlan &plan, TexCacheEnt
 			replacedInfo.cachekey = entry->CacheKey();
 			replacedInfo.hash = entry->fullhash;
 			replacedInfo.addr = entry->addr;
-			replacedInfo.isFinal = (entry->status & TexStatus::TO_SCALE) == 0;
+			replacedInfo.isFinal = (entry->status & (TexStatus::TO_SCALE | TexStatus::SCALING_ASYNC)) == 0;
 			replacedInfo.isVideo = plan.isVideo;
 			replacedInfo.fmt = Draw::DataFormat::R8G8B8A8_UNORM;
 			plan.saveTexture = replacer_.WillSave(replacedInfo);
@@ -2985,6 +3172,8 @@ bool TextureCacheCommon::PrepareBuildTexture(BuildTexturePlan &plan, TexCacheEnt
 
 	// Will be filled in again during decode.
 	entry->SetAlphaStatus(TextureAlpha::Any);
+	// Same, if the scaling is still (or again) in the background.
+	entry->status &= ~TexStatus::SCALING_ASYNC;
 	return true;
 }
 
@@ -3031,7 +3220,7 @@ void TextureCacheCommon::LoadTextureLevel(TexCacheEntry &entry, uint8_t *data, s
 		int scaledW = w, scaledH = h;
 		if (plan.scaleFactor > 1) {
 			// Note that this updates w and h!
-			scaler_.ScaleAlways((u32 *)data, pixelData, w, h, &scaledW, &scaledH, plan.scaleFactor);
+			ScaleTexture(entry, (u32 *)data, pixelData, w, h, &scaledW, &scaledH, plan.scaleFactor);
 			pixelData = (u32 *)data;
 
 			decPitch = scaledW * sizeof(u32);
@@ -3053,7 +3242,7 @@ void TextureCacheCommon::LoadTextureLevel(TexCacheEntry &entry, uint8_t *data, s
 			replacedInfo.hash = entry.fullhash;
 			replacedInfo.addr = entry.addr;
 			replacedInfo.isVideo = IsVideo(entry.addr);
-			replacedInfo.isFinal = (entry.status & TexStatus::TO_SCALE) == 0;
+			replacedInfo.isFinal = (entry.status & (TexStatus::TO_SCALE | TexStatus::SCALING_ASYNC)) == 0;
 			replacedInfo.fmt = dstFmt;
 
 			// NOTE: Reading the decoded texture here may be very slow, if we just wrote it to write-combined memory.
@@ -3087,6 +3276,9 @@ std::string TexStatusToString(TexStatus status) {
 	if (status & TexStatus::TO_SCALE) {
 		result += "TOSCALE ";
 	}
+	if (status & TexStatus::SCALING_ASYNC) {
+		result += "SCALING_ASYNC ";
+	}
 	if (status & TexStatus::IS_SCALED_OR_REPLACED) {
 		result += "SCALED/REPL ";
 	}
@@ -17,7 +17,9 @@
 
 #pragma once
 
+#include <atomic>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <memory>
 
@@ -28,6 +30,7 @@
 #include "GPU/GPUCommon.h"
 #include "GPU/Common/TextureDecoder.h"
 #include "GPU/Common/TextureScalerCommon.h"
+#include "GPU/Common/TextureScalerDiskCache.h"
 #include "GPU/Common/TextureShaderCommon.h"
 #include "GPU/Common/TextureReplacer.h"
 #include "GPU/Common/ImageCommon.h"
@@ -47,6 +50,9 @@ enum FramebufferNotification {
 #define TEXCACHE_FRAME_CHANGE_FREQUENT_REGAIN_TRUST 33
 
 #define TEXCACHE_MAX_TEXELS_SCALED (256*256)  // Per frame
+// With async scaling, smaller textures are still scaled right away.
+#define TEXCACHE_MIN_ASYNC_SCALE_TEXELS (64*64)
+#define TEXCACHE_MAX_ASYNC_SCALE_JOBS 16
 
 struct VirtualFramebuffer;
 class TextureReplacer;
@@ -142,7 +148,7 @@ enum class TexStatus : u16 {
 
 	MANY_CLUT_VARIANTS = (1 << 3),   // Has multiple CLUT variants.
 	RELIABLE = (1 << 4),    // Hash will never change. This only really applies to the font texture.
-	// Free bit: 5,
+	SCALING_ASYNC = (1 << 5),  // Showing a placeholder while being scaled on a worker thread.
 	HASH_RECHECK = (1 << 6),   // Hash failed, but addr is the same, so we want to check again next time.
 	TO_SCALE = (1 << 7),        // Pending texture scaling in a later frame.
 	IS_SCALED_OR_REPLACED = (1 << 8),  // Has been scaled already (ignored for replacement checks).
@@ -429,6 +435,11 @@ class TextureCacheCommon {
 	ReplacedTexture *FindReplacement(TexCacheEntry *entry, int *w, int *h, int *d);
 	void PollReplacement(TexCacheEntry *entry, int *w, int *h, int *d);
 
+	// Scales a decoded level, or with async scaling, starts scaling it on a worker and outputs a quick placeholder.
+	void ScaleTexture(TexCacheEntry &entry, u32 *out, u32 *src, int w, int h, int *scaledW, int *scaledH, int factor);
+	bool AsyncScaleFinished(const TexCacheEntry *entry) const;
+	void DecimateAsyncScaling();
+
 	// Return value is mapData normally, but could be another buffer allocated with AllocateAlignedMemory.
 	void LoadTextureLevel(TexCacheEntry &entry, uint8_t *mapData, size_t dataSize, int mapRowPitch, BuildTexturePlan &plan, int srcLevel, Draw::DataFormat dstFmt, TexDecodeFlags texDecFlags);
 
@@ -450,6 +461,7 @@ class TextureCacheCommon {
 
 	TextureReplacer replacer_;
 	TextureScalerCommon scaler_;
+	TextureScalerDiskCache scalerDiskCache_;
 	FramebufferManagerCommon *framebufferManager_;
 	TextureShaderCache textureShaderCache_;
 	ClutTextureCache clutTextureCache_;
@@ -459,6 +471,26 @@ class TextureCacheCommon {
 
 	int decimationCounter_ = 0;
 	int texelsScaledThisFrame_ = 0;
+
+	struct AsyncScaleJob {
+		u32 fullhash;
+		int w;
+		int h;
+		int factor;
+		int frame;
+		int scaledW = 0;
+		int scaledH = 0;
+		std::vector<u32> input;
+		std::vector<u32> output;
+		// Set if the scaled texture may be in the disk cache, so the worker tries that first.
+		u64 diskKey = 0;
+		Path diskFilename;
+		bool fromDisk = false;
+		bool diskFileBad = false;
+		std::atomic<bool> done{};
+	};
+	// By cache key. Shared with the worker, so a stale job can be dropped while it's still running.
+	std::unordered_map<u64, std::shared_ptr<AsyncScaleJob>> asyncScaleJobs_;
 	double replacementTimeThisFrame_ = 0;
 	// Recomputed once per frame. Depends FPS and soon also config.
 	double replacementFrameBudgetSeconds_ = 0.5 / 60.0;
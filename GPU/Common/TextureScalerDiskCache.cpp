@@ -0,0 +1,182 @@
+// Copyright (c) 2026- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <cinttypes>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <zstd.h>
+
+#include "ext/xxhash.h"
+#include "Common/File/DirListing.h"
+#include "Common/File/FileUtil.h"
+#include "Common/Log.h"
+#include "Common/StringUtils.h"
+#include "Common/Thread/Promise.h"
+#include "Common/Thread/ThreadManager.h"
+#include "Core/Config.h"
+#include "Core/Util/PathUtil.h"
+#include "GPU/Common/TextureScalerDiskCache.h"
+
+#define SCALED_TEXTURE_MAGIC 0x54535050  // "PPST"
+// Bump this when the scalers change their output.
+#define SCALED_TEXTURE_VERSION 1
+
+// Per game. Once full, we just stop adding more.
+static const u64 SCALED_TEXTURE_MAX_BYTES = 512 * 1024 * 1024;
+
+struct ScaledTextureHeader {
+	u32 magic;
+	u32 version;
+	u64 key;
+	u32 scaledW;
+	u32 scaledH;
+};
+
+void TextureScalerDiskCache::Start(const std::string &discID) {
+	Stop();
+	if (discID.empty())
+		return;
+
+	StartInDir(GetSysDirectory(DIRECTORY_APP_CACHE) / "scaledtex" / discID);
+}
+
+void TextureScalerDiskCache::StartInDir(const Path &dir) {
+	Stop();
+	dir_ = dir;
+	if (!File::CreateFullPath(dir_)) {
+		dir_.clear();
+		return;
+	}
+
+	std::vector<File::FileInfo> files;
+	File::GetFilesInDir(dir_, &files);
+	for (const File::FileInfo &file : files) {
+		uint64_t key;
+		char ext[8]{};
+		if (file.isDirectory || sscanf(file.name.c_str(), "%016" SCNx64 ".%7s", &key, ext) != 2)
+			continue;
+		if (!strcmp(ext, "zst")) {
+			keys_.insert(key);
+			totalBytes_ += file.size;
+		} else if (!strcmp(ext, "tmp")) {
+			// Left over from a write that didn't finish.
+			File::Delete(file.fullName);
+		}
+	}
+	INFO_LOG(Log::TexCache, "Scaled texture cache: %d textures, %d MB", (int)keys_.size(), (int)(totalBytes_ >> 20));
+}
+
+void TextureScalerDiskCache::Stop() {
+	dir_.clear();
+	keys_.clear();
+	totalBytes_ = 0;
+}
+
+u64 TextureScalerDiskCache::ComputeKey(const u32 *src, int w, int h, int factor) {
+	u64 seed = ((u64)w << 48) | ((u64)h << 32) | ((u64)factor << 16) | ((u64)g_Config.iTexScalingType << 1) | (g_Config.bTexDeposterize ? 1 : 0);
+	return XXH3_64bits_withSeed(src, w * h * sizeof(u32), seed);
+}
+
+Path TextureScalerDiskCache::FilenameForKey(u64 key) const {
+	return dir_ / StringFromFormat("%016" PRIx64 ".zst", key);
+}
+
+void TextureScalerDiskCache::Forget(u64 key) {
+	keys_.erase(key);
+}
+
+bool TextureScalerDiskCache::Load(u64 key, u32 *out, int w, int h, int factor) {
+	if (!Contains(key))
+		return false;
+
+	bool bad = false;
+	if (LoadFile(FilenameForKey(key), key, out, w, h, factor, &bad))
+		return true;
+	if (bad)
+		Forget(key);
+	return false;
+}
+
+bool TextureScalerDiskCache::LoadFile(const Path &filename, u64 key, u32 *out, int w, int h, int factor, bool *bad) {
+	*bad = false;
+	size_t size = 0;
+	std::unique_ptr<uint8_t[]> data(File::ReadLocalFile(filename, &size));
+	if (!data) {
+		// Might still be getting written.
+		return false;
+	}
+
+	const size_t scaledBytes = (size_t)w * factor * h * factor * sizeof(u32);
+	bool success = size > sizeof(ScaledTextureHeader);
+	if (success) {
+		ScaledTextureHeader header;
+		memcpy(&header, data.get(), sizeof(header));
+		success = header.magic == SCALED_TEXTURE_MAGIC && header.version == SCALED_TEXTURE_VERSION && header.key == key;
+		success = success && header.scaledW == (u32)(w * factor) && header.scaledH == (u32)(h * factor);
+	}
+	if (success) {
+		size_t result = ZSTD_decompress(out, scaledBytes, data.get() + sizeof(ScaledTextureHeader), size - sizeof(ScaledTextureHeader));
+		success = result == scaledBytes;
+	}
+
+	if (!success) {
+		WARN_LOG(Log::TexCache, "Dropping bad scaled texture %s", filename.c_str());
+		File::Delete(filename);
+		*bad = true;
+	}
+	return success;
+}
+
+void TextureScalerDiskCache::Save(u64 key, const u32 *scaled, int scaledW, int scaledH) {
+	if (!Enabled() || keys_.find(key) != keys_.end() || totalBytes_ >= SCALED_TEXTURE_MAX_BYTES)
+		return;
+
+	// Counted right away (roughly, upscaled textures tend to compress well), so we don't go far over.
+	const size_t scaledBytes = (size_t)scaledW * scaledH * sizeof(u32);
+	keys_.insert(key);
+	totalBytes_ += scaledBytes / 4;
+
+	std::shared_ptr<std::vector<u32>> pixels = std::make_shared<std::vector<u32>>(scaled, scaled + scaledW * scaledH);
+	const Path filename = FilenameForKey(key);
+	g_threadManager.EnqueueTask(new IndependentTask(TaskType::IO_BLOCKING, TaskPriority::LOW, [pixels, filename, key, scaledW, scaledH]() {
+		const size_t rawBytes = pixels->size() * sizeof(u32);
+		std::vector<uint8_t> data(sizeof(ScaledTextureHeader) + ZSTD_compressBound(rawBytes));
+
+		ScaledTextureHeader header{};
+		header.magic = SCALED_TEXTURE_MAGIC;
+		header.version = SCALED_TEXTURE_VERSION;
+		header.key = key;
+		header.scaledW = scaledW;
+		header.scaledH = scaledH;
+		memcpy(data.data(), &header, sizeof(header));
+
+		size_t written = ZSTD_compress(data.data() + sizeof(header), data.size() - sizeof(header), pixels->data(), rawBytes, 3);
+		if (ZSTD_isError(written))
+			return;
+		data.resize(sizeof(header) + written);
+
+		// Write under another name first, so a half written file is never picked up.
+		const Path tempFilename = filename.WithReplacedExtension(".zst", ".tmp");
+		if (File::WriteDataToFile(false, data.data(), data.size(), tempFilename)) {
+			File::Rename(tempFilename, filename);
+		} else {
+			WARN_LOG(Log::TexCache, "Failed to write scaled texture %s", filename.c_str());
+			File::Delete(tempFilename);
+		}
+	}));
+}
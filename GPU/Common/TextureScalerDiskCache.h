@@ -0,0 +1,62 @@
+// Copyright (c) 2026- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <string>
+#include <unordered_set>
+
+#include "Common/CommonTypes.h"
+#include "Common/File/Path.h"
+
+// Keeps upscaled textures on disk between sessions, zstd compressed, so the same texture doesn't have
+// to go through the CPU scaler again on every boot. The key is a hash of the decoded, unscaled texture
+// and the scaling settings, so it doesn't matter where in memory the texture is, or which CLUT it used.
+// Only used from the GPU thread. The writes happen in the background, but don't touch this object.
+// To read on another thread, look up the filename here and use LoadFile, then Forget the key if it was bad.
+class TextureScalerDiskCache {
+public:
+	void Start(const std::string &discID);
+	void StartInDir(const Path &dir);
+	void Stop();
+
+	bool Enabled() const {
+		return !dir_.empty();
+	}
+
+	// src is the decoded texture about to be scaled, packed (pitch w).
+	static u64 ComputeKey(const u32 *src, int w, int h, int factor);
+
+	bool Contains(u64 key) const {
+		return keys_.find(key) != keys_.end();
+	}
+	Path FilenameForKey(u64 key) const;
+	void Forget(u64 key);
+
+	// out needs room for the scaled texture, which is always w * factor by h * factor.
+	bool Load(u64 key, u32 *out, int w, int h, int factor);
+	void Save(u64 key, const u32 *scaled, int scaledW, int scaledH);
+
+	// Safe on any thread. A file that doesn't match is deleted, and *bad set.
+	static bool LoadFile(const Path &filename, u64 key, u32 *out, int w, int h, int factor, bool *bad);
+
+private:
+
+	Path dir_;
+	std::unordered_set<u64> keys_;
+	u64 totalBytes_ = 0;
+};
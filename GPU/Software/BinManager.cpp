@@ -99,8 +99,8 @@ static inline void DrawBinItem(const BinItem &item, const RasterizerState &state
 
 class DrawBinItemsTask : public Task {
 public:
-	DrawBinItemsTask(BinWaitable *notify, BinManager::BinItemQueue &items, std::atomic<bool> &status, const BinManager::BinStateQueue &states)
-		: notify_(notify), items_(items), status_(status), states_(states) {
+	DrawBinItemsTask(BinWaitable *notify, BinManager *manager, int index)
+		: notify_(notify), manager_(manager), index_(index), status_(manager->taskStatus_[index]) {
 	}
 
 	TaskType Type() const override {
@@ -113,10 +113,18 @@ class DrawBinItemsTask : public Task {
 	}
 
 	void Run() override {
-		ProcessItems();
+		manager_->DrawBin(index_);
 		status_ = false;
 		// In case of any atomic issues, do another pass.
-		ProcessItems();
+		manager_->DrawBin(index_);
+
+		// Now help out with bins whose threads haven't gotten to them yet.
+		// The ranges don't change until every task has finished.
+		const int numBins = (int)manager_->taskRanges_.size();
+		for (int n = 1; n < numBins; ++n) {
+			if (manager_->DrawBin((index_ + n) % numBins))
+				manager_->steals_++;
+		}
 		notify_->Drain();
 	}
 
@@ -125,18 +133,10 @@ class DrawBinItemsTask : public Task {
 	}
 
 private:
-	void ProcessItems() {
-		while (!items_.Empty()) {
-			const BinItem &item = items_.PeekNext();
-			DrawBinItem(item, states_[item.stateIndex]);
-			items_.SkipNext();
-		}
-	}
-
 	BinWaitable *notify_;
-	BinManager::BinItemQueue &items_;
+	BinManager *manager_;
+	int index_;
 	std::atomic<bool> &status_;
-	const BinManager::BinStateQueue &states_;
 };
 
 constexpr int BinManager::MAX_POSSIBLE_TASKS;
@@ -150,12 +150,17 @@ BinManager::BinManager() {
 	waitable_ = new BinWaitable();
 	for (auto &s : taskStatus_)
 		s = false;
+	for (auto &s : binRunning_)
+		s = false;
+	steals_ = 0;
 
-	int maxInitTasks = std::min(g_threadManager.GetNumLooperThreads(), MAX_POSSIBLE_TASKS);
-	for (int i = 0; i < maxInitTasks; ++i) {
+	// Two bins per thread gives idle threads something to steal when the work is uneven.
+	const int numThreads = g_threadManager.GetNumLooperThreads();
+	maxBins_ = std::min(numThreads >= 4 ? numThreads * 2 : numThreads, MAX_POSSIBLE_TASKS);
+	for (int i = 0; i < maxBins_; ++i) {
 		taskQueues_[i].Setup();
 		for (DrawBinItemsTask *&task : taskLists_[i].tasks)
-			task = new DrawBinItemsTask(waitable_, taskQueues_[i], taskStatus_[i], states_);
+			task = new DrawBinItemsTask(waitable_, this, i);
 	}
 	states_.Setup();
 	cluts_.Setup();
@@ -468,10 +473,6 @@ void BinManager::Drain(bool flushing) {
 		int w2 = (queueRange_.x2 - queueRange_.x1 + (SCREEN_SCALE_FACTOR * 2 - 1)) / (SCREEN_SCALE_FACTOR * 2);
 		int h2 = (queueRange_.y2 - queueRange_.y1 + (SCREEN_SCALE_FACTOR * 2 - 1)) / (SCREEN_SCALE_FACTOR * 2);
 
-		// Always bin the entire possible range, but focus on the drawn area.
-		ScreenCoords tl(0, 0, 0);
-		ScreenCoords br(1024 * SCREEN_SCALE_FACTOR, 1024 * SCREEN_SCALE_FACTOR, 0);
-
 		if (pendingOverlap_ && maxTasks_ == 1 && flushing && queue_.Size() == 1 && !FORCE_SINGLE_THREAD) {
 			// If the drawing is 1:1, we can potentially use threads.  It's worth checking.
 			const auto &item = queue_.PeekNext();
@@ -482,19 +483,9 @@ void BinManager::Drain(bool flushing) {
 
 		taskRanges_.clear();
 		if (h2 >= 18 && w2 >= h2 * 4) {
-			int bin_w = std::max(4, (w2 + maxTasks_ - 1) / maxTasks_) * SCREEN_SCALE_FACTOR * 2;
-			taskRanges_.push_back(BinCoords{ tl.x, tl.y, queueRange_.x1 + bin_w - 1, br.y - 1 });
-			for (int x = queueRange_.x1 + bin_w; x <= queueRange_.x2; x += bin_w) {
-				int x2 = x + bin_w > queueRange_.x2 ? br.x : x + bin_w;
-				taskRanges_.push_back(BinCoords{ x, tl.y, x2 - 1, br.y - 1 });
-			}
+			SplitTaskRanges(true);
 		} else if (h2 >= 18 && w2 >= 18) {
-			int bin_h = std::max(4, (h2 + maxTasks_ - 1) / maxTasks_) * SCREEN_SCALE_FACTOR * 2;
-			taskRanges_.push_back(BinCoords{ tl.x, tl.y, br.x - 1, queueRange_.y1 + bin_h - 1 });
-			for (int y = queueRange_.y1 + bin_h; y <= queueRange_.y2; y += bin_h) {
-				int y2 = y + bin_h > queueRange_.y2 ? br.y : y + bin_h;
-				taskRanges_.push_back(BinCoords{ tl.x, y, br.x - 1, y2 - 1 });
-			}
+			SplitTaskRanges(false);
 		}
 
 		tasksSplit_ = true;
@@ -550,7 +541,7 @@ void BinManager::Drain(bool flushing) {
 
 			waitable_->Fill();
 			taskStatus_[i] = true;
-			g_threadManager.EnqueueTaskOnThread(i, taskLists_[i].Next());
+			g_threadManager.EnqueueTaskOnThread(i % g_threadManager.GetNumLooperThreads(), taskLists_[i].Next());
 			enqueues_++;
 		}
 
@@ -558,6 +549,117 @@ void BinManager::Drain(bool flushing) {
 	}
 }
 
+// Splits the screen into columns or rows for the bins, focused on the drawn area.
+void BinManager::SplitTaskRanges(bool columns) {
+	// Always bin the entire possible range.
+	ScreenCoords tl(0, 0, 0);
+	ScreenCoords br(1024 * SCREEN_SCALE_FACTOR, 1024 * SCREEN_SCALE_FACTOR, 0);
+
+	int numBins = maxTasks_ >= 4 ? maxTasks_ * 2 : maxTasks_;
+	numBins = std::min(numBins, maxBins_);
+
+	std::vector<int> cuts;
+	if (columns) {
+		SplitAxis(queueRange_.x1, queueRange_.x2, numBins, true, cuts);
+		int x = tl.x;
+		for (int cut : cuts) {
+			taskRanges_.push_back(BinCoords{ x, tl.y, cut - 1, br.y - 1 });
+			x = cut;
+		}
+		taskRanges_.push_back(BinCoords{ x, tl.y, br.x - 1, br.y - 1 });
+	} else {
+		SplitAxis(queueRange_.y1, queueRange_.y2, numBins, false, cuts);
+		int y = tl.y;
+		for (int cut : cuts) {
+			taskRanges_.push_back(BinCoords{ tl.x, y, br.x - 1, cut - 1 });
+			y = cut;
+		}
+		taskRanges_.push_back(BinCoords{ tl.x, y, br.x - 1, br.y - 1 });
+	}
+
+	// Start measuring again for these ranges.
+	costRanges_ = taskRanges_;
+	costSpan_ = queueRange_;
+	costColumns_ = columns;
+	for (double &cost : binCost_)
+		cost = 0.0;
+}
+
+// Picks where bins start along one axis, within lo to hi.  If we measured how long the bins took
+// last time, uses that to estimate where the work is and split it evenly, otherwise by size.
+void BinManager::SplitAxis(int lo, int hi, int numBins, bool columns, std::vector<int> &cuts) {
+	// Bins are in units of two pixels, and at least 4 units.
+	constexpr int UNIT = SCREEN_SCALE_FACTOR * 2;
+	constexpr int MIN_UNITS = 4;
+	const int units = (hi - lo + UNIT) / UNIT;
+
+	double total = 0.0;
+	if (columns == costColumns_) {
+		for (size_t k = 0; k < costRanges_.size(); ++k)
+			total += binCost_[k];
+	}
+
+	if (total <= 0.0) {
+		const int binUnits = std::max(MIN_UNITS, (units + numBins - 1) / numBins);
+		for (int pos = lo + binUnits * UNIT; pos <= hi; pos += binUnits * UNIT)
+			cuts.push_back(pos);
+		return;
+	}
+
+	// Spread each bin's cost evenly over the part of it that was actually drawn to.
+	std::vector<double> histogram(units, total * 0.05 / units);
+	const int spanLo = columns ? costSpan_.x1 : costSpan_.y1;
+	const int spanHi = columns ? costSpan_.x2 : costSpan_.y2;
+	for (size_t k = 0; k < costRanges_.size(); ++k) {
+		const BinCoords &range = costRanges_[k];
+		int a = std::max(columns ? range.x1 : range.y1, spanLo);
+		int b = std::min(columns ? range.x2 : range.y2, spanHi);
+		if (b < a || binCost_[k] <= 0.0)
+			continue;
+		const double perPixel = binCost_[k] / (b - a + 1);
+		a = std::max(a, lo);
+		b = std::min(b, hi);
+		for (int u = (a - lo) / UNIT; u <= (b - lo) / UNIT && u < units; ++u)
+			histogram[u] += perPixel * UNIT;
+	}
+
+	double sum = 0.0;
+	for (double h : histogram)
+		sum += h;
+	const double target = sum / numBins;
+	double acc = 0.0;
+	int lastCut = 0;
+	for (int u = 0; u < units && (int)cuts.size() < numBins - 1; ++u) {
+		acc += histogram[u];
+		if (acc >= target * (cuts.size() + 1) && u + 1 - lastCut >= MIN_UNITS && units - (u + 1) >= MIN_UNITS) {
+			lastCut = u + 1;
+			cuts.push_back(lo + lastCut * UNIT);
+		}
+	}
+}
+
+bool BinManager::DrawBin(int i) {
+	BinItemQueue &items = taskQueues_[i];
+	bool drew = false;
+	// If someone else is drawing it, they'll check for new items again before letting go.
+	while (!items.Empty()) {
+		bool expected = false;
+		if (!binRunning_[i].compare_exchange_strong(expected, true))
+			break;
+
+		double start = time_now_d();
+		while (!items.Empty()) {
+			const BinItem &item = items.PeekNext();
+			DrawBinItem(item, states_[item.stateIndex]);
+			items.SkipNext();
+		}
+		binCost_[i] += time_now_d() - start;
+		binRunning_[i] = false;
+		drew = true;
+	}
+	return drew;
+}
+
 void BinManager::Flush(const char *reason) {
 	if (queueRange_.x1 == 0x7FFFFFFF)
 		return;
@@ -703,12 +805,12 @@ void BinManager::GetStats(StringWriter &w) {
 		"Slowest frame flush: %s (%0.4f)\n"
 		"Slowest recent flush: %s (%0.4f)\n"
 		"Total flush time: %0.4f (%05.2f%%, last 2: %05.2f%%)\n"
-		"Thread enqueues: %d, count %d",
+		"Thread enqueues: %d, count %d, steals %d",
 		slowestFlushReason_, slowestFlushTime_,
 		slowestTotalReason, slowestTotalTime,
 		slowestRecentReason, slowestRecentTime,
 		allTotal, allTotal * (6000.0 / 1.001), recentTotal * (3000.0 / 1.001),
-		enqueues_, mostThreads_);
+		enqueues_, mostThreads_, steals_.load());
 }
 
 void BinManager::ResetStats() {
@@ -718,6 +820,7 @@ void BinManager::ResetStats() {
 	slowestFlushTime_ = 0.0;
 	enqueues_ = 0;
 	mostThreads_ = 0;
+	steals_ = 0;
 }
 
 inline BinCoords BinCoords::Intersect(const BinCoords &range) const {
@@ -253,13 +253,25 @@ class BinManager {
 	SoftDirty dirty_ = SoftDirty::NONE;
 
 	int maxTasks_ = 1;
+	// With enough threads we use more bins than threads, so idle threads can steal bins.
+	int maxBins_ = 1;
 	bool tasksSplit_ = false;
 	std::vector<BinCoords> taskRanges_;
 	BinItemQueue taskQueues_[MAX_POSSIBLE_TASKS];
 	BinTaskList taskLists_[MAX_POSSIBLE_TASKS];
+	// Set while a task is queued for the bin.
 	std::atomic<bool> taskStatus_[MAX_POSSIBLE_TASKS];
+	// Set while some thread is drawing the bin's items, which might not be the bin's own task.
+	std::atomic<bool> binRunning_[MAX_POSSIBLE_TASKS];
 	BinWaitable *waitable_ = nullptr;
 
+	// Time spent drawing each bin, for the ranges (within costSpan) they had. Used to split the
+	// next time so that each bin gets about the same amount of work.
+	double binCost_[MAX_POSSIBLE_TASKS]{};
+	std::vector<BinCoords> costRanges_;
+	BinCoords costSpan_{};
+	bool costColumns_ = false;
+
 	BinDirtyRange pendingWrites_[2]{};
 	std::unordered_map<uint32_t, BinDirtyRange> pendingReads_;
 
@@ -274,6 +286,7 @@ class BinManager {
 	int lastFlipstats_ = 0;
 	int enqueues_ = 0;
 	int mostThreads_ = 0;
+	std::atomic<int> steals_;
 
 	void MarkPendingReads(const Rasterizer::RasterizerState &state);
 	void MarkPendingWrites(const Rasterizer::RasterizerState &state);
@@ -285,6 +298,9 @@ class BinManager {
 	BinCoords Range(const VertexData &v0, const VertexData &v1);
 	BinCoords Range(const VertexData &v0);
 	void Expand(const BinCoords &range);
+	void SplitTaskRanges(bool columns);
+	void SplitAxis(int lo, int hi, int numBins, bool columns, std::vector<int> &cuts);
+	bool DrawBin(int i);
 
 	friend class DrawBinItemsTask;
 };
@@ -19,6 +19,7 @@
 #include <mutex>
 #include "Common/Common.h"
 #include "Common/Data/Convert/ColorConv.h"
+#include "Common/MemoryUtil.h"
 #include "Core/Config.h"
 #include "GPU/Software/BinManager.h"
 #include "GPU/Software/DrawPixel.h"
@@ -46,6 +47,14 @@ void Shutdown() {
 	jitCache = nullptr;
 }
 
+void PrecompileJit(const std::vector<PixelFuncID> &ids, const std::atomic<bool> &cancel) {
+	jitCache->Precompile(ids, cancel);
+}
+
+std::vector<PixelFuncID> GetUsedJitIDs() {
+	return jitCache->GetUsedIDs();
+}
+
 bool DescribeCodePtr(const u8 *ptr, std::string &name) {
 	if (!jitCache->IsInSpace(ptr)) {
 		return false;
@@ -849,6 +858,39 @@ void PixelJitCache::Flush() {
 	compileQueue_.clear();
 }
 
+void PixelJitCache::Precompile(const std::vector<PixelFuncID> &ids, const std::atomic<bool> &cancel) {
+	if (!g_Config.bSoftwareRenderingJit)
+		return;
+
+	// The lock is only held for a few at a time, so the render thread never waits long to compile.
+	// With W^X, writing code can briefly take away exec from its page, and funcs handed out between
+	// batches may be running, so each batch starts on a fresh page.
+	const bool wx = PlatformIsWXExclusive();
+	for (size_t i = 0; i < ids.size(); i += PRECOMPILE_BATCH_SIZE) {
+		std::lock_guard<std::mutex> guard(jitCacheLock);
+		bool onNewPage = !wx;
+		const size_t end = std::min(ids.size(), i + PRECOMPILE_BATCH_SIZE);
+		for (size_t j = i; j < end; j++) {
+			if (cancel)
+				return;
+			if (cache_.ContainsKey(std::hash<PixelFuncID>()(ids[j])))
+				continue;
+			if (!onNewPage && !SkipToNextPage())
+				return;
+			onNewPage = true;
+			// Compile() would Clear() to make room, which is only safe when the binner is flushed.
+			if (GetSpaceLeft() < 65536)
+				return;
+			Compile(ids[j]);
+		}
+	}
+}
+
+std::vector<PixelFuncID> PixelJitCache::GetUsedIDs() {
+	std::unique_lock<std::mutex> guard(jitCacheLock);
+	return std::vector<PixelFuncID>(usedIDs_.begin(), usedIDs_.end());
+}
+
 SingleFunc PixelJitCache::GetSingle(const PixelFuncID &id, BinManager *binner) {
 	if (!g_Config.bSoftwareRenderingJit)
 		return nullptr;
@@ -858,6 +900,7 @@ SingleFunc PixelJitCache::GetSingle(const PixelFuncID &id, BinManager *binner) {
 		return lastSingle_.func;
 
 	std::unique_lock<std::mutex> guard(jitCacheLock);
+	usedIDs_.insert(id);
 	SingleFunc singleFunc;
 	if (cache_.Get(key, &singleFunc)) {
 		lastSingle_.Set(key, singleFunc, clearGen_);
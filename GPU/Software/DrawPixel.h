@@ -19,6 +19,7 @@
 
 #include "ppsspp_config.h"
 
+#include <atomic>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -46,6 +47,11 @@ void Init();
 void FlushJit();
 void Shutdown();
 
+// Compiles funcs ahead of time, stopping early if cancel is set.  Safe to call from any thread.
+void PrecompileJit(const std::vector<PixelFuncID> &ids, const std::atomic<bool> &cancel);
+// Every ID that was looked up since Init().
+std::vector<PixelFuncID> GetUsedJitIDs();
+
 bool CheckDepthTestPassed(GEComparison func, int x, int y, int stride, u16 z);
 
 bool DescribeCodePtr(const u8 *ptr, std::string &name);
@@ -69,6 +75,8 @@ class PixelJitCache : public Rasterizer::CodeBlock {
 	static SingleFunc GenericSingle(const PixelFuncID &id);
 	void Clear() override;
 	void Flush();
+	void Precompile(const std::vector<PixelFuncID> &ids, const std::atomic<bool> &cancel);
+	std::vector<PixelFuncID> GetUsedIDs();
 
 	std::string DescribeCodePtr(const u8 *ptr) override;
 
@@ -128,6 +136,8 @@ class PixelJitCache : public Rasterizer::CodeBlock {
 	DenseHashMap<size_t, SingleFunc> cache_;
 	std::unordered_map<PixelFuncID, const u8 *> addresses_;
 	std::unordered_set<PixelFuncID> compileQueue_;
+	// Not reset by Clear(), this is what gets remembered for next time.
+	std::unordered_set<PixelFuncID> usedIDs_;
 	static int clearGen_;
 	static thread_local LastCache lastSingle_;
 
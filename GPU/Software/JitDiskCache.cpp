@@ -0,0 +1,237 @@
+// Copyright (c) 2026- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "Common/File/FileUtil.h"
+#include "Common/Log.h"
+#include "Common/StringUtils.h"
+#include "Common/Thread/Promise.h"
+#include "Common/Thread/ThreadManager.h"
+#include "Common/TimeUtil.h"
+#include "Core/Config.h"
+#include "Core/Util/PathUtil.h"
+#include "GPU/Software/DrawPixel.h"
+#include "GPU/Software/FuncId.h"
+#include "GPU/Software/JitDiskCache.h"
+#include "GPU/Software/Sampler.h"
+
+namespace Rasterizer {
+
+#define JIT_CACHE_HEADER_MAGIC 0x4A535050  // "PPSJ"
+// Bump this when the layout of PixelFuncID or SamplerID changes.
+#define JIT_CACHE_VERSION 1
+
+// More than this won't fit in the jit caches anyway, so keep the most used.
+static const u32 JIT_CACHE_MAX_IDS = 1024;
+
+struct JitCacheHeader {
+	u32 magic;
+	u32 version;
+	u32 numPixelIDs;
+	u32 numSamplerIDs;
+};
+
+JitDiskCache::~JitDiskCache() {
+	Stop();
+}
+
+void JitDiskCache::Start(const std::string &discID) {
+	Stop();
+
+	pixelIDs_.clear();
+	samplerIDs_.clear();
+	if (discID.empty() || !g_Config.bSoftwareRenderingJitCache)
+		return;
+
+	File::CreateFullPath(GetSysDirectory(DIRECTORY_APP_CACHE));
+	filename_ = GetSysDirectory(DIRECTORY_APP_CACHE) / (discID + ".softjitcache");
+
+	if (!File::Exists(filename_))
+		return;
+	if (!Load(filename_)) {
+		WARN_LOG(Log::G3D, "Software renderer jit cache %s is stale or corrupt, starting over", filename_.c_str());
+		return;
+	}
+
+	if (!g_Config.bSoftwareRenderingJit || (pixelIDs_.empty() && samplerIDs_.empty()))
+		return;
+
+	cancel_ = false;
+	compiling_ = true;
+	g_threadManager.EnqueueTask(new IndependentTask(TaskType::CPU_COMPUTE, TaskPriority::LOW, [this]() {
+		Precompile();
+		std::lock_guard<std::mutex> guard(lock_);
+		compiling_ = false;
+		cond_.notify_all();
+	}));
+}
+
+bool JitDiskCache::Load(const Path &filename) {
+	pixelIDs_.clear();
+	samplerIDs_.clear();
+
+	FILE *f = File::OpenCFile(filename, "rb");
+	if (!f)
+		return false;
+	bool success = LoadFile(f);
+	fclose(f);
+
+	if (!success) {
+		pixelIDs_.clear();
+		samplerIDs_.clear();
+	}
+	return success;
+}
+
+bool JitDiskCache::LoadFile(FILE *f) {
+	JitCacheHeader header{};
+	if (fread(&header, sizeof(header), 1, f) != 1)
+		return false;
+	if (header.magic != JIT_CACHE_HEADER_MAGIC || header.version != JIT_CACHE_VERSION)
+		return false;
+	if (header.numPixelIDs > JIT_CACHE_MAX_IDS || header.numSamplerIDs > JIT_CACHE_MAX_IDS)
+		return false;
+
+	pixelIDs_.resize(header.numPixelIDs);
+	if (header.numPixelIDs != 0 && fread(&pixelIDs_[0], sizeof(PixelEntry), header.numPixelIDs, f) != header.numPixelIDs)
+		return false;
+	samplerIDs_.resize(header.numSamplerIDs);
+	if (header.numSamplerIDs != 0 && fread(&samplerIDs_[0], sizeof(SamplerEntry), header.numSamplerIDs, f) != header.numSamplerIDs)
+		return false;
+	// Anything more means it's not a file we wrote.
+	return fgetc(f) == EOF;
+}
+
+std::vector<PixelFuncID> JitDiskCache::PixelIDs() const {
+	std::vector<PixelFuncID> ids;
+	ids.reserve(pixelIDs_.size());
+	for (const PixelEntry &entry : pixelIDs_) {
+		PixelFuncID id;
+		id.fullKey = entry.key;
+		ids.push_back(id);
+	}
+	return ids;
+}
+
+std::vector<SamplerID> JitDiskCache::SamplerIDs() const {
+	std::vector<SamplerID> ids;
+	ids.reserve(samplerIDs_.size());
+	for (const SamplerEntry &entry : samplerIDs_) {
+		SamplerID id;
+		id.fullKey = entry.key;
+		ids.push_back(id);
+	}
+	return ids;
+}
+
+void JitDiskCache::Precompile() {
+	double start = time_now_d();
+
+	// Skip anything that doesn't decode anymore, in case the layout changed without a version bump.
+	std::vector<PixelFuncID> pixelIDs = PixelIDs();
+	pixelIDs.erase(std::remove_if(pixelIDs.begin(), pixelIDs.end(), [](const PixelFuncID &id) {
+		return startsWith(DescribePixelFuncID(id), "INVALID");
+	}), pixelIDs.end());
+	std::vector<SamplerID> samplerIDs = SamplerIDs();
+	samplerIDs.erase(std::remove_if(samplerIDs.begin(), samplerIDs.end(), [](const SamplerID &id) {
+		return startsWith(DescribeSamplerID(id), "INVALID");
+	}), samplerIDs.end());
+
+	PrecompileJit(pixelIDs, cancel_);
+	Sampler::PrecompileJit(samplerIDs, cancel_);
+
+	INFO_LOG(Log::G3D, "Precompiled %d pixel funcs and %d samplers in %0.1fms", (int)pixelIDs.size(), (int)samplerIDs.size(), (time_now_d() - start) * 1000.0);
+}
+
+void JitDiskCache::Stop() {
+	cancel_ = true;
+	{
+		std::unique_lock<std::mutex> guard(lock_);
+		cond_.wait(guard, [&] { return !compiling_; });
+	}
+
+	if (!filename_.empty()) {
+		std::vector<PixelFuncID> usedPixel = GetUsedJitIDs();
+		std::vector<SamplerID> usedSampler = Sampler::GetUsedJitIDs();
+		// Nothing drawn, so nothing new to learn.  Keep the file as is.
+		if (!usedPixel.empty() || !usedSampler.empty())
+			Save(filename_, usedPixel, usedSampler);
+	}
+	filename_.clear();
+}
+
+// Bumps the session count of each used ID, and keeps the most used ones.
+template <typename E, typename ID>
+static void MergeUsed(std::vector<E> &entries, const std::vector<ID> &used) {
+	std::unordered_map<decltype(E::key), u32> sessions;
+	for (const E &entry : entries)
+		sessions[entry.key] = entry.sessions;
+	for (const ID &id : used)
+		sessions[id.fullKey]++;
+
+	entries.clear();
+	entries.reserve(sessions.size());
+	for (const auto &it : sessions) {
+		E entry{};
+		entry.key = it.first;
+		entry.sessions = it.second;
+		entries.push_back(entry);
+	}
+
+	// Ties go by key, just to keep the file stable.
+	std::sort(entries.begin(), entries.end(), [](const E &a, const E &b) {
+		if (a.sessions != b.sessions)
+			return a.sessions > b.sessions;
+		return a.key < b.key;
+	});
+	if (entries.size() > JIT_CACHE_MAX_IDS)
+		entries.resize(JIT_CACHE_MAX_IDS);
+}
+
+bool JitDiskCache::Save(const Path &filename, const std::vector<PixelFuncID> &usedPixel, const std::vector<SamplerID> &usedSampler) {
+	MergeUsed(pixelIDs_, usedPixel);
+	MergeUsed(samplerIDs_, usedSampler);
+
+	FILE *f = File::OpenCFile(filename, "wb");
+	if (!f)
+		return false;
+
+	JitCacheHeader header{};
+	header.magic = JIT_CACHE_HEADER_MAGIC;
+	header.version = JIT_CACHE_VERSION;
+	header.numPixelIDs = (u32)pixelIDs_.size();
+	header.numSamplerIDs = (u32)samplerIDs_.size();
+
+	bool success = fwrite(&header, sizeof(header), 1, f) == 1;
+	if (success && !pixelIDs_.empty())
+		success = fwrite(&pixelIDs_[0], sizeof(PixelEntry), pixelIDs_.size(), f) == pixelIDs_.size();
+	if (success && !samplerIDs_.empty())
+		success = fwrite(&samplerIDs_[0], sizeof(SamplerEntry), samplerIDs_.size(), f) == samplerIDs_.size();
+	fclose(f);
+
+	if (!success) {
+		WARN_LOG(Log::G3D, "Failed to write software renderer jit cache %s", filename.c_str());
+		File::Delete(filename);
+	} else {
+		INFO_LOG(Log::G3D, "Saved %d pixel funcs and %d samplers to the software renderer jit cache", (int)pixelIDs_.size(), (int)samplerIDs_.size());
+	}
+	return success;
+}
+
+}  // namespace Rasterizer
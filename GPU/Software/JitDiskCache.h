@@ -0,0 +1,79 @@
+// Copyright (c) 2026- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/File/Path.h"
+#include "GPU/Software/FuncId.h"
+
+namespace Rasterizer {
+
+// Remembers which pixel funcs and samplers a game used, so the next session can jit them on a
+// worker thread during boot, rather than stalling on each one the first time it's drawn with.
+// Only the IDs are kept, along with how many sessions used each, so the common ones go first.
+class JitDiskCache {
+public:
+	~JitDiskCache();
+
+	// Loads the IDs for a game, and starts compiling them in the background.
+	void Start(const std::string &discID);
+	// Stops any compiling still going, and saves the IDs used this session.
+	void Stop();
+
+	// Loads the IDs from a file. If it's stale or corrupt, returns false and leaves none loaded.
+	bool Load(const Path &filename);
+	// Counts one more session for each of the used IDs, and writes all of them to a file.
+	bool Save(const Path &filename, const std::vector<PixelFuncID> &usedPixel, const std::vector<SamplerID> &usedSampler);
+
+	// Most used first.
+	std::vector<PixelFuncID> PixelIDs() const;
+	std::vector<SamplerID> SamplerIDs() const;
+
+private:
+	struct PixelEntry {
+		u64 key;
+		u32 sessions;
+		u32 pad;
+	};
+	struct SamplerEntry {
+		u32 key;
+		u32 sessions;
+	};
+
+	bool LoadFile(FILE *f);
+	void Precompile();
+
+	Path filename_;
+	// Most used first.
+	std::vector<PixelEntry> pixelIDs_;
+	std::vector<SamplerEntry> samplerIDs_;
+
+	std::mutex lock_;
+	std::condition_variable cond_;
+	bool compiling_ = false;
+	std::atomic<bool> cancel_{};
+};
+
+}  // namespace Rasterizer
@@ -579,6 +579,16 @@ void CodeBlock::Clear() {
 	descriptions_.clear();
 }
 
+bool CodeBlock::SkipToNextPage() {
+	const uintptr_t pageSize = (uintptr_t)GetMemoryProtectPageSize();
+	const uintptr_t ptr = (uintptr_t)GetCodePtr();
+	const size_t skip = (size_t)(((ptr + pageSize - 1) & ~(pageSize - 1)) - ptr);
+	if (skip >= GetSpaceLeft())
+		return false;
+	ResetCodePtr(GetOffset(GetCodePtr()) + skip);
+	return true;
+}
+
 void CodeBlock::WriteSimpleConst16x8(const u8 *&ptr, uint8_t value) {
 	if (ptr == nullptr)
 		WriteDynamicConst16x8(ptr, value);
@@ -239,6 +239,12 @@ class CodeBlock : public BaseCodeBlock {
 	RegCache::Reg GetZeroVec();
 
 	void Describe(const std::string &message);
+	// Moves the code pointer up to a page boundary without writing anything, so with W^X, writing
+	// more code won't take exec away from funcs already there. Returns false if out of space.
+	bool SkipToNextPage();
+
+	// How many funcs a Precompile() compiles per hold of the jit cache lock.
+	static constexpr size_t PRECOMPILE_BATCH_SIZE = 8;
 	// Returns amount of stack space used.
 	int WriteProlog(int extraStack, const std::vector<RegCache::Reg> &vec, const std::vector<RegCache::Reg> &gen);
 	// Returns updated function start position, modifies prolog and finishes writing.
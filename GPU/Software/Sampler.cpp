@@ -21,6 +21,7 @@
 #include "Common/Common.h"
 #include "Common/Data/Convert/ColorConv.h"
 #include "Common/LogReporting.h"
+#include "Common/MemoryUtil.h"
 #include "Common/Math/SIMDHeaders.h"
 #include "Core/Config.h"
 #include "GPU/Common/TextureDecoder.h"
@@ -54,6 +55,14 @@ void Shutdown() {
 	jitCache = nullptr;
 }
 
+void PrecompileJit(const std::vector<SamplerID> &ids, const std::atomic<bool> &cancel) {
+	jitCache->Precompile(ids, cancel);
+}
+
+std::vector<SamplerID> GetUsedJitIDs() {
+	return jitCache->GetUsedIDs();
+}
+
 bool DescribeCodePtr(const u8 *ptr, std::string &name) {
 	if (!jitCache->IsInSpace(ptr)) {
 		return false;
@@ -159,8 +168,47 @@ void SamplerJitCache::Flush() {
 	compileQueue_.clear();
 }
 
+void SamplerJitCache::Precompile(const std::vector<SamplerID> &ids, const std::atomic<bool> &cancel) {
+	if (!g_Config.bSoftwareRenderingJit)
+		return;
+
+	// See PixelJitCache::Precompile(), same batches and W^X concern.
+	const bool wx = PlatformIsWXExclusive();
+	for (size_t i = 0; i < ids.size(); i += PRECOMPILE_BATCH_SIZE) {
+		std::lock_guard<std::mutex> guard(jitCacheLock);
+		bool onNewPage = !wx;
+		const size_t end = std::min(ids.size(), i + PRECOMPILE_BATCH_SIZE);
+		for (size_t j = i; j < end; j++) {
+			if (cancel)
+				return;
+			// All three are compiled together, so checking one is enough.
+			SamplerID fetchID = ids[j];
+			fetchID.linear = false;
+			fetchID.fetch = true;
+			if (cache_.ContainsKey(std::hash<SamplerID>()(fetchID)))
+				continue;
+			if (!onNewPage && !SkipToNextPage())
+				return;
+			onNewPage = true;
+			// Compile() would Clear() to make room, which is only safe when the binner is flushed.
+			if (GetSpaceLeft() < 16384)
+				return;
+			Compile(ids[j]);
+		}
+	}
+}
+
+std::vector<SamplerID> SamplerJitCache::GetUsedIDs() {
+	std::unique_lock<std::mutex> guard(jitCacheLock);
+	return std::vector<SamplerID>(usedIDs_.begin(), usedIDs_.end());
+}
+
 NearestFunc SamplerJitCache::GetByID(const SamplerID &id, size_t key, BinManager *binner) {
 	std::unique_lock<std::mutex> guard(jitCacheLock);
+	SamplerID usedID = id;
+	usedID.linear = false;
+	usedID.fetch = false;
+	usedIDs_.insert(usedID);
 	
 	NearestFunc func;
 	if (cache_.Get(key, &func)) {
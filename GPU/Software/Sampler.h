@@ -19,6 +19,8 @@
 
 #include "ppsspp_config.h"
 
+#include <atomic>
+#include <vector>
 #include <unordered_map>
 #include <unordered_set>
 #include "Common/Data/Collections/Hashmaps.h"
@@ -50,6 +52,11 @@ void Init();
 void FlushJit();
 void Shutdown();
 
+// Compiles samplers ahead of time, stopping early if cancel is set.  Safe to call from any thread.
+void PrecompileJit(const std::vector<SamplerID> &ids, const std::atomic<bool> &cancel);
+// Every ID that was looked up since Init(), with linear and fetch cleared.
+std::vector<SamplerID> GetUsedJitIDs();
+
 bool DescribeCodePtr(const u8 *ptr, std::string &name);
 
 class SamplerJitCache : public Rasterizer::CodeBlock {
@@ -62,6 +69,8 @@ class SamplerJitCache : public Rasterizer::CodeBlock {
 	FetchFunc GetFetch(const SamplerID &id, BinManager *binner);
 	void Clear() override;
 	void Flush();
+	void Precompile(const std::vector<SamplerID> &ids, const std::atomic<bool> &cancel);
+	std::vector<SamplerID> GetUsedIDs();
 
 	std::string DescribeCodePtr(const u8 *ptr) override;
 
@@ -147,6 +156,8 @@ class SamplerJitCache : public Rasterizer::CodeBlock {
 	DenseHashMap<size_t, NearestFunc> cache_;
 	std::unordered_map<SamplerID, const u8 *> addresses_;
 	std::unordered_set<SamplerID> compileQueue_;
+	// Not reset by Clear(), this is what gets remembered for next time.
+	std::unordered_set<SamplerID> usedIDs_;
 	static int clearGen_;
 	static thread_local LastCache lastFetch_;
 	static thread_local LastCache lastNearest_;
@@ -31,6 +31,7 @@
 #include "Core/Core.h"
 #include "Core/System.h"
 #include "Core/Debugger/MemBlockInfo.h"
+#include "Core/ELF/ParamSFO.h"
 #include "Core/MemMap.h"
 #include "Core/MIPS/MIPS.h"
 #include "Core/Util/PPGeDraw.h"
@@ -39,6 +40,7 @@
 
 #include "GPU/GPUCommon.h"
 #include "GPU/Software/DrawPixel.h"
+#include "GPU/Software/JitDiskCache.h"
 #include "GPU/Software/Rasterizer.h"
 #include "GPU/Software/Sampler.h"
 #include "GPU/Software/SoftGpu.h"
@@ -431,6 +433,8 @@ SoftGPU::SoftGPU(GraphicsContext *gfxCtx, Draw::DrawContext *draw)
 
 	Rasterizer::Init();
 	Sampler::Init();
+	jitDiskCache_ = new Rasterizer::JitDiskCache();
+	jitDiskCache_->Start(g_paramSFO.GetDiscID());
 	drawEngine_ = new SoftwareDrawEngine();
 	drawEngine_->SetGPUCommon(this);
 	drawEngine_->Init();
@@ -480,6 +484,9 @@ SoftGPU::~SoftGPU() {
 	delete presentation_;
 	delete drawEngine_;
 
+	// Needs the jit caches to save what was used.
+	jitDiskCache_->Stop();
+	delete jitDiskCache_;
 	Sampler::Shutdown();
 	Rasterizer::Shutdown();
 }
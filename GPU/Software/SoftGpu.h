@@ -114,6 +114,9 @@ static inline SoftDirty operator ~(const SoftDirty &v) {
 
 class PresentationCommon;
 class SoftwareDrawEngine;
+namespace Rasterizer {
+class JitDiskCache;
+}
 
 enum class SoftGPUVRAMDirty : uint8_t {
 	CLEAR = 0,
@@ -235,6 +238,7 @@ class SoftGPU : public GPUCommon {
 
 	PresentationCommon *presentation_ = nullptr;
 	SoftwareDrawEngine *drawEngine_ = nullptr;
+	Rasterizer::JitDiskCache *jitDiskCache_ = nullptr;
 
 	Draw::Texture *fbTex = nullptr;
 	std::vector<u32> fbTexBuffer_;
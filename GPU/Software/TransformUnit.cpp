@@ -24,6 +24,7 @@
 #include "Common/Math/math_util.h"
 #include "Common/MemoryUtil.h"
 #include "Common/Profiler/Profiler.h"
+#include "Common/Thread/ParallelLoop.h"
 #include "GPU/GPUState.h"
 #include "GPU/Common/DrawEngineCommon.h"
 #include "GPU/Common/VertexDecoderCommon.h"
@@ -345,27 +346,24 @@ static inline float Dot43(const Vec4f &a, const Vec3f &b) {
 	return Dot(a, Vec4f(b, 1.0f));
 }
 
-ClipVertexData TransformUnit::ReadVertex(const VertexReader &vreader, const TransformState &state) {
+ClipVertexData TransformUnit::ReadVertex(const VertexReader &vreader, const TransformState &state, VertexCarry &carry) {
 	PROFILE_THIS_SCOPE("read_vert");
-	// If we ever thread this, we'll have to change this.
 	ClipVertexData vertex;
 
 	ModelCoords pos;
 	vreader.ReadPosThrough(pos.AsArray());
 
-	static Vec3Packedf lastTC;
 	if (state.readUV) {
 		vreader.ReadUV(vertex.v.texturecoords.AsArray());
 		vertex.v.texturecoords.q() = 0.0f;
-		lastTC = vertex.v.texturecoords;
+		carry.texturecoords = vertex.v.texturecoords;
 	} else {
-		vertex.v.texturecoords = lastTC;
+		vertex.v.texturecoords = carry.texturecoords;
 	}
 
-	static Vec3f lastnormal;
 	if (vreader.hasNormal())
-		vreader.ReadNrm(lastnormal.AsArray());
-	Vec3f normal = lastnormal;
+		vreader.ReadNrm(carry.normal.AsArray());
+	Vec3f normal = carry.normal;
 	if (state.negateNormals)
 		normal = -normal;
 
@@ -463,6 +461,34 @@ ClipVertexData TransformUnit::ReadVertex(const VertexReader &vreader, const Tran
 	return vertex;
 }
 
+void TransformUnit::ReadVertices(const VertexReader &vreader, const TransformState &state, ClipVertexData *out, int count) {
+	if (count < PARALLEL_MIN_VERTS || g_threadManager.GetNumLooperThreads() <= 1) {
+		VertexReader reader = vreader;
+		for (int i = 0; i < count; ++i) {
+			reader.Goto(i);
+			out[i] = ReadVertex(reader, state, carry_);
+		}
+		return;
+	}
+
+	// Within a draw, either every vertex replaces the carried UV/normal or none do.
+	// So each batch can start from the values before the draw and get the same result.
+	const VertexCarry start = carry_;
+	ParallelRangeLoop(&g_threadManager, [&](int l, int h) {
+		VertexReader reader = vreader;
+		VertexCarry carry = start;
+		for (int i = l; i < h; ++i) {
+			reader.Goto(i);
+			out[i] = ReadVertex(reader, state, carry);
+		}
+	}, 0, count, PARALLEL_MIN_VERTS / 4, TaskPriority::HIGH);
+
+	// And leave carry_ as if we'd read them in order, for later draws.
+	VertexReader reader = vreader;
+	reader.Goto(count - 1);
+	ReadVertex(reader, state, carry_);
+}
+
 void TransformUnit::SetDirty(SoftDirty flags) {
 	binner_->SetDirty(flags);
 }
@@ -489,6 +515,10 @@ class SoftwareVertexReader {
 		// If we're only using a subset of verts, it's better to decode with random access (usually.)
 		// However, if we're reusing a lot of verts, we should read and cache them.
 		useCache_ = useIndices_ && vertex_count > (upperBound_ - lowerBound_ + 1);
+		// Big draws are also read up front, because then it can be done on several threads.
+		// Clipping and binning still happens here, in order.
+		if (vertex_count != 0 && upperBound_ - lowerBound_ + 1 >= TransformUnit::PARALLEL_MIN_VERTS && g_threadManager.GetNumLooperThreads() > 1)
+			useCache_ = true;
 		if (useCache_ && (int)cached_.size() < upperBound_ - lowerBound_ + 1)
 			cached_.resize(std::max(128, upperBound_ - lowerBound_ + 1));
 	}
@@ -505,10 +535,7 @@ class SoftwareVertexReader {
 		if (!useCache_)
 			return;
 
-		for (int i = 0; i < upperBound_ - lowerBound_ + 1; ++i) {
-			vreader_.Goto(i);
-			cached_[i] = transform_.ReadVertex(vreader_, transformState_);
-		}
+		transform_.ReadVertices(vreader_, transformState_, cached_.data(), upperBound_ - lowerBound_ + 1);
 	}
 
 	inline ClipVertexData Read(int vtx) {
@@ -518,10 +545,13 @@ class SoftwareVertexReader {
 			}
 			vreader_.Goto(conv_(vtx) - lowerBound_);
 		} else {
+			if (useCache_) {
+				return cached_[vtx];
+			}
 			vreader_.Goto(vtx);
 		}
 
-		return transform_.ReadVertex(vreader_, transformState_);
+		return transform_.ReadVertex(vreader_, transformState_, transform_.carry_);
 	};
 
 protected:
@@ -141,8 +141,18 @@ class TransformUnit {
 	void SetDirty(SoftDirty flags);
 	SoftDirty GetDirty();
 
+	// Draws with at least this many vertices are transformed up front, split across threads.
+	static constexpr int PARALLEL_MIN_VERTS = 512;
+
 private:
-	ClipVertexData ReadVertex(const VertexReader &vreader, const TransformState &state);
+	// Used when a vertex doesn't have its own UV or normal.  Only the last vertex read matters.
+	struct VertexCarry {
+		Vec3Packedf texturecoords;
+		Vec3f normal;
+	};
+
+	ClipVertexData ReadVertex(const VertexReader &vreader, const TransformState &state, VertexCarry &carry);
+	void ReadVertices(const VertexReader &vreader, const TransformState &state, ClipVertexData *out, int count);
 	void SendTriangle(CullType cullType, const ClipVertexData *verts, int provoking = 2);
 
 	u8 *decoded_ = nullptr;
@@ -153,6 +163,7 @@ class TransformUnit {
 	// This is the index of the next vert in data (or higher, may need modulus.)
 	int data_index_ = 0;
 	GEPrimitiveType prev_prim_ = GE_PRIM_POINTS;
+	VertexCarry carry_{};
 	bool hasDraws_ = false;
 	bool isImmDraw_ = false;
 
@@ -865,7 +865,7 @@ void TextureCacheVulkan::BuildTexture(TexCacheEntry *const entry) {
 				replacedInfo.hash = entry->fullhash;
 				replacedInfo.addr = entry->addr;
 				replacedInfo.isVideo = IsVideo(entry->addr);
-				replacedInfo.isFinal = (entry->status & TexStatus::TO_SCALE) == 0;
+				replacedInfo.isFinal = (entry->status & (TexStatus::TO_SCALE | TexStatus::SCALING_ASYNC)) == 0;
 				replacedInfo.fmt = FromVulkanFormat(actualFmt);
 				replacer_.NotifyTextureDecoded(plan.replaced, replacedInfo, data, stride, plan.baseLevelSrc + i, mipUnscaledWidth, mipUnscaledHeight, w, h);
 			}
@@ -985,7 +985,7 @@ void TextureCacheVulkan::LoadVulkanTextureLevel(TexCacheEntry &entry, uint8_t *w
 		uint8_t *scaleBuf = (uint8_t *)AllocateAlignedMemory(allocBytes, 16);
 		_assert_msg_(scaleBuf, "Failed to allocate %d aligned bytes for texture scaler", (int)allocBytes);
 
-		scaler_.ScaleAlways((u32 *)scaleBuf, pixelData, w, h, &w, &h, scaleFactor);
+		ScaleTexture(entry, (u32 *)scaleBuf, pixelData, w, h, &w, &h, scaleFactor);
 		pixelData = (u32 *)writePtr;
 
 		// We always end up at 8888.  Other parts assume this.
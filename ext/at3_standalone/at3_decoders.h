@@ -5,7 +5,9 @@
 // Notes
 //
 // Performance-wise, these are OK.
-// For Atrac3+, the bottleneck is two functions: decode_qu_spectra and ff_atrac3p_ipqf. At least the latter is quite SIMD-able.
+// For Atrac3+, the bottleneck is two functions: decode_qu_spectra and ff_atrac3p_ipqf. The latter runs its IDCTs four at a time
+// in SIMD lanes (imdct_half4), and its FIR uses AVX2 when the CPU has it (cpu_info), else SSE2/NEON. The other DSP
+// loops use the SSE2/NEON helpers in float_dsp.h.
 
 // The full external API for the standalone Atrac3/3+ decoder.
 
@@ -214,8 +214,7 @@ static void decode_residual_spectrum(Atrac3pChanUnitCtx *ctx,
             if (ctx->channels[ch].qu_wordlen[qu] > 0) {
                 q = av_atrac3p_sf_tab[ctx->channels[ch].qu_sf_idx[qu]] *
                     av_atrac3p_mant_tab[ctx->channels[ch].qu_wordlen[qu]];
-                for (i = 0; i < nspeclines; i++)
-                    dst[i] = src[i] * q;
+                int16_to_float_fmul_scalar(dst, src, q, nspeclines);
             }
         }
 
@@ -234,8 +233,7 @@ static void decode_residual_spectrum(Atrac3pChanUnitCtx *ctx,
 
             /* flip coefficients' sign if requested */
             if (ctx->negate_coeffs[sb])
-                for (i = 0; i < ATRAC3P_SUBBAND_SAMPLES; i++)
-                    out[1][sb * ATRAC3P_SUBBAND_SAMPLES + i] = -(out[1][sb * ATRAC3P_SUBBAND_SAMPLES + i]);
+                vector_fmul_scalar(&out[1][sb * ATRAC3P_SUBBAND_SAMPLES], -1.0f, ATRAC3P_SUBBAND_SAMPLES);
         }
     }
 }
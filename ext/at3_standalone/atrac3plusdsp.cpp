@@ -25,22 +25,6 @@
  *  DSP functions for ATRAC3+ decoder.
  */
 
-#include "ppsspp_config.h"
-
-#if PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
-
-#include <emmintrin.h>
-
-#elif PPSSPP_ARCH(ARM_NEON)
-
-#if defined(_MSC_VER) && PPSSPP_ARCH(ARM64)
-#include <arm64_neon.h>
-#else
-#include <arm_neon.h>
-#endif
-
-#endif
-
 #define _USE_MATH_DEFINES
 #include <math.h>
 #include <string.h>
@@ -49,6 +33,11 @@
 #include "fft.h"
 #include "atrac3plus.h"
 
+#if PPSSPP_ARCH(SSE2)
+#include <immintrin.h>
+#include "Common/CPUDetect.h"
+#endif
+
 /**
  *  Map quant unit number to its position in the spectrum.
  *  To get the number of spectral lines in each quant unit do the following:
@@ -478,19 +467,15 @@ void ff_atrac3p_power_compensation(Atrac3pChanUnitCtx *ctx, int ch_index,
         dst = &sp[av_atrac3p_qu_to_spec_pos[qu]];
         nsp = av_atrac3p_qu_to_spec_pos[qu + 1] - av_atrac3p_qu_to_spec_pos[qu];
 
-        for (i = 0; i < nsp; i++)
-            dst[i] += pwcsp[i] * qu_lev;
+        vector_fmac_scalar(dst, pwcsp, qu_lev, nsp);
     }
 }
 
 void ff_atrac3p_imdct(FFTContext *mdct_ctx, float *pIn,
                       float *pOut, int wind_id, int sb)
 {
-    int i;
-
     if (sb & 1)
-        for (i = 0; i < ATRAC3P_SUBBAND_SAMPLES / 2; i++)
-            FFSWAP(float, pIn[i], pIn[ATRAC3P_SUBBAND_SAMPLES - 1 - i]);
+        vector_reverse(pIn, ATRAC3P_SUBBAND_SAMPLES);
 
     imdct_calc(mdct_ctx, pOut, pIn);
 
@@ -623,79 +608,131 @@ static const float ipqf_coeffs2[ATRAC3P_PQF_FIR_LEN][16] = {
       -4.4400572e-8,    -4.2005411e-7,    -8.0604229e-7,    -5.8336207e-7 }
 };
 
+#if PPSSPP_ARCH(SSE2)
+/* Same as the SSE2 FIR in ff_atrac3p_ipqf, but eight outputs per register.
+ * Still no FMA, so the result is the same. */
+#if defined(__GNUC__) || defined(__clang__) || defined(__INTEL_COMPILER)
+[[gnu::target("avx2")]]
+#endif
+static void ipqf_fir_avx2(const Atrac3pIPQFChannelCtx *hist, int pos_now, int pos_next, float *outp)
+{
+    const __m256i reverse = _mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256 acc_lo = _mm256_setzero_ps();
+    __m256 acc_hi = _mm256_setzero_ps();
+
+    for (int t = 0; t < ATRAC3P_PQF_FIR_LEN; t++) {
+        const __m256 buf1 = _mm256_loadu_ps(hist->buf1[pos_now]);
+        const __m256 buf2 = _mm256_loadu_ps(hist->buf2[pos_next]);
+        const float *coeffs1 = ipqf_coeffs1[t];
+        const float *coeffs2 = ipqf_coeffs2[t];
+        acc_lo = _mm256_add_ps(acc_lo, _mm256_add_ps(
+            _mm256_mul_ps(buf1, _mm256_loadu_ps(coeffs1)),
+            _mm256_mul_ps(buf2, _mm256_loadu_ps(coeffs2))));
+        acc_hi = _mm256_add_ps(acc_hi, _mm256_add_ps(
+            _mm256_mul_ps(_mm256_permutevar8x32_ps(buf1, reverse), _mm256_loadu_ps(coeffs1 + 8)),
+            _mm256_mul_ps(_mm256_permutevar8x32_ps(buf2, reverse), _mm256_loadu_ps(coeffs2 + 8))));
+
+        pos_now  = mod23_lut[pos_next + 2];
+        pos_next = mod23_lut[pos_now + 2];
+    }
+
+    _mm256_storeu_ps(outp, acc_lo);
+    _mm256_storeu_ps(outp + 8, acc_hi);
+}
+#endif
+
 void ff_atrac3p_ipqf(FFTContext *dct_ctx, Atrac3pIPQFChannelCtx *hist,
                      const float *in, float *out)
 {
-    int i, s, sb, t, pos_now, pos_next;
-    float idct_in [ATRAC3P_SUBBANDS];
-    float idct_out[ATRAC3P_SUBBANDS];
-
-    memset(out, 0, ATRAC3P_FRAME_SAMPLES * sizeof(*out));
+    int i, s, t, pos_now, pos_next;
+    float idct_out[ATRAC3P_SUBBANDS][4];
+#if PPSSPP_ARCH(SSE2)
+    const bool use_avx2 = cpu_info.bAVX2;
+#endif
 
     for (s = 0; s < ATRAC3P_SUBBAND_SAMPLES; s++) {
-        /* pick up one sample from each subband */
-        for (sb = 0; sb < ATRAC3P_SUBBANDS; sb++)
-            idct_in[sb] = in[sb * ATRAC3P_SUBBAND_SAMPLES + s];
-
-        /* Calculate the sine and cosine part of the PQF using IDCT-IV */
-        imdct_half(dct_ctx, idct_out, idct_in);
+        /* Calculate the sine and cosine part of the PQF using IDCT-IV.
+         * They don't depend on the history, so do four samples at a time,
+         * picking up one sample from each subband for each. */
+        const int lane = s & 3;
+        if (lane == 0)
+            imdct_half4(dct_ctx, idct_out, in + s, ATRAC3P_SUBBAND_SAMPLES);
 
         /* append the result to the history */
         const int hist_pos = hist->pos;
         for (i = 0; i < 8; i++) {
-            hist->buf1[hist_pos][i] = idct_out[i + 8];
+            hist->buf1[hist_pos][i] = idct_out[i + 8][lane];
         }
         for (i = 0; i < 8; i++) {
-            hist->buf2[hist_pos][i] = idct_out[7 - i];
+            hist->buf2[hist_pos][i] = idct_out[7 - i][lane];
         }
 
         pos_now  = hist->pos;
         pos_next = mod23_lut[pos_now + 2]; // pos_next = (pos_now + 1) % 23;
 
+        /* The 16 outputs stay in registers over all the taps, and are only stored at the end.
+         * Same order of additions (starting from zero) as the plain C, so the same result. */
+        float *outp = out + s * 16;
+#if PPSSPP_ARCH(SSE2)
+        if (use_avx2) {
+            ipqf_fir_avx2(hist, pos_now, pos_next, outp);
+            hist->pos = mod23_lut[hist->pos];
+            continue;
+        }
+
+        __m128 acc0 = _mm_setzero_ps();
+        __m128 acc1 = _mm_setzero_ps();
+        __m128 acc2 = _mm_setzero_ps();
+        __m128 acc3 = _mm_setzero_ps();
+#elif PPSSPP_ARCH(ARM_NEON)
+        float32x4_t acc0 = vdupq_n_f32(0.0f);
+        float32x4_t acc1 = vdupq_n_f32(0.0f);
+        float32x4_t acc2 = vdupq_n_f32(0.0f);
+        float32x4_t acc3 = vdupq_n_f32(0.0f);
+#else
+        memset(outp, 0, 16 * sizeof(*out));
+#endif
+
         for (t = 0; t < ATRAC3P_PQF_FIR_LEN; t++) {
             const float *buf1 = hist->buf1[pos_now];
             const float *buf2 = hist->buf2[pos_next];
             const float *coeffs1 = ipqf_coeffs1[t];
             const float *coeffs2 = ipqf_coeffs2[t];
 
-            float *outp = out + s * 16;
 #if PPSSPP_ARCH(SSE2)
-            auto _mm_reverse = [](__m128 x) -> __m128 {
-                return _mm_shuffle_ps(x, x, _MM_SHUFFLE(0, 1, 2, 3));
-            };
-            _mm_storeu_ps(outp, _mm_add_ps(_mm_loadu_ps(outp), _mm_add_ps(
-                _mm_mul_ps(_mm_loadu_ps(buf1), _mm_loadu_ps(coeffs1)),
-                _mm_mul_ps(_mm_loadu_ps(buf2), _mm_loadu_ps(coeffs2)))));
-            _mm_storeu_ps(outp + 4, _mm_add_ps(_mm_loadu_ps(outp + 4), _mm_add_ps(
-                _mm_mul_ps(_mm_loadu_ps(buf1 + 4), _mm_loadu_ps(coeffs1 + 4)),
-                _mm_mul_ps(_mm_loadu_ps(buf2 + 4), _mm_loadu_ps(coeffs2 + 4)))));
-
-            _mm_storeu_ps(outp + 8, _mm_add_ps(_mm_loadu_ps(outp + 8), _mm_add_ps(
-                _mm_mul_ps(_mm_reverse(_mm_loadu_ps(buf1 + 4)), _mm_loadu_ps(coeffs1 + 8)),
-                _mm_mul_ps(_mm_reverse(_mm_loadu_ps(buf2 + 4)), _mm_loadu_ps(coeffs2 + 8)))));
-            _mm_storeu_ps(outp + 12, _mm_add_ps(_mm_loadu_ps(outp + 12), _mm_add_ps(
-                _mm_mul_ps(_mm_reverse(_mm_loadu_ps(buf1)), _mm_loadu_ps(coeffs1 + 12)),
-                _mm_mul_ps(_mm_reverse(_mm_loadu_ps(buf2)), _mm_loadu_ps(coeffs2 + 12)))));
+            const __m128 buf1_lo = _mm_loadu_ps(buf1);
+            const __m128 buf1_hi = _mm_loadu_ps(buf1 + 4);
+            const __m128 buf2_lo = _mm_loadu_ps(buf2);
+            const __m128 buf2_hi = _mm_loadu_ps(buf2 + 4);
+            acc0 = _mm_add_ps(acc0, _mm_add_ps(
+                _mm_mul_ps(buf1_lo, _mm_loadu_ps(coeffs1)),
+                _mm_mul_ps(buf2_lo, _mm_loadu_ps(coeffs2))));
+            acc1 = _mm_add_ps(acc1, _mm_add_ps(
+                _mm_mul_ps(buf1_hi, _mm_loadu_ps(coeffs1 + 4)),
+                _mm_mul_ps(buf2_hi, _mm_loadu_ps(coeffs2 + 4))));
+            acc2 = _mm_add_ps(acc2, _mm_add_ps(
+                _mm_mul_ps(vector_reverse_ps(buf1_hi), _mm_loadu_ps(coeffs1 + 8)),
+                _mm_mul_ps(vector_reverse_ps(buf2_hi), _mm_loadu_ps(coeffs2 + 8))));
+            acc3 = _mm_add_ps(acc3, _mm_add_ps(
+                _mm_mul_ps(vector_reverse_ps(buf1_lo), _mm_loadu_ps(coeffs1 + 12)),
+                _mm_mul_ps(vector_reverse_ps(buf2_lo), _mm_loadu_ps(coeffs2 + 12))));
 #elif PPSSPP_ARCH(ARM_NEON)
-            auto vreverseq_f32 = [](float32x4_t x) -> float32x4_t {
-                float32x4_t rev = vrev64q_f32(x);
-                float32x2_t high = vget_high_f32(rev); //{4,3}
-                float32x2_t low = vget_low_f32(rev); //{1,2}
-                return vcombine_f32(high, low); //{4,3,2,1}
-            };
-            vst1q_f32(outp, vaddq_f32(vld1q_f32(outp), vaddq_f32(
-                vmulq_f32(vld1q_f32(buf1), vld1q_f32(coeffs1)),
-                vmulq_f32(vld1q_f32(buf2), vld1q_f32(coeffs2)))));
-            vst1q_f32(outp + 4, vaddq_f32(vld1q_f32(outp + 4), vaddq_f32(
-                vmulq_f32(vld1q_f32(buf1 + 4), vld1q_f32(coeffs1 + 4)),
-                vmulq_f32(vld1q_f32(buf2 + 4), vld1q_f32(coeffs2 + 4)))));
-
-            vst1q_f32(outp + 8, vaddq_f32(vld1q_f32(outp + 8), vaddq_f32(
-                vmulq_f32(vreverseq_f32(vld1q_f32(buf1 + 4)), vld1q_f32(coeffs1 + 8)),
-                vmulq_f32(vreverseq_f32(vld1q_f32(buf2 + 4)), vld1q_f32(coeffs2 + 8)))));
-            vst1q_f32(outp + 12, vaddq_f32(vld1q_f32(outp + 12), vaddq_f32(
-                vmulq_f32(vreverseq_f32(vld1q_f32(buf1)), vld1q_f32(coeffs1 + 12)),
-                vmulq_f32(vreverseq_f32(vld1q_f32(buf2)), vld1q_f32(coeffs2 + 12)))));
+            const float32x4_t buf1_lo = vld1q_f32(buf1);
+            const float32x4_t buf1_hi = vld1q_f32(buf1 + 4);
+            const float32x4_t buf2_lo = vld1q_f32(buf2);
+            const float32x4_t buf2_hi = vld1q_f32(buf2 + 4);
+            acc0 = vaddq_f32(acc0, vaddq_f32(
+                vmulq_f32(buf1_lo, vld1q_f32(coeffs1)),
+                vmulq_f32(buf2_lo, vld1q_f32(coeffs2))));
+            acc1 = vaddq_f32(acc1, vaddq_f32(
+                vmulq_f32(buf1_hi, vld1q_f32(coeffs1 + 4)),
+                vmulq_f32(buf2_hi, vld1q_f32(coeffs2 + 4))));
+            acc2 = vaddq_f32(acc2, vaddq_f32(
+                vmulq_f32(vector_reverse_ps(buf1_hi), vld1q_f32(coeffs1 + 8)),
+                vmulq_f32(vector_reverse_ps(buf2_hi), vld1q_f32(coeffs2 + 8))));
+            acc3 = vaddq_f32(acc3, vaddq_f32(
+                vmulq_f32(vector_reverse_ps(buf1_lo), vld1q_f32(coeffs1 + 12)),
+                vmulq_f32(vector_reverse_ps(buf2_lo), vld1q_f32(coeffs2 + 12))));
 #else
             for (i = 0; i < 8; i++) {
                 outp[i] += buf1[i] * coeffs1[i] + buf2[i] * coeffs2[i];
@@ -709,6 +746,18 @@ void ff_atrac3p_ipqf(FFTContext *dct_ctx, Atrac3pIPQFChannelCtx *hist,
             pos_next = mod23_lut[pos_now + 2];  // pos_next = (pos_next + 2) % 23;
         }
 
+#if PPSSPP_ARCH(SSE2)
+        _mm_storeu_ps(outp, acc0);
+        _mm_storeu_ps(outp + 4, acc1);
+        _mm_storeu_ps(outp + 8, acc2);
+        _mm_storeu_ps(outp + 12, acc3);
+#elif PPSSPP_ARCH(ARM_NEON)
+        vst1q_f32(outp, acc0);
+        vst1q_f32(outp + 4, acc1);
+        vst1q_f32(outp + 8, acc2);
+        vst1q_f32(outp + 12, acc3);
+#endif
+
         hist->pos = mod23_lut[hist->pos]; // hist->pos = (hist->pos - 1) % 23;
     }
 }
@@ -32,11 +32,23 @@
 #define _USE_MATH_DEFINES
 #include <math.h>
 
+#include "Common/Math/CrossSIMD.h"
+
 #include "mem.h"
 #include "fft.h"
 
 #define sqrthalf (float)M_SQRT1_2
 
+// The transforms below are templates on the complex type, so that besides the plain FFTComplex,
+// they can also run four independent transforms at once, one in each SIMD lane (see imdct_half4).
+// Every lane goes through exactly the same operations as the plain version.
+struct FFTComplex4 {
+    Vec4F32 re, im;
+};
+
+template <typename Complex>
+using FFTSampleOf = decltype(Complex::re);
+
 void imdct_calc(FFTContext *s, FFTSample *output, const FFTSample *input);
 void imdct_half(FFTContext *s, FFTSample *output, const FFTSample *input);
 
@@ -159,7 +171,7 @@ void ff_fft_end(FFTContext *s)
 // this is slightly slower for small data, but avoids store->load aliasing
 // for addresses separated by large powers of 2.
 #define BUTTERFLIES_BIG(a0,a1,a2,a3) {\
-    FFTSample r0=a0.re, i0=a0.im, r1=a1.re, i1=a1.im;\
+    FFTSampleOf<Complex> r0=a0.re, i0=a0.im, r1=a1.re, i1=a1.im;\
     BF(t3, t5, t5, t1);\
     BF(a2.re, a0.re, r0, t5);\
     BF(a3.im, a1.im, i1, t3);\
@@ -184,9 +196,10 @@ void ff_fft_end(FFTContext *s)
 
 /* z[0...8n-1], w[1...2n-1] */
 #define PASS(name)\
-static void name(FFTComplex *z, const FFTSample *wre, unsigned int n)\
+template <typename Complex>\
+static void name(Complex *z, const FFTSample *wre, unsigned int n)\
 {\
-    FFTDouble t1, t2, t3, t4, t5, t6;\
+    FFTSampleOf<Complex> t1, t2, t3, t4, t5, t6;\
     int o1 = 2*n;\
     int o2 = 4*n;\
     int o3 = 6*n;\
@@ -210,7 +223,8 @@ PASS(pass)
 PASS(pass_big)
 
 #define DECL_FFT(n,n2,n4)\
-static void fft##n(FFTComplex *z)\
+template <typename Complex>\
+static void fft##n(Complex *z)\
 {\
     fft##n2(z);\
     fft##n4(z+n4*2);\
@@ -218,9 +232,10 @@ static void fft##n(FFTComplex *z)\
     pass(z,av_cos_##n,n4/2);\
 }
 
-static void fft4(FFTComplex *z)
+template <typename Complex>
+static void fft4(Complex *z)
 {
-    FFTDouble t1, t2, t3, t4, t5, t6, t7, t8;
+    FFTSampleOf<Complex> t1, t2, t3, t4, t5, t6, t7, t8;
 
     BF(t3, t1, z[0].re, z[1].re);
     BF(t8, t6, z[3].re, z[2].re);
@@ -232,9 +247,10 @@ static void fft4(FFTComplex *z)
     BF(z[2].im, z[0].im, t2, t5);
 }
 
-static void fft8(FFTComplex *z)
+template <typename Complex>
+static void fft8(Complex *z)
 {
-    FFTDouble t1, t2, t3, t4, t5, t6;
+    FFTSampleOf<Complex> t1, t2, t3, t4, t5, t6;
 
     fft4(z);
 
@@ -247,9 +263,10 @@ static void fft8(FFTComplex *z)
     TRANSFORM(z[1],z[3],z[5],z[7],sqrthalf,sqrthalf);
 }
 
-static void fft16(FFTComplex *z)
+template <typename Complex>
+static void fft16(Complex *z)
 {
-    FFTDouble t1, t2, t3, t4, t5, t6;
+    FFTSampleOf<Complex> t1, t2, t3, t4, t5, t6;
     FFTSample cos_16_1 = av_cos_16[1];
     FFTSample cos_16_3 = av_cos_16[3];
 
@@ -278,10 +295,16 @@ void fft_calc(FFTContext *s, FFTComplex *z) {
     fft_dispatch[s->nbits-2](z);
 }
 
+// Only the small ones, see IMDCT_HALF4_MAX_SIZE.
+static void (* const fft4_dispatch[])(FFTComplex4*) = {
+    fft4, fft8, fft16,
+};
+
 #include <stdlib.h>
 #include <string.h>
 
 #include "fft.h"
+#include "float_dsp.h"
 #include "mem.h"
 
 /**
@@ -376,6 +399,45 @@ void imdct_half(FFTContext *s, FFTSample *output, const FFTSample *input)
 	}
 }
 
+/**
+ * Same as imdct_half, but four different inputs at once.
+ * Input i of transform l is at input[i * stride + l], and output i ends up in output[i][l].
+ */
+void imdct_half4(FFTContext *s, FFTSample (*output)[4], const FFTSample *input, int stride)
+{
+	int k, n8, n4, n2, n, j;
+	const uint16_t *revtab = s->revtab;
+	const FFTSample *tcos = s->tcos;
+	const FFTSample *tsin = s->tsin;
+	FFTComplex4 z[IMDCT_HALF4_MAX_SIZE / 4];
+
+	n = 1 << s->mdct_bits;
+	n2 = n >> 1;
+	n4 = n >> 2;
+	n8 = n >> 3;
+	av_assert0(n <= IMDCT_HALF4_MAX_SIZE);
+
+	/* pre rotation */
+	for (k = 0; k < n4; k++) {
+		j = revtab[k];
+		const Vec4F32 in1 = Vec4F32::Load(input + (2 * k) * stride);
+		const Vec4F32 in2 = Vec4F32::Load(input + (n2 - 1 - 2 * k) * stride);
+		CMUL(z[j].re, z[j].im, in2, in1, tcos[k], tsin[k]);
+	}
+	fft4_dispatch[s->nbits - 2](z);
+
+	/* post rotation + reordering */
+	for (k = 0; k < n8; k++) {
+		Vec4F32 r0, i0, r1, i1;
+		CMUL(r0, i1, z[n8 - k - 1].im, z[n8 - k - 1].re, tsin[n8 - k - 1], tcos[n8 - k - 1]);
+		CMUL(r1, i0, z[n8 + k].im, z[n8 + k].re, tsin[n8 + k], tcos[n8 + k]);
+		r0.Store(output[2 * (n8 - k - 1)]);
+		i0.Store(output[2 * (n8 - k - 1) + 1]);
+		r1.Store(output[2 * (n8 + k)]);
+		i1.Store(output[2 * (n8 + k) + 1]);
+	}
+}
+
 /**
  * Compute inverse MDCT of size N = 2^nbits
  * @param output N samples
@@ -383,17 +445,15 @@ void imdct_half(FFTContext *s, FFTSample *output, const FFTSample *input)
  */
 void imdct_calc(FFTContext *s, FFTSample *output, const FFTSample *input)
 {
-	int k;
 	int n = 1 << s->mdct_bits;
 	int n2 = n >> 1;
 	int n4 = n >> 2;
 
 	imdct_half(s, output + n4, input);
 
-	for (k = 0; k < n4; k++) {
-		output[k] = -output[n2 - k - 1];
-		output[n - k - 1] = output[n2 + k];
-	}
+	// output[k] = -output[n2 - k - 1], output[n - k - 1] = output[n2 + k]
+	vector_fmul_scalar_reverse(output, output + n4, -1.0f, n4);
+	vector_fmul_scalar_reverse(output + n - n4, output + n2, 1.0f, n4);
 }
 
 void ff_mdct_end(FFTContext *s)
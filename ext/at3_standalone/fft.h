@@ -69,6 +69,10 @@ void fft_calc(struct FFTContext *s, FFTComplex *z);
 void imdct_calc(struct FFTContext *s, FFTSample *output, const FFTSample *input);
 void imdct_half(struct FFTContext *s, FFTSample *output, const FFTSample *input);
 
+// Four transforms at once, for small sizes like the ATRAC3+ IPQF's.
+#define IMDCT_HALF4_MAX_SIZE 64
+void imdct_half4(struct FFTContext *s, FFTSample (*output)[4], const FFTSample *input, int stride);
+
 #define COSTABLE(size) \
      DECLARE_ALIGNED(32, FFTSample, av_cos_##size)[size/2]
 
@@ -18,10 +18,51 @@
 
 #pragma once
 
+#include <stdint.h>
+
+#include "ppsspp_config.h"
+
+#if PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+
+#include <emmintrin.h>
+
+#elif PPSSPP_ARCH(ARM_NEON)
+
+#if defined(_MSC_VER) && PPSSPP_ARCH(ARM64)
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+
+#endif
+
 #include "compat.h"
 
+// The loops below have SSE2 and NEON versions, picked at compile time like the rest of PPSSPP.
+// Each lane does the same multiplies and adds as the plain C, in the same order, so the output
+// doesn't change. Lengths that aren't a multiple of 4 are finished off in C.
+
+#if PPSSPP_ARCH(SSE2)
+inline __m128 vector_reverse_ps(__m128 x) {
+    return _mm_shuffle_ps(x, x, _MM_SHUFFLE(0, 1, 2, 3));
+}
+#elif PPSSPP_ARCH(ARM_NEON)
+inline float32x4_t vector_reverse_ps(float32x4_t x) {
+    float32x4_t rev = vrev64q_f32(x);
+    return vcombine_f32(vget_high_f32(rev), vget_low_f32(rev));
+}
+#endif
+
 inline void vector_fmul(float * av_restrict dst, const float * av_restrict src, int len) {
-    for (int i = 0; i < len; i++)
+    int i = 0;
+#if PPSSPP_ARCH(SSE2)
+    for (; i + 4 <= len; i += 4)
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_loadu_ps(dst + i), _mm_loadu_ps(src + i)));
+#elif PPSSPP_ARCH(ARM_NEON)
+    for (; i + 4 <= len; i += 4)
+        vst1q_f32(dst + i, vmulq_f32(vld1q_f32(dst + i), vld1q_f32(src + i)));
+#endif
+    for (; i < len; i++)
         dst[i] = dst[i] * src[i];
 }
 
@@ -30,10 +71,64 @@ inline void vector_fmul(float * av_restrict dst, const float * av_restrict src,
 * destination vectors must overlap exactly or not at all.
 */
 inline void vector_fmul_scalar(float *dst, float mul, int len) {
-    for (int i = 0; i < len; i++)
+    int i = 0;
+#if PPSSPP_ARCH(SSE2)
+    const __m128 m = _mm_set1_ps(mul);
+    for (; i + 4 <= len; i += 4)
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_loadu_ps(dst + i), m));
+#elif PPSSPP_ARCH(ARM_NEON)
+    for (; i + 4 <= len; i += 4)
+        vst1q_f32(dst + i, vmulq_n_f32(vld1q_f32(dst + i), mul));
+#endif
+    for (; i < len; i++)
         dst[i] *= mul;
 }
 
+/**
+* Multiply a vector of floats by a scalar float and add to
+* destination vector.  Source and destination vectors must
+* overlap exactly or not at all.
+*/
+inline void vector_fmac_scalar(float *dst, const float *src, float mul, int len) {
+    int i = 0;
+#if PPSSPP_ARCH(SSE2)
+    const __m128 m = _mm_set1_ps(mul);
+    for (; i + 4 <= len; i += 4)
+        _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_loadu_ps(src + i), m)));
+#elif PPSSPP_ARCH(ARM_NEON)
+    for (; i + 4 <= len; i += 4)
+        vst1q_f32(dst + i, vaddq_f32(vld1q_f32(dst + i), vmulq_n_f32(vld1q_f32(src + i), mul)));
+#endif
+    for (; i < len; i++)
+        dst[i] += src[i] * mul;
+}
+
+/**
+* Convert a vector of int16 to float, and multiply it by a scalar.
+* Like int32_to_float_fmul_scalar in FFmpeg's FmtConvertContext.
+*/
+inline void int16_to_float_fmul_scalar(float * av_restrict dst, const int16_t * av_restrict src, float mul, int len) {
+    int i = 0;
+#if PPSSPP_ARCH(SSE2)
+    const __m128 m = _mm_set1_ps(mul);
+    for (; i + 8 <= len; i += 8) {
+        const __m128i x = _mm_loadu_si128((const __m128i *)(src + i));
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), m));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), m));
+    }
+#elif PPSSPP_ARCH(ARM_NEON)
+    for (; i + 8 <= len; i += 8) {
+        const int16x8_t x = vld1q_s16(src + i);
+        vst1q_f32(dst + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), mul));
+        vst1q_f32(dst + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), mul));
+    }
+#endif
+    for (; i < len; i++)
+        dst[i] = src[i] * mul;
+}
+
 /**
 * Calculate the entry wise product of two vectors of floats, and store the result
 * in a vector of floats. The second vector of floats is iterated over
@@ -47,7 +142,61 @@ inline void vector_fmul_scalar(float *dst, float mul, int len) {
 *             constraints: multiple of 16
 */
 inline void vector_fmul_reverse(float * av_restrict dst, const float * av_restrict src, int len) {
+    int i = 0;
+#if PPSSPP_ARCH(SSE2)
+    for (; i + 4 <= len; i += 4)
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_loadu_ps(dst + i), vector_reverse_ps(_mm_loadu_ps(src + len - 4 - i))));
+#elif PPSSPP_ARCH(ARM_NEON)
+    for (; i + 4 <= len; i += 4)
+        vst1q_f32(dst + i, vmulq_f32(vld1q_f32(dst + i), vector_reverse_ps(vld1q_f32(src + len - 4 - i))));
+#endif
     src += len - 1;
-    for (int i = 0; i < len; i++)
+    for (; i < len; i++)
         dst[i] *= src[-i];
 }
+
+/**
+* Store src backwards into dst, multiplied by a scalar (1.0f or -1.0f for a plain or negated copy).
+* The vectors must not overlap.
+*/
+inline void vector_fmul_scalar_reverse(float * av_restrict dst, const float * av_restrict src, float mul, int len) {
+    int i = 0;
+#if PPSSPP_ARCH(SSE2)
+    const __m128 m = _mm_set1_ps(mul);
+    for (; i + 4 <= len; i += 4)
+        _mm_storeu_ps(dst + i, _mm_mul_ps(vector_reverse_ps(_mm_loadu_ps(src + len - 4 - i)), m));
+#elif PPSSPP_ARCH(ARM_NEON)
+    for (; i + 4 <= len; i += 4)
+        vst1q_f32(dst + i, vmulq_n_f32(vector_reverse_ps(vld1q_f32(src + len - 4 - i)), mul));
+#endif
+    src += len - 1;
+    for (; i < len; i++)
+        dst[i] = src[-i] * mul;
+}
+
+/**
+* Reverse the order of a vector of floats, in place.
+*/
+inline void vector_reverse(float *buf, int len) {
+    int i = 0;
+#if PPSSPP_ARCH(SSE2)
+    for (; 2 * i + 8 <= len; i += 4) {
+        const __m128 a = _mm_loadu_ps(buf + i);
+        const __m128 b = _mm_loadu_ps(buf + len - 4 - i);
+        _mm_storeu_ps(buf + i, vector_reverse_ps(b));
+        _mm_storeu_ps(buf + len - 4 - i, vector_reverse_ps(a));
+    }
+#elif PPSSPP_ARCH(ARM_NEON)
+    for (; 2 * i + 8 <= len; i += 4) {
+        const float32x4_t a = vld1q_f32(buf + i);
+        const float32x4_t b = vld1q_f32(buf + len - 4 - i);
+        vst1q_f32(buf + i, vector_reverse_ps(b));
+        vst1q_f32(buf + len - 4 - i, vector_reverse_ps(a));
+    }
+#endif
+    for (; i < len / 2; i++) {
+        const float tmp = buf[i];
+        buf[i] = buf[len - 1 - i];
+        buf[len - 1 - i] = tmp;
+    }
+}
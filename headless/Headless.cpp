@@ -55,10 +55,14 @@
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
 #include "Core/EmuThread.h"
+#include "Core/HW/Atrac3Standalone.h"
+#include "Core/HW/SimpleAudioDec.h"
 #include "Core/MIPS/MIPSTables.h"
 #include "Core/System.h"
+#include "Core/Util/AtracTrack.h"
 #include "Core/Util/PSARUnpack.h"
 #include "Core/WebServer.h"
+#include "Core/HLE/sceAudiocodec.h"
 #include "Core/HLE/sceUtility.h"
 #include "Core/SaveState.h"
 #include "GPU/GPUCommon.h"
@@ -425,15 +429,15 @@ std::vector<std::string> ReadFromListFile(const std::string &listFilename) {
 	return testFilenames;
 }
 
-static void AddRecursively(std::vector<std::string> *tests, Path actualPath) {
+static void AddRecursively(std::vector<std::string> *tests, Path actualPath, const char *extensionFilter = "prx") {
 	// TODO: Some file systems can optimize this.
 	std::vector<File::FileInfo> fileInfo;
-	if (!File::GetFilesInDir(actualPath, &fileInfo, "prx")) {
+	if (!File::GetFilesInDir(actualPath, &fileInfo, extensionFilter)) {
 		return;
 	}
 	for (const auto &file : fileInfo) {
 		if (file.isDirectory) {
-			AddRecursively(tests, actualPath / file.name);
+			AddRecursively(tests, actualPath / file.name, extensionFilter);
 		} else if (file.name != "Makefile") {  // hack around filter problem
 			tests->push_back((actualPath / file.name).ToString());
 		}
@@ -453,6 +457,86 @@ static void AddToTestsByPath(std::vector<std::string> *tests, std::string_view p
 	}
 }
 
+// Decodes each file from start to end, a few times over if it's short, through the same decoder
+// the Atrac code uses. Returns the retval that will be returned from main.
+static int BenchmarkAtracDecode(const std::vector<std::string> &paths) {
+	std::vector<std::string> filenames;
+	for (const std::string &path : paths) {
+		if (File::IsDirectory(Path(path)))
+			AddRecursively(&filenames, Path(path), "at3");
+		else
+			filenames.push_back(path);
+	}
+
+	std::vector<int16_t> pcm(ATRAC3PLUS_MAX_SAMPLES * 2);
+	int failed = 0;
+	int totalFrames = 0;
+	double totalSeconds = 0.0;
+	for (const std::string &filename : filenames) {
+		std::string data;
+		Track track;
+		std::string error;
+		if (!File::ReadBinaryFileToString(Path(filename), &data)) {
+			fprintf(stderr, "%s: Failed to read\n", filename.c_str());
+			failed++;
+			continue;
+		}
+		if (AnalyzeAtracTrack((const u8 *)data.data(), (u32)data.size(), &track, &error) < 0 || track.bytesPerFrame == 0) {
+			fprintf(stderr, "%s: %s\n", filename.c_str(), error.c_str());
+			failed++;
+			continue;
+		}
+
+		AudioDecoder *decoder;
+		if (track.codecType == PSP_CODEC_AT3) {
+			// Same as AtracBase::CreateDecoder.
+			bool jointStereo = IsAtrac3StreamJointStereo(track.codecType, track.bytesPerFrame, track.channels);
+			uint8_t extraData[14]{};
+			extraData[0] = 1;
+			extraData[3] = track.channels << 3;
+			extraData[6] = jointStereo;
+			extraData[8] = jointStereo;
+			extraData[10] = 1;
+			decoder = CreateAtrac3Audio(track.channels, track.bytesPerFrame, extraData, sizeof(extraData));
+		} else {
+			decoder = CreateAtrac3PlusAudio(track.channels, track.bytesPerFrame);
+		}
+
+		const u8 *frames = (const u8 *)data.data() + track.dataByteOffset;
+		// Stop at the end of the track, there can be other chunks after the data.
+		const int samplesPerFrame = track.SamplesPerFrame();
+		const int endFrame = (track.endSample + 1 + track.FirstSampleOffsetFull() + samplesPerFrame - 1) / samplesPerFrame;
+		const int numFrames = std::min(endFrame, ((int)data.size() - track.dataByteOffset) / track.bytesPerFrame);
+		int decodedFrames = 0;
+		bool success = numFrames > 0;
+		double start = time_now_d();
+		while (success && time_now_d() - start < 0.5) {
+			for (int i = 0; i < numFrames && success; i++) {
+				int outSamples = 0;
+				success = decoder->Decode(frames + i * track.bytesPerFrame, track.bytesPerFrame, nullptr, 2, pcm.data(), &outSamples);
+			}
+			decodedFrames += numFrames;
+		}
+		const double seconds = time_now_d() - start;
+		delete decoder;
+
+		if (!success) {
+			fprintf(stderr, "%s: Failed to decode\n", filename.c_str());
+			failed++;
+			continue;
+		}
+		const double audioSeconds = (double)decodedFrames * samplesPerFrame / 44100.0;
+		printf("%s: %s, %d ch, %d kbps: %0.0f frames/s (%0.1fx realtime)\n", filename.c_str(), track.codecType == PSP_CODEC_AT3 ? "at3" : "at3+",
+			track.channels, track.Bitrate(), decodedFrames / seconds, audioSeconds / seconds);
+		totalFrames += decodedFrames;
+		totalSeconds += seconds;
+	}
+
+	if (totalFrames > 0)
+		printf("Total: %d files, %0.0f frames/s\n", (int)filenames.size() - failed, totalFrames / totalSeconds);
+	return failed == 0 && !filenames.empty() ? 0 : 1;
+}
+
 // Returns the retval that will be returned from main.
 int RunTests(GraphicsContext *graphicsContext, CoreParameter &coreParameter, const AutoTestOptions &testOptions, const std::vector<std::string> &testFilenames) {
 	std::vector<std::string> failedTests;
@@ -647,6 +731,11 @@ int main(int argc, const char* argv[]) {
 		return ok ? 0 : 1;
 	}
 
+	// Same for the Atrac decoding benchmark.
+	if (cmdLineOptions.benchAtrac.value_or(false)) {
+		return BenchmarkAtracDecode(cmdLineOptions.bootFilenames);
+	}
+
 	g_Config.RestoreDefaults(RestoreSettingsBits::SETTINGS | RestoreSettingsBits::CONTROLS | RestoreSettingsBits::RECENT, false);
 
 	Core_RegisterDebugOutputListeners(&SendDebugOutput, &SendDebugScreenshot);
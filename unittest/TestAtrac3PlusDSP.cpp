@@ -0,0 +1,159 @@
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Common/CPUDetect.h"
+#include "Common/CommonTypes.h"
+#include "ext/at3_standalone/atrac3plus.h"
+#include "ext/at3_standalone/fft.h"
+#include "ext/at3_standalone/float_dsp.h"
+#include "UnitTest.h"
+
+// The SIMD versions of the Atrac3+ DSP must give exactly the same output as the plain C they
+// replaced, so these compare bit for bit.
+
+static u32 g_dspSeed;
+static float DspRandFloat() {
+	g_dspSeed = g_dspSeed * 1664525 + 1013904223;
+	return ((int)((g_dspSeed >> 8) & 0xFFFF) - 32768) * (1.0f / 1024.0f);
+}
+
+static s16 DspRandS16() {
+	g_dspSeed = g_dspSeed * 1664525 + 1013904223;
+	return (s16)(g_dspSeed >> 16);
+}
+
+static void FillRandom(std::vector<float> &v) {
+	for (float &f : v)
+		f = DspRandFloat();
+}
+
+static bool SameBits(const std::vector<float> &a, const std::vector<float> &b, const char *name, int len) {
+	if (memcmp(a.data(), b.data(), a.size() * sizeof(float)) != 0) {
+		printf("Atrac3PlusDSP: %s differs for length %d\n", name, len);
+		return false;
+	}
+	return true;
+}
+
+static bool TestFloatDSP() {
+	static const int lengths[] = { 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 128, 256 };
+	for (int len : lengths) {
+		std::vector<float> dst(len), src(len), ref(len);
+		std::vector<s16> src16(len);
+		FillRandom(dst);
+		FillRandom(src);
+		for (s16 &s : src16)
+			s = DspRandS16();
+		const float mul = DspRandFloat();
+
+		ref = dst;
+		for (int i = 0; i < len; i++)
+			ref[i] = ref[i] * src[i];
+		std::vector<float> out = dst;
+		vector_fmul(out.data(), src.data(), len);
+		RET(SameBits(out, ref, "vector_fmul", len));
+
+		ref = dst;
+		for (int i = 0; i < len; i++)
+			ref[i] *= mul;
+		out = dst;
+		vector_fmul_scalar(out.data(), mul, len);
+		RET(SameBits(out, ref, "vector_fmul_scalar", len));
+
+		ref = dst;
+		for (int i = 0; i < len; i++)
+			ref[i] += src[i] * mul;
+		out = dst;
+		vector_fmac_scalar(out.data(), src.data(), mul, len);
+		RET(SameBits(out, ref, "vector_fmac_scalar", len));
+
+		for (int i = 0; i < len; i++)
+			ref[i] = src16[i] * mul;
+		int16_to_float_fmul_scalar(out.data(), src16.data(), mul, len);
+		RET(SameBits(out, ref, "int16_to_float_fmul_scalar", len));
+
+		ref = dst;
+		for (int i = 0; i < len; i++)
+			ref[i] *= src[len - 1 - i];
+		out = dst;
+		vector_fmul_reverse(out.data(), src.data(), len);
+		RET(SameBits(out, ref, "vector_fmul_reverse", len));
+
+		for (int i = 0; i < len; i++)
+			ref[i] = src[len - 1 - i] * mul;
+		vector_fmul_scalar_reverse(out.data(), src.data(), mul, len);
+		RET(SameBits(out, ref, "vector_fmul_scalar_reverse", len));
+
+		for (int i = 0; i < len; i++)
+			ref[i] = dst[len - 1 - i];
+		out = dst;
+		vector_reverse(out.data(), len);
+		RET(SameBits(out, ref, "vector_reverse", len));
+	}
+	return true;
+}
+
+static bool TestImdctHalf4() {
+	// The IPQF uses 5 bits, and 6 is the most imdct_half4 supports.
+	for (int nbits = 5; nbits <= 6; nbits++) {
+		const int n = 1 << nbits;
+		FFTContext ctx;
+		EXPECT_EQ_INT(ff_mdct_init(&ctx, nbits, 1, 32.0 / 32768.0), 0);
+
+		// Four transforms interleaved, like the IPQF's subband samples.
+		const int stride = 4;
+		std::vector<float> input(n / 2 * stride);
+		for (int iter = 0; iter < 16; iter++) {
+			FillRandom(input);
+
+			FFTSample out4[IMDCT_HALF4_MAX_SIZE / 2][4];
+			imdct_half4(&ctx, out4, input.data(), stride);
+
+			for (int lane = 0; lane < 4; lane++) {
+				std::vector<float> in1(n / 2), out1(n / 2);
+				for (int i = 0; i < n / 2; i++)
+					in1[i] = input[i * stride + lane];
+				imdct_half(&ctx, out1.data(), in1.data());
+
+				for (int i = 0; i < n / 2; i++) {
+					if (memcmp(&out1[i], &out4[i][lane], sizeof(float)) != 0) {
+						printf("Atrac3PlusDSP: imdct_half4 lane %d differs at %d for %d bits (%f vs %f)\n", lane, i, nbits, out4[i][lane], out1[i]);
+						ff_mdct_end(&ctx);
+						return false;
+					}
+				}
+			}
+		}
+		ff_mdct_end(&ctx);
+	}
+	return true;
+}
+
+static bool TestIPQFAVX2() {
+	if (!cpu_info.bAVX2)
+		return true;
+
+	FFTContext ctx;
+	EXPECT_EQ_INT(ff_mdct_init(&ctx, 5, 1, 32.0 / 32768.0), 0);
+
+	// Run both FIRs over the same frames, so the histories go through the same states.
+	Atrac3pIPQFChannelCtx histAVX2{}, histSSE{};
+	std::vector<float> in(ATRAC3P_FRAME_SAMPLES), outAVX2(ATRAC3P_FRAME_SAMPLES), outSSE(ATRAC3P_FRAME_SAMPLES);
+	bool success = true;
+	for (int frame = 0; frame < 8 && success; frame++) {
+		FillRandom(in);
+		ff_atrac3p_ipqf(&ctx, &histAVX2, in.data(), outAVX2.data());
+		cpu_info.bAVX2 = false;
+		ff_atrac3p_ipqf(&ctx, &histSSE, in.data(), outSSE.data());
+		cpu_info.bAVX2 = true;
+		success = SameBits(outAVX2, outSSE, "ff_atrac3p_ipqf (AVX2)", frame);
+	}
+	ff_mdct_end(&ctx);
+	return success;
+}
+
+bool TestAtrac3PlusDSP() {
+	g_dspSeed = 1;
+	return TestFloatDSP() && TestImdctHalf4() && TestIPQFAVX2();
+}
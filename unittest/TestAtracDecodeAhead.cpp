@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "Common/CPUDetect.h"
+#include "Common/CommonTypes.h"
+#include "Common/Log.h"
+#include "Common/Thread/ThreadManager.h"
+#include "Core/Config.h"
+#include "Core/HLE/AtracCtx2.h"
+#include "Core/HLE/ErrorCodes.h"
+#include "Core/HW/SimpleAudioDec.h"
+#include "Core/MemMap.h"
+#include "Core/Util/AtracTrack.h"
+#include "UnitTest.h"
+
+// Decode-ahead (the AtracDecodeAhead setting) must not change what the game hears, also when it
+// seeks and refills the buffer while frames are queued. These play the same track both ways and
+// compare the PCM. The one exception is the first frame after a seek. Dropping queued frames
+// flushes the decoder, while without decode-ahead it overlaps with the frame played before the seek.
+
+static const u32 CONTEXT_ADDR = 0x08800000;
+static const u32 BUFFER_ADDR = 0x08810000;
+static const u32 OUT_ADDR = 0x08900000;
+
+static const int TRACK_FRAMES = 60;
+static const int TRACK_BLOCK_ALIGN = 0x230;
+static const int TRACK_SAMPLES_PER_FRAME = 2048;
+
+// Stands in for the Atrac3+ decoder, which can't decode random packets. Like the real one, each frame
+// overlaps with the packet before it until flushed, so a decoder left in the wrong state shows up.
+class FakeAtracDecoder : public AudioDecoder {
+public:
+	PSPAudioType GetAudioType() const override { return PSP_CODEC_AT3PLUS; }
+	bool Decode(const uint8_t *inbuf, int inbytes, int *inbytesConsumed, int outputChannels, int16_t *outbuf, int *outSamples) override {
+		u32 packet = 0;
+		for (int i = 0; i < inbytes; i++)
+			packet = packet * 31 + inbuf[i];
+		const u32 state = packet ^ (prev_ * 0x9E3779B9);
+		prev_ = packet;
+		*inbytesConsumed = inbytes;
+		*outSamples = TRACK_SAMPLES_PER_FRAME;
+		if (outbuf) {
+			u32 x = state;
+			for (int i = 0; i < TRACK_SAMPLES_PER_FRAME * outputChannels; i++) {
+				x = x * 1664525 + 1013904223;
+				outbuf[i] = (int16_t)(x >> 16);
+			}
+		}
+		return true;
+	}
+	bool IsOK() const override { return true; }
+	void SetChannels(int channels) override {}
+	void FlushBuffers() override { prev_ = 0; }
+
+private:
+	u32 prev_ = 0;
+};
+
+class TestAtrac2 : public Atrac2 {
+public:
+	using Atrac2::Atrac2;
+	void ReplaceDecoder(AudioDecoder *decoder) {
+		delete decoder_;
+		decoder_ = decoder;
+	}
+};
+
+static void Put32(std::vector<u8> &data, u32 value) {
+	for (int i = 0; i < 4; i++)
+		data.push_back((u8)(value >> (i * 8)));
+}
+
+static void Put16(std::vector<u8> &data, u16 value) {
+	data.push_back((u8)value);
+	data.push_back((u8)(value >> 8));
+}
+
+// A RIFF WAVE Atrac3+ file with random packets. The fact chunk puts the first sample early enough
+// that SetData has no frames to skip, so nothing is decoded before the fake decoder is swapped in.
+static std::vector<u8> GenerateTrack() {
+	static const u8 at3plusGuid[16] = {
+		0xBF, 0xAA, 0x23, 0xE9, 0x58, 0xCB, 0x71, 0x44,
+		0xA1, 0x19, 0xFF, 0xFA, 0x01, 0xE4, 0xCE, 0x62,
+	};
+	const u32 dataSize = TRACK_FRAMES * TRACK_BLOCK_ALIGN;
+
+	std::vector<u8> file;
+	file.insert(file.end(), { 'R', 'I', 'F', 'F' });
+	Put32(file, 0);  // Filled in below.
+	file.insert(file.end(), { 'W', 'A', 'V', 'E' });
+
+	file.insert(file.end(), { 'f', 'm', 't', ' ' });
+	Put32(file, 0x34);
+	Put16(file, 0xFFFE);  // WAVE_FORMAT_EXTENSIBLE
+	Put16(file, 2);
+	Put32(file, 44100);
+	Put32(file, TRACK_BLOCK_ALIGN * 44100 / TRACK_SAMPLES_PER_FRAME);
+	Put16(file, TRACK_BLOCK_ALIGN);
+	Put16(file, 0);
+	Put16(file, 0x22);
+	Put16(file, 0);
+	Put32(file, 3);  // Channel mask
+	file.insert(file.end(), at3plusGuid, at3plusGuid + sizeof(at3plusGuid));
+	Put16(file, 1);
+	file.push_back(0x28);  // Codec params, the channel count is in here too.
+	file.push_back(0);
+	Put32(file, 0);
+	Put32(file, 0);
+
+	file.insert(file.end(), { 'f', 'a', 'c', 't' });
+	Put32(file, 8);
+	Put32(file, (TRACK_FRAMES - 1) * TRACK_SAMPLES_PER_FRAME - 0x270);
+	Put32(file, 0x100);
+
+	file.insert(file.end(), { 'd', 'a', 't', 'a' });
+	Put32(file, dataSize);
+	u32 seed = 1;
+	for (u32 i = 0; i < dataSize; i++) {
+		seed = seed * 1664525 + 1013904223;
+		file.push_back((u8)(seed >> 16));
+	}
+
+	const u32 riffSize = (u32)file.size() - 8;
+	memcpy(&file[4], &riffSize, 4);
+	return file;
+}
+
+static void WriteFromFile(const std::vector<u8> &file, u32 addr, u32 fileOffset, u32 size) {
+	memcpy(Memory::GetPointerWriteUnchecked(addr), file.data() + fileOffset, size);
+}
+
+// Plays the track like a game would: decode, top up the buffer a bit at a time, and seek twice.
+// The PCM of the first decode after each seek is listed in afterSeek.
+static bool PlayTrack(const std::vector<u8> &file, u32 readSize, u32 bufferSize, bool decodeAhead, std::vector<s16> &pcm, std::vector<std::pair<size_t, size_t>> &afterSeek) {
+	g_Config.bAtracDecodeAhead = decodeAhead;
+	memset(Memory::GetPointerWriteUnchecked(CONTEXT_ADDR), 0, sizeof(SceAtracContext));
+	TestAtrac2 atrac(CONTEXT_ADDR, PSP_CODEC_AT3PLUS);
+
+	WriteFromFile(file, BUFFER_ADDR, 0, readSize);
+	EXPECT_EQ_INT(atrac.SetData(Track(), BUFFER_ADDR, readSize, bufferSize, (u32)file.size(), 2, false), 0);
+	atrac.ReplaceDecoder(new FakeAtracDecoder());
+
+	bool seeked = false;
+	for (int step = 0; step < 200; step++) {
+		if (step == 12 || step == 30) {
+			// Seek back, then forward, while there are frames queued.
+			const int sample = step == 12 ? 5000 : 70000;
+			AtracResetBufferInfo resetInfo;
+			bool delay = false;
+			EXPECT_EQ_INT(atrac.GetBufferInfoForResetting(&resetInfo, sample, &delay), 0);
+			WriteFromFile(file, resetInfo.first.writePosPtr, resetInfo.first.filePos, resetInfo.first.writableBytes);
+			EXPECT_EQ_INT(atrac.ResetPlayPosition(sample, resetInfo.first.writableBytes, 0, &delay), 0);
+			seeked = true;
+		}
+
+		u32 writePtr, bytesToWrite, readFileOffset;
+		atrac.GetStreamDataInfo(&writePtr, &bytesToWrite, &readFileOffset);
+		const u32 bytes = std::min(bytesToWrite, (u32)TRACK_BLOCK_ALIGN * (1 + step % 3));
+		if (bytes != 0) {
+			WriteFromFile(file, writePtr, readFileOffset, bytes);
+			EXPECT_EQ_INT(atrac.AddStreamData(bytes), 0);
+		}
+
+		int samples = 0;
+		int finish = 0;
+		int remains = 0;
+		u32 result = atrac.DecodeData(Memory::GetPointerWriteUnchecked(OUT_ADDR), OUT_ADDR, &samples, &finish, &remains);
+		if (result == SCE_ERROR_ATRAC_ALL_DATA_DECODED)
+			break;
+		EXPECT_EQ_HEX(result, 0);
+		const s16 *out = (const s16 *)Memory::GetPointerUnchecked(OUT_ADDR);
+		if (seeked)
+			afterSeek.emplace_back(pcm.size(), pcm.size() + samples * 2);
+		seeked = false;
+		pcm.insert(pcm.end(), out, out + samples * 2);
+	}
+	return true;
+}
+
+static bool TestDecodeAheadMatches(const char *name, u32 readSize, u32 bufferSize) {
+	const std::vector<u8> file = GenerateTrack();
+
+	std::vector<s16> plain, ahead;
+	std::vector<std::pair<size_t, size_t>> plainSeeks, aheadSeeks;
+	RET(PlayTrack(file, readSize, bufferSize, false, plain, plainSeeks));
+	RET(PlayTrack(file, readSize, bufferSize, true, ahead, aheadSeeks));
+
+	EXPECT_TRUE(!plain.empty());
+	EXPECT_TRUE(plainSeeks == aheadSeeks);
+	// Only the overlap into the first frame after a seek may differ.
+	for (const auto &range : plainSeeks) {
+		for (size_t i = range.first; i < range.second && i < ahead.size(); i++)
+			ahead[i] = plain[i];
+	}
+	if (plain != ahead) {
+		size_t i = 0;
+		while (i < plain.size() && i < ahead.size() && plain[i] == ahead[i])
+			i++;
+		printf("AtracDecodeAhead: %s differs at sample %d (%d vs %d samples)\n", name, (int)i / 2, (int)plain.size() / 2, (int)ahead.size() / 2);
+		return false;
+	}
+	return true;
+}
+
+bool TestAtracDecodeAhead() {
+	Memory::g_MemorySize = Memory::RAM_NORMAL_SIZE;
+	if (!Memory::Init(Memory::MemMapSetupFlags::Default)) {
+		printf("Failed to init memory\n");
+		return false;
+	}
+	g_threadManager.Init(cpu_info.num_cores, cpu_info.logical_cpu_count);
+	const bool oldDecodeAhead = g_Config.bAtracDecodeAhead;
+
+	const u32 fileSize = (u32)GenerateTrack().size();
+	bool success = TestDecodeAheadMatches("all data loaded", fileSize, fileSize);
+	success = success && TestDecodeAheadMatches("halfway buffer", fileSize / 3, fileSize);
+	success = success && TestDecodeAheadMatches("streamed", 0x4000, 0x4000);
+
+	g_Config.bAtracDecodeAhead = oldDecodeAhead;
+	g_threadManager.Teardown();
+	Memory::Shutdown();
+	return success;
+}
@@ -19,6 +19,7 @@
 #include <cstring>
 #include "Core/MIPS/IR/IRInst.h"
 #include "Core/MIPS/IR/IRPassSimplify.h"
+#include "Core/MIPS/IR/IRRegAlloc.h"
 
 struct IRVerification {
 	const char *name;
@@ -168,6 +169,137 @@ static const IRVerification tests[] = {
 	},
 };
 
+static bool VerifyRegAllocHints() {
+	const IRInst insts[] = {
+		{ IROp::Add, { MIPS_REG_A0 }, MIPS_REG_A1, MIPS_REG_A2 },
+		{ IROp::Add, { MIPS_REG_A3 }, MIPS_REG_A0, MIPS_REG_A0 },
+		{ IROp::Add, { MIPS_REG_T0 }, MIPS_REG_A3, MIPS_REG_A1 },
+		{ IROp::Add, { MIPS_REG_T1 }, MIPS_REG_T0, MIPS_REG_T0 },
+	};
+
+	IRRegAllocHints hints;
+	// With only one reg, the scan should keep the most densely used of the overlapping intervals.
+	hints.Compute(insts, 4, 1, 1);
+
+	struct NextReadCheck {
+		MIPSGPReg reg;
+		int index;
+		int expected;
+	};
+	static const NextReadCheck nextReads[] = {
+		{ MIPS_REG_A1, 0, 0 },
+		{ MIPS_REG_A1, 1, 2 },
+		{ MIPS_REG_A2, 1, IRRegAllocHints::NO_READ },
+		{ MIPS_REG_A0, 1, 1 },
+		{ MIPS_REG_A0, 2, IRRegAllocHints::NO_READ },
+		{ MIPS_REG_T1, 0, IRRegAllocHints::NO_READ },
+	};
+	for (const auto &check : nextReads) {
+		int next = hints.NextRead(check.reg, false, check.index);
+		if (next != check.expected) {
+			printf("RegAllocHints FAILED: next read of %d from %d was %d, expected %d\n", check.reg, check.index, next, check.expected);
+			return false;
+		}
+	}
+
+	const MIPSGPReg resident[] = { MIPS_REG_A0, MIPS_REG_T0 };
+	const MIPSGPReg spilled[] = { MIPS_REG_A1, MIPS_REG_A2, MIPS_REG_A3, MIPS_REG_T1 };
+	for (MIPSGPReg r : resident) {
+		if (!hints.IsResident(r, false)) {
+			printf("RegAllocHints FAILED: expected %d to be resident\n", r);
+			return false;
+		}
+	}
+	for (MIPSGPReg r : spilled) {
+		if (hints.IsResident(r, false)) {
+			printf("RegAllocHints FAILED: expected %d to be spilled\n", r);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool VerifyRegAllocHintsFPR() {
+	// FPRs use the IR's own numbering, with the VFPU regs from 32.  Make sure they don't mix
+	// with the GPRs, or with the FPR 32 regs over.
+	const IRInst insts[] = {
+		{ IROp::FMovFromGPR, { 40 }, MIPS_REG_A0 },
+		{ IROp::FAdd, { 41 }, 40, 40 },
+		{ IROp::FAdd, { 8 }, 41, 41 },
+	};
+
+	IRRegAllocHints hints;
+	hints.Compute(insts, 3, 1, 1);
+
+	struct NextReadCheck {
+		IRReg reg;
+		bool fpr;
+		int index;
+		int expected;
+	};
+	static const NextReadCheck nextReads[] = {
+		{ 40, true, 0, 1 },
+		{ 40, true, 2, IRRegAllocHints::NO_READ },
+		{ 41, true, 0, 2 },
+		{ 8, true, 0, IRRegAllocHints::NO_READ },
+		{ 9, true, 0, IRRegAllocHints::NO_READ },
+		{ MIPS_REG_A0, false, 0, 0 },
+		{ MIPS_REG_A0, true, 0, IRRegAllocHints::NO_READ },
+		{ 8, false, 0, IRRegAllocHints::NO_READ },
+	};
+	for (const auto &check : nextReads) {
+		int next = hints.NextRead(check.reg, check.fpr, check.index);
+		if (next != check.expected) {
+			printf("RegAllocHints FAILED: next read of %s%d from %d was %d, expected %d\n", check.fpr ? "f" : "r", check.reg, check.index, next, check.expected);
+			return false;
+		}
+	}
+
+	// F41 can't take F40's reg (same density), and F8 gets it after F40 is done.
+	struct ResidentCheck {
+		IRReg reg;
+		bool resident;
+	};
+	static const ResidentCheck residents[] = {
+		{ 40, true },
+		{ 41, false },
+		{ 8, true },
+		{ 9, false },
+	};
+	for (const auto &check : residents) {
+		if (hints.IsResident(check.reg, true) != check.resident) {
+			printf("RegAllocHints FAILED: expected f%d to be %s\n", check.reg, check.resident ? "resident" : "spilled");
+			return false;
+		}
+	}
+
+	// A vector op reads and writes all four lanes.
+	const IRInst vecInsts[] = {
+		{ IROp::Vec4Add, { 32 }, 44, 48 },
+	};
+	hints.Compute(vecInsts, 1, 1, 32);
+	for (IRReg r = 44; r < 52; ++r) {
+		if (hints.NextRead(r, true, 0) != 0) {
+			printf("RegAllocHints FAILED: expected a read of v%d\n", r);
+			return false;
+		}
+	}
+	for (IRReg r = 32; r < 52; ++r) {
+		bool used = r < 36 || r >= 44;
+		if (hints.IsResident(r, true) != used || hints.IsResident(r - 32, true)) {
+			printf("RegAllocHints FAILED: wrong residency around v%d\n", r);
+			return false;
+		}
+		if (r < 36 && hints.NextRead(r, true, 0) != IRRegAllocHints::NO_READ) {
+			printf("RegAllocHints FAILED: unexpected read of v%d\n", r);
+			return false;
+		}
+	}
+
+	return true;
+}
+
 bool TestIRPassSimplify() {
 	InitIR();
 
@@ -176,5 +308,5 @@ bool TestIRPassSimplify() {
 			return false;
 	}
 
-	return true;
+	return VerifyRegAllocHints() && VerifyRegAllocHintsFPR();
 }
@@ -0,0 +1,187 @@
+#include <cstring>
+#include <cstdio>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Swap.h"
+#include "GPU/Common/IndexGenerator.h"
+#include "GPU/ge_constants.h"
+#include "UnitTest.h"
+
+// Plain scalar versions of the generators, to check the vectorized ones against and to time them.
+static int RefAddPrim(u16 *out, int prim, int n, int base, bool cw) {
+	u16 *o = out;
+	const int v1 = cw ? 1 : 2;
+	const int v2 = cw ? 2 : 1;
+	switch (prim) {
+	case GE_PRIM_POINTS:
+		for (int i = 0; i < n; i++)
+			*o++ = base + i;
+		break;
+	case GE_PRIM_LINES:
+	case GE_PRIM_RECTANGLES:
+		for (int i = 0; i < (n & ~1); i += 2) {
+			*o++ = base + i;
+			*o++ = base + i + 1;
+		}
+		break;
+	case GE_PRIM_TRIANGLE_STRIP:
+	{
+		int wind = v1;
+		for (int i = 0; i < n - 2; i++) {
+			*o++ = base + i;
+			*o++ = base + i + wind;
+			wind ^= 3;
+			*o++ = base + i + wind;
+		}
+		break;
+	}
+	case GE_PRIM_TRIANGLE_FAN:
+		for (int i = 0; i < n - 2; i++) {
+			*o++ = base;
+			*o++ = base + i + v1;
+			*o++ = base + i + v2;
+		}
+		break;
+	}
+	return (int)(o - out);
+}
+
+template <class ITypeLE>
+static int RefTranslateStrip(u16 *out, const ITypeLE *inds, int n, int base, bool cw) {
+	u16 *o = out;
+	int wind = cw ? 1 : 2;
+	for (int i = 0; i < n - 2; i++) {
+		*o++ = base + inds[i];
+		*o++ = base + inds[i + wind];
+		wind ^= 3;
+		*o++ = base + inds[i + wind];
+	}
+	return (int)(o - out);
+}
+
+// The vectorized strip may start a triangle at a different corner, which keeps the winding.
+static bool SameTriangles(const u16 *a, const u16 *b, int count) {
+	for (int i = 0; i < count; i += 3) {
+		bool same = false;
+		for (int r = 0; r < 3; r++)
+			same = same || (a[i] == b[i + r] && a[i + 1] == b[i + (r + 1) % 3] && a[i + 2] == b[i + (r + 2) % 3]);
+		if (!same)
+			return false;
+	}
+	return true;
+}
+
+static const char *PrimName(int prim) {
+	switch (prim) {
+	case GE_PRIM_POINTS: return "points";
+	case GE_PRIM_LINES: return "lines";
+	case GE_PRIM_TRIANGLE_STRIP: return "strip";
+	case GE_PRIM_TRIANGLE_FAN: return "fan";
+	case GE_PRIM_RECTANGLES: return "rects";
+	default: return "?";
+	}
+}
+
+static const int MAX_VERTS = 300;
+// Strips may write a little past the end, that's expected.
+static const int MAX_INDICES = MAX_VERTS * 3 + 64;
+
+static bool TestIndexGeneratorAddPrim() {
+	static const int prims[] = { GE_PRIM_POINTS, GE_PRIM_LINES, GE_PRIM_TRIANGLE_STRIP, GE_PRIM_TRIANGLE_FAN, GE_PRIM_RECTANGLES };
+	std::vector<u16> actual(MAX_INDICES);
+	std::vector<u16> expected(MAX_INDICES);
+	IndexGenerator gen;
+	for (int prim : prims) {
+		for (int cw = 0; cw < 2; cw++) {
+			for (int n = 0; n < MAX_VERTS; n++) {
+				const int base = n * 7;
+				gen.Setup(actual.data());
+				gen.AddPrim(prim, n, base, cw != 0);
+				int count = RefAddPrim(expected.data(), prim, n, base, cw != 0);
+				bool same;
+				if (prim == GE_PRIM_TRIANGLE_STRIP)
+					same = SameTriangles(actual.data(), expected.data(), count);
+				else
+					same = memcmp(actual.data(), expected.data(), count * sizeof(u16)) == 0;
+				if (gen.VertexCount() != count || !same) {
+					printf("AddPrim mismatch: %s, %d verts, cw=%d\n", PrimName(prim), n, cw);
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+template <class ITypeLE>
+static bool TestIndexGeneratorTranslateStrip() {
+	std::vector<ITypeLE> inds(MAX_VERTS);
+	for (int i = 0; i < MAX_VERTS; i++)
+		inds[i] = (i * 37 + 11) & 0xFF;
+	std::vector<u16> actual(MAX_INDICES);
+	std::vector<u16> expected(MAX_INDICES);
+	IndexGenerator gen;
+	for (int cw = 0; cw < 2; cw++) {
+		for (int n = 0; n < MAX_VERTS; n++) {
+			gen.Setup(actual.data());
+			gen.TranslatePrim(GE_PRIM_TRIANGLE_STRIP, n, inds.data(), n * 3, cw != 0);
+			int count = RefTranslateStrip(expected.data(), inds.data(), n, n * 3, cw != 0);
+			if (gen.VertexCount() != count || memcmp(actual.data(), expected.data(), count * sizeof(u16)) != 0) {
+				printf("TranslateStrip mismatch: %d-byte indices, %d verts, cw=%d\n", (int)sizeof(ITypeLE), n, cw);
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// Runs each for a short while on typical sizes, and prints the time per call.
+static void BenchmarkIndexGenerator() {
+	static const int prims[] = { GE_PRIM_TRIANGLE_STRIP, GE_PRIM_TRIANGLE_FAN, GE_PRIM_RECTANGLES };
+	static const int sizes[] = { 4, 16, 64, 256 };
+	std::vector<u16> buf(MAX_INDICES);
+	std::vector<u16_le> inds(MAX_VERTS);
+	for (int i = 0; i < MAX_VERTS; i++)
+		inds[i] = i;
+	IndexGenerator gen;
+	gen.Setup(buf.data());
+
+	for (int prim : prims) {
+		for (int n : sizes) {
+			double simd = timeIt([&] {
+				gen.Reset();
+				gen.AddPrim(prim, n, 0, true);
+			}, 1000, 0.05) * 1e9;
+			double scalar = timeIt([&] {
+				RefAddPrim(buf.data(), prim, n, 0, true);
+			}, 1000, 0.05) * 1e9;
+			printf("Add %s, %d verts: %0.1f ns (scalar %0.1f ns)\n", PrimName(prim), n, simd, scalar);
+		}
+	}
+	for (int n : sizes) {
+		double unrolled = timeIt([&] {
+			gen.Reset();
+			gen.TranslatePrim(GE_PRIM_TRIANGLE_STRIP, n, inds.data(), 0, true);
+		}, 1000, 0.05) * 1e9;
+		double scalar = timeIt([&] {
+			RefTranslateStrip(buf.data(), inds.data(), n, 0, true);
+		}, 1000, 0.05) * 1e9;
+		printf("Translate strip, %d verts: %0.1f ns (scalar %0.1f ns)\n", n, unrolled, scalar);
+	}
+}
+
+bool TestIndexGenerator() {
+	if (!TestIndexGeneratorAddPrim())
+		return false;
+	if (!TestIndexGeneratorTranslateStrip<u8>())
+		return false;
+	if (!TestIndexGeneratorTranslateStrip<u16_le>())
+		return false;
+	if (!TestIndexGeneratorTranslateStrip<u32_le>())
+		return false;
+
+	if (g_testBenchmarks)
+		BenchmarkIndexGenerator();
+	return true;
+}
@@ -0,0 +1,457 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Common/CPUDetect.h"
+#include "Common/CommonTypes.h"
+#include "Common/Thread/ThreadManager.h"
+#include "Core/Config.h"
+#include "Core/HW/SasAudio.h"
+#include "Core/HW/SasReverb.h"
+#include "Core/MemMap.h"
+#include "Core/Util/AudioFormat.h"
+#include "UnitTest.h"
+
+// Fixed seed, so the data (and the benchmark) is the same on every run and platform.
+static u32 g_sasSeed;
+static u32 SasRand() {
+	g_sasSeed = g_sasSeed * 1664525 + 1013904223;
+	return g_sasSeed >> 8;
+}
+
+static const u32 VAG_ADDR = 0x08800000;
+static const u32 MIX_OUT_ADDR = 0x08C00000;
+static const u32 MIX_OUT_ADDR2 = 0x08C10000;
+static const int VAG_LOOP_BLOCKS = 400;
+
+// Random blocks using all the filters and shifts. With loop set, the first and last blocks loop.
+static std::vector<u8> GenerateVag(int numBlocks, bool loop) {
+	std::vector<u8> data(numBlocks * 16);
+	for (int b = 0; b < numBlocks; b++) {
+		u8 *block = &data[b * 16];
+		block[0] = (u8)SasRand();
+		block[1] = 0;
+		if (loop && b == 0)
+			block[1] = 6;
+		else if (loop && b == numBlocks - 1)
+			block[1] = 3;
+		for (int i = 2; i < 16; i++)
+			block[i] = (u8)SasRand();
+	}
+	return data;
+}
+
+// The plain decoder, as it was before the unpacking was split out.
+static void RefDecodeVag(const u8 *data, int numBlocks, std::vector<s16> &out) {
+	static const int f[16][2] = {
+		{ 0, 0 }, { 60, 0 }, { 115, 52 }, { 98, 55 }, { 122, 60 }, { 0, 0 }, { 0, 0 }, { 52, 0 },
+		{ 55, 2 }, { 60, 125 }, { 0, 0 }, { 0, 91 }, { 0, 0 }, { 2, 216 }, { 125, 6 }, { 0, 151 },
+	};
+	int s1 = 0, s2 = 0;
+	for (int b = 0; b < numBlocks; b++) {
+		const u8 *readp = data + b * 16;
+		int predict_nr = *readp++;
+		int shift_factor = predict_nr & 0xf;
+		predict_nr >>= 4;
+		readp++;
+		int coef1 = f[predict_nr][0];
+		int coef2 = -f[predict_nr][1];
+		for (int i = 0; i < 28; i += 2) {
+			u8 d = *readp++;
+			int sample1 = (short)((d & 0xf) << 12) >> shift_factor;
+			int sample2 = (short)((d & 0xf0) << 8) >> shift_factor;
+			s2 = clamp_s16(sample1 + ((s1 * coef1 + s2 * coef2) >> 6));
+			s1 = clamp_s16(sample2 + ((s2 * coef1 + s1 * coef2) >> 6));
+			out.push_back(s2);
+			out.push_back(s1);
+		}
+	}
+}
+
+static bool TestSasVagDecoder() {
+	const int numBlocks = 300;
+	g_sasSeed = 1;
+	std::vector<u8> data = GenerateVag(numBlocks, false);
+	memcpy(Memory::GetPointerWriteUnchecked(VAG_ADDR), data.data(), data.size());
+
+	std::vector<s16> expected;
+	RefDecodeVag(data.data(), numBlocks, expected);
+	// After the end, it's silence.
+	expected.resize(expected.size() + 100);
+
+	VagDecoder dec;
+	dec.Start(VAG_ADDR, (u32)data.size(), false);
+	std::vector<s16> actual(expected.size());
+	size_t pos = 0;
+	while (pos < actual.size()) {
+		int chunk = std::min(1 + (int)(SasRand() % 100), (int)(actual.size() - pos));
+		dec.GetSamples(&actual[pos], chunk);
+		pos += chunk;
+	}
+	EXPECT_TRUE(dec.End());
+
+	for (size_t i = 0; i < expected.size(); i++) {
+		if (actual[i] != expected[i]) {
+			printf("VAG mismatch at sample %d: %d, expected %d\n", (int)i, actual[i], expected[i]);
+			return false;
+		}
+	}
+	return true;
+}
+
+static void RefResampleVoice(int *out, const s16 *in, u32 frac, int pitch, int count) {
+	const bool needsInterp = pitch != PSP_SAS_PITCH_BASE || (frac & PSP_SAS_PITCH_MASK) != 0;
+	for (int i = 0; i < count; i++) {
+		const s16 *s = in + (frac >> PSP_SAS_PITCH_BASE_SHIFT);
+		int sample = s[0];
+		if (needsInterp) {
+			int f = frac & PSP_SAS_PITCH_MASK;
+			sample = (s[0] * (PSP_SAS_PITCH_MASK - f) + s[1] * f) >> PSP_SAS_PITCH_BASE_SHIFT;
+		}
+		out[i] = sample;
+		frac += pitch;
+	}
+}
+
+static void RefMixVoiceSamples(int *mix, int *send, const int *samples, const int *envelope, int count, int volLeft, int volRight, int effectLeft, int effectRight) {
+	for (int i = 0; i < count; i++) {
+		int sample = ((samples[i] * envelope[i]) + (1 << 14)) >> 15;
+		mix[i * 2] += (sample * volLeft) >> 12;
+		mix[i * 2 + 1] += (sample * volRight) >> 12;
+		send[i * 2] += sample * effectLeft >> 12;
+		send[i * 2 + 1] += sample * effectRight >> 12;
+	}
+}
+
+static bool TestSasResample() {
+	static const int pitches[] = { 0x1000, 0x0001, 0x0800, 0x0FFF, 0x1001, 0x1800, 0x2345, 0x4000 };
+	static const u32 fracs[] = { 0, 0x123, 0xFFF, 0x1000, 0x2ABC };
+	static const int counts[] = { 0, 1, 3, 4, 64, 255, 256, 1024 };
+	std::vector<s16> in(PSP_SAS_MAX_GRAIN * 4 + 16);
+	for (s16 &s : in)
+		s = (s16)SasRand();
+	in[5] = 32767;
+	in[6] = -32768;
+
+	std::vector<int> actual(PSP_SAS_MAX_GRAIN);
+	std::vector<int> expected(PSP_SAS_MAX_GRAIN);
+	for (int pitch : pitches) {
+		for (u32 frac : fracs) {
+			for (int count : counts) {
+				SasResampleVoice(actual.data(), in.data(), frac, pitch, count);
+				RefResampleVoice(expected.data(), in.data(), frac, pitch, count);
+				if (memcmp(actual.data(), expected.data(), count * sizeof(int)) != 0) {
+					printf("Resample mismatch: pitch %04x, frac %04x, %d samples\n", pitch, frac, count);
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+static bool TestSasMixVoiceSamples() {
+	static const int counts[] = { 0, 1, 3, 4, 7, 64, 255, 256 };
+	static const int volumes[][4] = {
+		{ 0x1000, 0x1000, 0x1000, 0x1000 },
+		{ -0x1000, 0x1000, 0, -0x1000 },
+		{ 0x0123, -0x0FED, 0x0800, 0x0001 },
+	};
+	std::vector<int> samples(PSP_SAS_MAX_GRAIN);
+	std::vector<int> envelope(PSP_SAS_MAX_GRAIN);
+	for (int i = 0; i < PSP_SAS_MAX_GRAIN; i++) {
+		samples[i] = (s16)SasRand();
+		envelope[i] = SasRand() % 0x8001;
+	}
+	// The extremes.
+	samples[0] = -32768;
+	envelope[0] = 0x8000;
+	samples[1] = 32767;
+	envelope[1] = 0x8000;
+
+	std::vector<int> mix(PSP_SAS_MAX_GRAIN * 2), send(PSP_SAS_MAX_GRAIN * 2);
+	std::vector<int> refMix(PSP_SAS_MAX_GRAIN * 2), refSend(PSP_SAS_MAX_GRAIN * 2);
+	for (const auto &vol : volumes) {
+		for (int count : counts) {
+			for (int offset = 0; offset < 3; offset++) {
+				for (int i = 0; i < PSP_SAS_MAX_GRAIN * 2; i++) {
+					mix[i] = refMix[i] = (s16)SasRand();
+					send[i] = refSend[i] = (s16)SasRand();
+				}
+				// The offset is the keyon delay, so the buffers are not always aligned.
+				SasMixVoiceSamples(&mix[offset * 2], &send[offset * 2], samples.data(), envelope.data(), count, vol[0], vol[1], vol[2], vol[3]);
+				RefMixVoiceSamples(&refMix[offset * 2], &refSend[offset * 2], samples.data(), envelope.data(), count, vol[0], vol[1], vol[2], vol[3]);
+				if (mix != refMix || send != refSend) {
+					printf("Mix mismatch: volumes %d %d %d %d, %d samples, offset %d\n", vol[0], vol[1], vol[2], vol[3], count, offset);
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+// All 32 voices playing looping VAG, at various pitches and volumes.
+static SasInstance *CreateTestSas(int grainSize) {
+	static const int pitches[] = { 0x1000, 0x0800, 0x1000, 0x0C00, 0x1000, 0x1555, 0x2000, 0x0FFF };
+	SasInstance *sas = new SasInstance();
+	sas->SetGrainSize(grainSize);
+	for (int v = 0; v < PSP_SAS_VOICES_MAX; v++) {
+		SasVoice &voice = sas->voices[v];
+		voice.type = VOICETYPE_VAG;
+		voice.vagAddr = VAG_ADDR + (v % 8) * 16 * 16;
+		voice.vagSize = VAG_LOOP_BLOCKS * 16 - (v % 8) * 16 * 16;
+		voice.loop = true;
+		voice.pitch = pitches[v % ARRAY_SIZE(pitches)];
+		voice.volumeLeft = 0x1000 - v * 64;
+		voice.volumeRight = 0x400 + v * 64;
+		voice.effectLeft = v * 32;
+		voice.effectRight = -v * 32;
+		voice.envelope.SetSimpleEnvelope(0x000F, 0x1FC6);
+		voice.KeyOn();
+	}
+	return sas;
+}
+
+static bool TestSasParallelMix() {
+	const int grainSize = 256;
+	SasInstance *serial = CreateTestSas(grainSize);
+	SasInstance *parallel = CreateTestSas(grainSize);
+
+	bool success = true;
+	for (int grain = 0; grain < 100 && success; grain++) {
+		// Some voices stop and start along the way, so the groups change.
+		if (grain == 40 || grain == 70) {
+			for (int v = grain / 10; v < PSP_SAS_VOICES_MAX; v += 3) {
+				serial->voices[v].KeyOff();
+				parallel->voices[v].KeyOff();
+			}
+		}
+		if (grain == 60) {
+			serial->voices[5].KeyOn();
+			parallel->voices[5].KeyOn();
+		}
+
+		g_Config.bSasParallelMix = false;
+		serial->Mix(MIX_OUT_ADDR, 0, PSP_SAS_VOL_MAX, PSP_SAS_VOL_MAX, false);
+		g_Config.bSasParallelMix = true;
+		parallel->Mix(MIX_OUT_ADDR2, 0, PSP_SAS_VOL_MAX, PSP_SAS_VOL_MAX, false);
+		if (memcmp(Memory::GetPointerUnchecked(MIX_OUT_ADDR), Memory::GetPointerUnchecked(MIX_OUT_ADDR2), grainSize * 4) != 0) {
+			printf("Parallel mix differs at grain %d\n", grain);
+			success = false;
+		}
+	}
+
+	delete serial;
+	delete parallel;
+	return success;
+}
+
+// Mixes all 32 voices for a short while, and prints the time per grain.
+static void BenchmarkSasMix(int grainSize, bool parallelMix) {
+	SasInstance *sas = CreateTestSas(grainSize);
+	g_Config.bSasParallelMix = parallelMix;
+
+	double us = timeIt([&] {
+		sas->Mix(MIX_OUT_ADDR, 0, PSP_SAS_VOL_MAX, PSP_SAS_VOL_MAX, false);
+	}, 10) * 1e6;
+	printf("SAS mix, 32 voices, grain %d%s: %0.1f us\n", grainSize, parallelMix ? ", parallel" : "", us);
+
+	delete sas;
+}
+
+// The reverb as it was before it got split up per preset, with its own copy of the presets.
+struct RefReverbData {
+	int32_t size;
+
+	int16_t dAPF1, dAPF2, vIIR, vCOMB1, vCOMB2, vCOMB3, vCOMB4, vWALL;
+	int16_t vAPF1, vAPF2, mLSAME, mRSAME, mLCOMB1, mRCOMB1, mLCOMB2, mRCOMB2;
+	int16_t dLSAME, dRSAME, mLDIFF, mRDIFF, mLCOMB3, mRCOMB3, mLCOMB4, mRCOMB4;
+	int16_t dLDIFF, dRDIFF, mLAPF1, mRAPF1, mLAPF2, mRAPF2;
+};
+
+static const RefReverbData refReverbPresets[] = {
+	{ 0x26C0,
+		0x007D,0x005B,0x6D80,0x54B8,(int16_t)0xBED0,0x0000,0x0000,(int16_t)0xBA80,
+		0x5800,0x5300,0x04D6,0x0333,0x03F0,0x0227,0x0374,0x01EF,
+		0x0334,0x01B5,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,
+		0x0000,0x0000,0x01B4,0x0136,0x00B8,0x005C },
+	{ 0x1F40,
+		0x0033,0x0025,0x70F0,0x4FA8,(int16_t)0xBCE0,0x4410,(int16_t)0xC0F0,(int16_t)0x9C00,
+		0x5280,0x4EC0,0x03E4,0x031B,0x03A4,0x02AF,0x0372,0x0266,
+		0x031C,0x025D,0x025C,0x018E,0x022F,0x0135,0x01D2,0x00B7,
+		0x018F,0x00B5,0x00B4,0x0080,0x004C,0x0026 },
+	{ 0x4840,
+		0x00B1,0x007F,0x70F0,0x4FA8,(int16_t)0xBCE0,0x4510,(int16_t)0xBEF0,(int16_t)0xB4C0,
+		0x5280,0x4EC0,0x0904,0x076B,0x0824,0x065F,0x07A2,0x0616,
+		0x076C,0x05ED,0x05EC,0x042E,0x050F,0x0305,0x0462,0x02B7,
+		0x042F,0x0265,0x0264,0x01B2,0x0100,0x0080 },
+	{ 0x6FE0,
+		0x00E3,0x00A9,0x6F60,0x4FA8,(int16_t)0xBCE0,0x4510,(int16_t)0xBEF0,(int16_t)0xA680,
+		0x5680,0x52C0,0x0DFB,0x0B58,0x0D09,0x0A3C,0x0BD9,0x0973,
+		0x0B59,0x08DA,0x08D9,0x05E9,0x07EC,0x04B0,0x06EF,0x03D2,
+		0x05EA,0x031D,0x031C,0x0238,0x0154,0x00AA },
+	{ 0xADE0,
+		0x01A5,0x0139,0x6000,0x5000,0x4C00,(int16_t)0xB800,(int16_t)0xBC00,(int16_t)0xC000,
+		0x6000,0x5C00,0x15BA,0x11BB,0x14C2,0x10BD,0x11BC,0x0DC1,
+		0x11C0,0x0DC3,0x0DC0,0x09C1,0x0BC4,0x07C1,0x0A00,0x06CD,
+		0x09C2,0x05C1,0x05C0,0x041A,0x0274,0x013A },
+	{ 0xF6C0,
+		0x033D,0x0231,0x7E00,0x5000,(int16_t)0xB400,(int16_t)0xB000,0x4C00,(int16_t)0xB000,
+		0x6000,0x5400,0x1ED6,0x1A31,0x1D14,0x183B,0x1BC2,0x16B2,
+		0x1A32,0x15EF,0x15EE,0x1055,0x1334,0x0F2D,0x11F6,0x0C5D,
+		0x1056,0x0AE1,0x0AE0,0x07A2,0x0464,0x0232 },
+	{ 0x18040,
+		0x0001,0x0001,0x7FFF,0x7FFF,0x0000,0x0000,0x0000,(int16_t)0xC080,
+		0x0000,0x0000,0x1FFF,0x0FFF,0x1005,0x0005,0x0000,0x0000,
+		0x1005,0x0005,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,
+		0x0000,0x0000,0x1004,0x1002,0x0004,0x0002 },
+	{ 0x18040,
+		0x0001,0x0001,0x7FFF,0x7FFF,0x0000,0x0000,0x0000,0x0000,
+		0x0000,0x0000,0x1FFF,0x0FFF,0x1005,0x0005,0x0000,0x0000,
+		0x1005,0x0005,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,
+		0x0000,0x0000,0x1004,0x1002,0x0004,0x0002 },
+	{ 0x3C00,
+		0x0017,0x0013,0x70F0,0x4FA8,(int16_t)0xBCE0,0x4510,(int16_t)0xBEF0,(int16_t)0x8500,
+		0x5F80,0x54C0,0x0371,0x02AF,0x02E5,0x01DF,0x02B0,0x01D7,
+		0x0358,0x026A,0x01D6,0x011E,0x012D,0x00B1,0x011F,0x0059,
+		0x01A0,0x00E3,0x0058,0x0040,0x0028,0x0014 },
+};
+
+static const int REF_REVERB_BUFSIZE = 0x20000;
+
+// Volumes already multiplied by the reverb volume setting.
+static void RefProcessReverb(std::vector<int16_t> &workspace, int &pos, const RefReverbData &d, int16_t *output, const int16_t *input, size_t inputSize, int volLeft, int volRight) {
+	const int base = REF_REVERB_BUFSIZE - d.size;
+	auto b = [&](int index) -> int16_t & {
+		int addr = pos + index;
+		if (addr >= REF_REVERB_BUFSIZE) { addr -= d.size; }
+		if (addr < base) { addr += d.size; }
+		return workspace[addr];
+	};
+
+	for (size_t i = 0; i < inputSize; i++) {
+		int16_t Lin = input[i * 2] >> 1;
+		int16_t Rin = input[i * 2 + 1] >> 1;
+
+		b(d.mLSAME) = clamp_s16(Lin + (b(d.dLSAME) * d.vWALL >> 15) - (b(d.mLSAME - 1)*d.vIIR >> 15) + b(d.mLSAME - 1));
+		b(d.mRSAME) = clamp_s16(Rin + (b(d.dRSAME) * d.vWALL >> 15) - (b(d.mRSAME - 1)*d.vIIR >> 15) + b(d.mRSAME - 1));
+		b(d.mLDIFF) = clamp_s16(Lin + (b(d.dRDIFF) * d.vWALL >> 15) - (b(d.mLDIFF - 1)*d.vIIR >> 15) + b(d.mLDIFF - 1));
+		b(d.mRDIFF) = clamp_s16(Rin + (b(d.dLDIFF) * d.vWALL >> 15) - (b(d.mRDIFF - 1)*d.vIIR >> 15) + b(d.mRDIFF - 1));
+		int32_t Lout = ((d.vCOMB1*b(d.mLCOMB1) + d.vCOMB2*b(d.mLCOMB2) + d.vCOMB3*b(d.mLCOMB3) + d.vCOMB4*b(d.mLCOMB4)) >> 15);
+		int32_t Rout = ((d.vCOMB1*b(d.mRCOMB1) + d.vCOMB2*b(d.mRCOMB2) + d.vCOMB3*b(d.mRCOMB3) + d.vCOMB4*b(d.mRCOMB4)) >> 15);
+		b(d.mLAPF1) = clamp_s16(Lout - (d.vAPF1*b((d.mLAPF1 - d.dAPF1)) >> 15));
+		Lout = b((d.mLAPF1 - d.dAPF1)) + (b(d.mLAPF1) * d.vAPF1 >> 15);
+		b(d.mRAPF1) = clamp_s16(Rout - (d.vAPF1*b((d.mRAPF1 - d.dAPF1)) >> 15));
+		Rout = b((d.mRAPF1 - d.dAPF1)) + (b(d.mRAPF1) * d.vAPF1 >> 15);
+		b(d.mLAPF2) = clamp_s16(Lout - (d.vAPF2*b((d.mLAPF2 - d.dAPF2)) >> 15));
+		Lout = b((d.mLAPF2 - d.dAPF2)) + (b(d.mLAPF2) * d.vAPF2 >> 15);
+		b(d.mRAPF2) = clamp_s16(Rout - (d.vAPF2*b((d.mRAPF2 - d.dAPF2)) >> 15));
+		Rout = b((d.mRAPF2 - d.dAPF2)) + (b(d.mRAPF2) * d.vAPF2 >> 15);
+		output[i * 4 + 0] = clamp_s16((Lout * volLeft) >> 15);
+		output[i * 4 + 1] = clamp_s16((Rout * volRight) >> 15);
+		output[i * 4 + 2] = 0;
+		output[i * 4 + 3] = 0;
+
+		pos++;
+		if (pos >= REF_REVERB_BUFSIZE)
+			pos -= d.size;
+	}
+}
+
+// Random lengths, so the buffer wraps around at all kinds of places within a call.
+static bool TestSasReverb() {
+	const size_t maxSamples = 1500;
+	std::vector<int16_t> input(maxSamples * 2);
+	std::vector<int16_t> actual(maxSamples * 4);
+	std::vector<int16_t> expected(maxSamples * 4);
+	SasReverb reverb;
+
+	for (int preset = 0; preset < (int)ARRAY_SIZE(refReverbPresets); preset++) {
+		const RefReverbData &d = refReverbPresets[preset];
+		reverb.SetPreset(preset);
+		std::vector<int16_t> workspace(REF_REVERB_BUFSIZE);
+		int pos = REF_REVERB_BUFSIZE - d.size;
+
+		// Goes round the whole buffer at least once.
+		for (int total = 0; total < d.size + 4096; ) {
+			const size_t count = 1 + SasRand() % maxSamples;
+			// Every so often, a quiet stretch that doesn't hit the clamping all the time.
+			const int inputShift = SasRand() % 4 == 0 ? 6 : 0;
+			for (size_t i = 0; i < count * 2; i++)
+				input[i] = (int16_t)SasRand() >> inputShift;
+			const int volLeft = SasRand() & 0x7FFF;
+			const int volRight = SasRand() & 0x7FFF;
+
+			reverb.ProcessReverb(actual.data(), input.data(), count, volLeft, volRight);
+			RefProcessReverb(workspace, pos, d, expected.data(), input.data(), count, volLeft, volRight);
+			if (memcmp(actual.data(), expected.data(), count * 4 * sizeof(int16_t)) != 0) {
+				printf("Reverb mismatch: %s, %d samples in\n", SasReverb::GetPresetName(preset), total);
+				return false;
+			}
+			total += (int)count;
+		}
+	}
+	return true;
+}
+
+// Each preset for a short while, on a typical grain, and prints the time per call.
+static void BenchmarkSasReverb() {
+	const size_t count = 128;
+	std::vector<int16_t> input(count * 2);
+	std::vector<int16_t> output(count * 4);
+	for (auto &sample : input)
+		sample = (int16_t)SasRand() >> 2;
+
+	SasReverb reverb;
+	for (int preset = 0; preset < (int)ARRAY_SIZE(refReverbPresets); preset++) {
+		const RefReverbData &d = refReverbPresets[preset];
+		reverb.SetPreset(preset);
+		std::vector<int16_t> workspace(REF_REVERB_BUFSIZE);
+		int pos = REF_REVERB_BUFSIZE - d.size;
+
+		double ns = timeIt([&] {
+			reverb.ProcessReverb(output.data(), input.data(), count, 0x4000, 0x4000);
+		}, 100, 0.05) * 1e9;
+		double ref = timeIt([&] {
+			RefProcessReverb(workspace, pos, d, output.data(), input.data(), count, 0x4000, 0x4000);
+		}, 100, 0.05) * 1e9;
+		printf("Reverb %s, %d samples: %0.1f ns (old %0.1f ns)\n", SasReverb::GetPresetName(preset), (int)count, ns, ref);
+	}
+}
+
+bool TestSasAudio() {
+	Memory::g_MemorySize = Memory::RAM_NORMAL_SIZE;
+	if (!Memory::Init(Memory::MemMapSetupFlags::Default)) {
+		printf("Failed to init memory\n");
+		return false;
+	}
+	g_threadManager.Init(cpu_info.num_cores, cpu_info.logical_cpu_count);
+	const bool oldParallelMix = g_Config.bSasParallelMix;
+	const int oldReverbVolume = g_Config.iReverbVolume;
+	g_Config.iReverbVolume = VOLUME_FULL;
+
+	g_sasSeed = 1;
+	bool success = TestSasVagDecoder() && TestSasResample() && TestSasMixVoiceSamples() && TestSasReverb();
+	if (success) {
+		g_sasSeed = 1234;
+		std::vector<u8> data = GenerateVag(VAG_LOOP_BLOCKS, true);
+		memcpy(Memory::GetPointerWriteUnchecked(VAG_ADDR), data.data(), data.size());
+
+		success = TestSasParallelMix();
+	}
+	if (success && g_testBenchmarks) {
+		BenchmarkSasMix(256, false);
+		BenchmarkSasMix(256, true);
+		BenchmarkSasMix(1024, false);
+		BenchmarkSasMix(1024, true);
+		BenchmarkSasReverb();
+	}
+
+	g_Config.bSasParallelMix = oldParallelMix;
+	g_Config.iReverbVolume = oldReverbVolume;
+	g_threadManager.Teardown();
+	Memory::Shutdown();
+	return success;
+}
@@ -15,13 +15,18 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <atomic>
+
 #include "Common/Data/Random/Rng.h"
+#include "Common/File/FileUtil.h"
 #include "Common/StringUtils.h"
 #include "Core/Config.h"
 #include "GPU/Software/BinManager.h"
 #include "GPU/Software/DrawPixel.h"
+#include "GPU/Software/JitDiskCache.h"
 #include "GPU/Software/Sampler.h"
 #include "GPU/Software/SoftGpu.h"
+#include "UnitTest.h"
 
 static bool TestSamplerJit() {
 #if PPSSPP_ARCH(AMD64)
@@ -171,6 +176,110 @@ static bool TestPixelJit() {
 #endif
 }
 
+static bool TestPixelJitPrecompile() {
+#if PPSSPP_ARCH(AMD64)
+	using namespace Rasterizer;
+	PixelJitCache *cache = new PixelJitCache();
+
+	// More than one batch, to cover taking the lock again in between.
+	GMRng rng;
+	std::vector<PixelFuncID> ids;
+	while (ids.size() < 50) {
+		PixelFuncID id;
+		memset(&id, 0, sizeof(id));
+		id.fullKey = (uint64_t)rng.R32() | ((uint64_t)rng.R32() << 32);
+		if (!startsWith(DescribePixelFuncID(id), "INVALID"))
+			ids.push_back(id);
+	}
+
+	std::atomic<bool> cancel{};
+	cache->Precompile(ids, cancel);
+
+	// Without a binner, GetSingle() can't compile, so these have to come from the precompile.
+	int missing = 0;
+	for (const PixelFuncID &id : ids) {
+		SingleFunc func = cache->GetSingle(id, nullptr);
+		if (!func || func == cache->GenericSingle(id)) {
+			printf("Not precompiled: %s\n", DescribePixelFuncID(id).c_str());
+			missing++;
+		}
+	}
+
+	delete cache;
+	return missing == 0 && !HitAnyAsserts();
+#else
+	return true;
+#endif
+}
+
+static bool TestJitDiskCache() {
+	using namespace Rasterizer;
+	const Path filename("unittest_jitcache.softjitcache");
+	File::Delete(filename);
+
+	PixelFuncID pixelA, pixelB;
+	memset(&pixelA, 0, sizeof(pixelA));
+	memset(&pixelB, 0, sizeof(pixelB));
+	pixelA.fullKey = 0x1111;
+	pixelB.fullKey = 0x2222;
+	SamplerID sampler;
+	memset(&sampler, 0, sizeof(sampler));
+	sampler.fullKey = 0x3333;
+
+	// Two sessions, the second only using B. That should move it to the front.
+	{
+		JitDiskCache cache;
+		EXPECT_FALSE(cache.Load(filename));
+		EXPECT_TRUE(cache.Save(filename, { pixelA, pixelB }, { sampler }));
+	}
+	{
+		JitDiskCache cache;
+		EXPECT_TRUE(cache.Load(filename));
+		EXPECT_EQ_INT((int)cache.PixelIDs().size(), 2);
+		EXPECT_TRUE(cache.PixelIDs()[0].fullKey == pixelA.fullKey);
+		EXPECT_TRUE(cache.Save(filename, { pixelB }, {}));
+	}
+
+	JitDiskCache cache;
+	EXPECT_TRUE(cache.Load(filename));
+	std::vector<PixelFuncID> pixelIDs = cache.PixelIDs();
+	std::vector<SamplerID> samplerIDs = cache.SamplerIDs();
+	EXPECT_EQ_INT((int)pixelIDs.size(), 2);
+	EXPECT_TRUE(pixelIDs[0].fullKey == pixelB.fullKey);
+	EXPECT_TRUE(pixelIDs[1].fullKey == pixelA.fullKey);
+	EXPECT_EQ_INT((int)samplerIDs.size(), 1);
+	EXPECT_TRUE(samplerIDs[0].fullKey == sampler.fullKey);
+
+	std::string good;
+	EXPECT_TRUE(File::ReadBinaryFileToString(filename, &good));
+
+	// Anything damaged must load as nothing, even right after a good load.
+	std::vector<std::string> damaged;
+	for (size_t len = 0; len < good.size(); len++)
+		damaged.push_back(good.substr(0, len));
+	damaged.push_back(good + "x");
+	damaged.push_back(good);
+	damaged.back()[0] ^= 1;  // Magic
+	damaged.push_back(good);
+	damaged.back()[4] ^= 1;  // Version
+	damaged.push_back(good);
+	memset(&damaged.back()[8], 0xFF, 4);  // Number of pixel IDs
+
+	for (const std::string &data : damaged) {
+		EXPECT_TRUE(File::WriteDataToFile(false, good.data(), good.size(), filename));
+		EXPECT_TRUE(cache.Load(filename));
+		EXPECT_TRUE(File::WriteDataToFile(false, data.data(), data.size(), filename));
+		if (cache.Load(filename) || !cache.PixelIDs().empty() || !cache.SamplerIDs().empty()) {
+			printf("JitDiskCache: accepted a damaged file of %d bytes\n", (int)data.size());
+			File::Delete(filename);
+			return false;
+		}
+	}
+
+	File::Delete(filename);
+	return true;
+}
+
 bool TestSoftwareGPUJit() {
 	g_Config.bSoftwareRenderingJit = true;
 	ResetHitAnyAsserts();
@@ -183,5 +292,13 @@ bool TestSoftwareGPUJit() {
 		return false;
 	}
 
+	if (!TestPixelJitPrecompile()) {
+		return false;
+	}
+
+	if (!TestJitDiskCache()) {
+		return false;
+	}
+
 	return true;
 }
@@ -0,0 +1,214 @@
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Common/CPUDetect.h"
+#include "Common/CommonTypes.h"
+#include "Common/Thread/ThreadManager.h"
+#include "Core/Config.h"
+#include "GPU/Common/SplineCommon.h"
+#include "GPU/GPU.h"
+#include "GPU/GPUState.h"
+#include "UnitTest.h"
+
+using namespace Spline;
+
+// The TessellationCache setting must not change what gets drawn, and the cache must stay within its
+// size and drop entries that aren't drawn anymore.
+
+static u32 g_tessSeed;
+static float TessRandFloat() {
+	g_tessSeed = g_tessSeed * 1664525 + 1013904223;
+	return ((int)((g_tessSeed >> 8) & 0xFFFF) - 32768) * (1.0f / 256.0f);
+}
+
+struct TessBuffers {
+	std::vector<SimpleVertex> vertices;
+	std::vector<u16> indices;
+	OutputBuffers output;
+
+	explicit TessBuffers(int maxVerts) : vertices(maxVerts), indices(maxVerts * 6) {
+		// Garbage, so a lookup that doesn't write everything shows up.
+		memset((void *)vertices.data(), 0xCD, vertices.size() * sizeof(SimpleVertex));
+		memset(indices.data(), 0xCD, indices.size() * sizeof(u16));
+		output.vertices = vertices.data();
+		output.indices = indices.data();
+		output.count = 0;
+	}
+};
+
+struct TessPoints {
+	std::vector<SimpleVertex> vertices;
+	std::vector<const SimpleVertex *> pointers;
+	std::vector<Vec3f> pos;
+	std::vector<Vec2f> tex;
+	std::vector<Vec4f> col;
+	ControlPoints points;
+
+	// One spare vertex, since the position of the last one is loaded 16 bytes at a time.
+	explicit TessPoints(int count) : vertices(count + 1), pointers(count), pos(count), tex(count), col(count) {
+		for (int i = 0; i < count; i++) {
+			SimpleVertex &v = vertices[i];
+			v.uv[0] = TessRandFloat();
+			v.uv[1] = TessRandFloat();
+			v.color_32 = g_tessSeed * 2654435761U;
+			v.nrm = Vec3Packedf(0.0f, 0.0f, 1.0f);
+			v.pos = Vec3Packedf(TessRandFloat(), TessRandFloat(), TessRandFloat());
+			pointers[i] = &vertices[i];
+		}
+		points.pos = pos.data();
+		points.tex = tex.data();
+		points.col = col.data();
+		points.Convert(pointers.data(), count);
+	}
+};
+
+static TessCacheKey MakeKey(u64 dataHash) {
+	TessCacheKey key{};
+	key.dataHash = dataHash;
+	key.vertTypeID = GE_VTYPE_POS_FLOAT | GE_VTYPE_TC_FLOAT | GE_VTYPE_COL_8888;
+	key.materialAmbient = 0xFFFFFFFF;
+	return key;
+}
+
+template <class Surface>
+static bool TestCachedMatches(const char *name, Surface &surface, u32 vertType) {
+	const int maxVerts = 65536;
+	surface.Init(maxVerts);
+	const int numVerts = surface.GetNumVertices();
+	TessPoints points(surface.num_points_u * surface.num_points_v);
+
+	TessBuffers uncached(maxVerts);
+	SoftwareTessellation(uncached.output, surface, vertType, points.points);
+	EXPECT_TRUE(uncached.output.count > 0);
+
+	// Store, then draw something else in between, like a frame would.
+	TessellationCache cache;
+	const TessCacheKey key = MakeKey(1);
+	TessBuffers stored(maxVerts);
+	SoftwareTessellation(stored.output, surface, vertType, points.points);
+	cache.Store(key, stored.output, numVerts, vertType);
+	cache.Store(MakeKey(2), uncached.output, numVerts, vertType ^ GE_VTYPE_NRM_FLOAT);
+
+	TessBuffers cached(maxVerts);
+	u32 cachedVertType = 0;
+	EXPECT_TRUE(cache.Lookup(key, cached.output, numVerts, &cachedVertType));
+	EXPECT_EQ_HEX(cachedVertType, vertType);
+	EXPECT_EQ_INT(cached.output.count, uncached.output.count);
+	if (memcmp(cached.vertices.data(), uncached.vertices.data(), numVerts * sizeof(SimpleVertex)) != 0) {
+		printf("TessellationCache: %s vertices differ from the uncached tessellation\n", name);
+		return false;
+	}
+	if (memcmp(cached.indices.data(), uncached.indices.data(), uncached.output.count * sizeof(u16)) != 0) {
+		printf("TessellationCache: %s indices differ from the uncached tessellation\n", name);
+		return false;
+	}
+
+	// Anything else in the key, or a different vertex count after Init, has to miss.
+	TessCacheKey otherKey = key;
+	otherKey.tess++;
+	EXPECT_FALSE(cache.Lookup(otherKey, cached.output, numVerts, &cachedVertType));
+	EXPECT_FALSE(cache.Lookup(key, cached.output, numVerts - 1, &cachedVertType));
+	return true;
+}
+
+static bool TestCachedVsUncached() {
+	const u32 vertType = GE_VTYPE_POS_FLOAT | GE_VTYPE_TC_FLOAT | GE_VTYPE_COL_8888;
+
+	BezierSurface bezier{};
+	bezier.tess_u = 6;
+	bezier.tess_v = 5;
+	bezier.num_points_u = 7;
+	bezier.num_points_v = 4;
+	bezier.num_patches_u = (bezier.num_points_u - 1) / 3;
+	bezier.num_patches_v = (bezier.num_points_v - 1) / 3;
+	bezier.primType = GE_PATCHPRIM_TRIANGLES;
+	RET(TestCachedMatches("small bezier", bezier, vertType));
+
+	// Big enough to be tessellated in parallel.
+	BezierSurface bigBezier{};
+	bigBezier.tess_u = 20;
+	bigBezier.tess_v = 20;
+	bigBezier.num_points_u = 13;
+	bigBezier.num_points_v = 13;
+	bigBezier.num_patches_u = (bigBezier.num_points_u - 1) / 3;
+	bigBezier.num_patches_v = (bigBezier.num_points_v - 1) / 3;
+	bigBezier.primType = GE_PATCHPRIM_TRIANGLES;
+	bigBezier.patchFacing = true;
+	RET(TestCachedMatches("big bezier", bigBezier, vertType | GE_VTYPE_NRM_FLOAT));
+
+	SplineSurface spline{};
+	spline.tess_u = 64;
+	spline.tess_v = 48;
+	spline.type_u = 1;
+	spline.type_v = 2;
+	spline.num_points_u = 6;
+	spline.num_points_v = 5;
+	spline.num_patches_u = spline.num_points_u - 3;
+	spline.num_patches_v = spline.num_points_v - 3;
+	spline.primType = GE_PATCHPRIM_LINES;
+	RET(TestCachedMatches("spline", spline, vertType));
+	return true;
+}
+
+static bool TestSizeAndEviction() {
+	const int numVerts = 100;
+	const int count = 540;
+	const size_t entryBytes = numVerts * sizeof(SimpleVertex) + count * sizeof(u16);
+
+	TessBuffers buffers(numVerts);
+	buffers.output.count = count;
+	u32 vertType = 0;
+
+	// Room for two entries.
+	const int oldFlips = gpuStats.totals.numFlips;
+	gpuStats.totals.numFlips = 0;
+	TessellationCache cache(entryBytes * 2);
+	cache.Store(MakeKey(1), buffers.output, numVerts, 0);
+	cache.Store(MakeKey(2), buffers.output, numVerts, 0);
+	EXPECT_EQ_INT((int)cache.Count(), 2);
+	EXPECT_EQ_INT((int)cache.Bytes(), (int)(entryBytes * 2));
+
+	// A third doesn't fit, and isn't kept.
+	cache.Store(MakeKey(3), buffers.output, numVerts, 0);
+	EXPECT_EQ_INT((int)cache.Count(), 2);
+	EXPECT_FALSE(cache.Lookup(MakeKey(3), buffers.output, numVerts, &vertType));
+
+	// Storing over an existing entry replaces it instead of counting it twice.
+	cache.Store(MakeKey(2), buffers.output, numVerts, 0);
+	EXPECT_EQ_INT((int)cache.Bytes(), (int)(entryBytes * 2));
+	EXPECT_TRUE(cache.Lookup(MakeKey(2), buffers.output, numVerts, &vertType));
+
+	// Key 1 stays in use, key 2 isn't drawn again and ages out.
+	for (int i = 1; i <= TessellationCache::DECIMATE_AGE + 1; i++) {
+		gpuStats.totals.numFlips = i;
+		EXPECT_TRUE(cache.Lookup(MakeKey(1), buffers.output, numVerts, &vertType));
+	}
+	EXPECT_EQ_INT((int)cache.Count(), 1);
+	EXPECT_EQ_INT((int)cache.Bytes(), (int)entryBytes);
+	EXPECT_FALSE(cache.Lookup(MakeKey(2), buffers.output, numVerts, &vertType));
+
+	// Which leaves room for the third again.
+	cache.Store(MakeKey(3), buffers.output, numVerts, 0);
+	EXPECT_TRUE(cache.Lookup(MakeKey(3), buffers.output, numVerts, &vertType));
+
+	cache.Clear();
+	EXPECT_EQ_INT((int)cache.Count(), 0);
+	EXPECT_EQ_INT((int)cache.Bytes(), 0);
+	gpuStats.totals.numFlips = oldFlips;
+	return true;
+}
+
+bool TestTessellationCache() {
+	g_threadManager.Init(cpu_info.num_cores, cpu_info.logical_cpu_count);
+	const int oldQuality = g_Config.iSplineBezierQuality;
+	g_Config.iSplineBezierQuality = (int)SplineQuality::HIGH_QUALITY;
+	gstate.lightingEnable = 0;
+	g_tessSeed = 1;
+
+	bool success = TestCachedVsUncached() && TestSizeAndEviction();
+
+	g_Config.iSplineBezierQuality = oldQuality;
+	g_threadManager.Teardown();
+	return success;
+}
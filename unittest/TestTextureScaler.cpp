@@ -0,0 +1,210 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "Common/CPUDetect.h"
+#include "Common/CommonTypes.h"
+#include "Common/File/FileUtil.h"
+#include "Common/Thread/ThreadManager.h"
+#include "Common/TimeUtil.h"
+#include "Core/Config.h"
+#include "GPU/Common/TextureScalerCommon.h"
+#include "GPU/Common/TextureScalerDiskCache.h"
+#include "UnitTest.h"
+
+static const char *ScalerName(int type) {
+	switch (type) {
+	case TextureScalerCommon::XBRZ: return "xBRZ";
+	case TextureScalerCommon::HYBRID: return "hybrid";
+	case TextureScalerCommon::BICUBIC: return "bicubic";
+	case TextureScalerCommon::HYBRID_BICUBIC: return "hybrid bicubic";
+	default: return "?";
+	}
+}
+
+// Flat blocks with some lines and noise in between, a bit like a typical game texture.
+static void GenerateTexture(std::vector<u32> &tex, int w, int h, int blockSize) {
+	tex.resize(w * h);
+	for (int y = 0; y < h; y++) {
+		for (int x = 0; x < w; x++) {
+			u32 block = (x / blockSize) * 7 + (y / blockSize) * 13;
+			u32 color = 0xFF000000 | ((block * 0x35) & 0xFF) | (((block * 0x71) & 0xFF) << 8) | (((block * 0x1F) & 0xFF) << 16);
+			if (blockSize >= 8 && (x % blockSize == 0 || y % blockSize == 0))
+				color = (rand() & 1) ? 0xFF202020 : 0xFFE0E0E0;
+			tex[y * w + x] = color;
+		}
+	}
+}
+
+static bool CloseColor(u32 a, u32 b) {
+	for (int shift = 0; shift < 32; shift += 8) {
+		if (abs((int)((a >> shift) & 0xFF) - (int)((b >> shift) & 0xFF)) > 1)
+			return false;
+	}
+	return true;
+}
+
+static bool TestTextureScalerFlat() {
+	TextureScalerCommon scaler;
+	std::vector<u32> src(32 * 32, 0x80402010);
+	std::vector<u32> out(32 * 32 * 9);
+	int w = 0, h = 0;
+	scaler.ScaleAlways(out.data(), src.data(), 32, 32, &w, &h, 3);
+	EXPECT_EQ_INT(w, 96);
+	EXPECT_EQ_INT(h, 96);
+	for (u32 pixel : out)
+		EXPECT_EQ_HEX(pixel, 0x80402010);
+	return true;
+}
+
+// Whatever the scaler, the middle of a big flat area should keep its color.
+static bool TestTextureScalerBlocks(int type, int factor) {
+	g_Config.iTexScalingType = type;
+	TextureScalerCommon scaler;
+	const int size = 64, blockSize = 16;
+	std::vector<u32> src;
+	GenerateTexture(src, size, size, blockSize);
+	std::vector<u32> out(size * size * factor * factor);
+	int w = 0, h = 0;
+	scaler.ScaleAlways(out.data(), src.data(), size, size, &w, &h, factor);
+	EXPECT_EQ_INT(w, size * factor);
+	EXPECT_EQ_INT(h, size * factor);
+
+	for (int y = blockSize / 2; y < size; y += blockSize) {
+		for (int x = blockSize / 2; x < size; x += blockSize) {
+			u32 expected = src[y * size + x];
+			u32 actual = out[(y * factor) * w + x * factor];
+			if (!CloseColor(expected, actual)) {
+				printf("%s x%d: %08x at %d,%d, expected %08x\n", ScalerName(type), factor, actual, x, y, expected);
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static bool TestTextureScalerDiskCacheKey() {
+	std::vector<u32> src;
+	GenerateTexture(src, 64, 64, 4);
+	const u64 key = TextureScalerDiskCache::ComputeKey(src.data(), 64, 64, 2);
+	EXPECT_TRUE(key == TextureScalerDiskCache::ComputeKey(src.data(), 64, 64, 2));
+	EXPECT_FALSE(key == TextureScalerDiskCache::ComputeKey(src.data(), 64, 64, 3));
+	EXPECT_FALSE(key == TextureScalerDiskCache::ComputeKey(src.data(), 32, 128, 2));
+
+	g_Config.iTexScalingType = TextureScalerCommon::BICUBIC;
+	EXPECT_FALSE(key == TextureScalerDiskCache::ComputeKey(src.data(), 64, 64, 2));
+	g_Config.iTexScalingType = TextureScalerCommon::XBRZ;
+
+	src[33] ^= 0x00010000;
+	EXPECT_FALSE(key == TextureScalerDiskCache::ComputeKey(src.data(), 64, 64, 2));
+	return true;
+}
+
+// Save writes in the background, so wait for the file to show up.
+static bool WaitForScaledTexture(TextureScalerDiskCache &cache, u64 key, u32 *out, int w, int h, int factor) {
+	for (int i = 0; i < 5000; i++) {
+		if (cache.Load(key, out, w, h, factor))
+			return true;
+		sleep_ms(1, "scaled-texture-write");
+	}
+	return false;
+}
+
+static bool TestTextureScalerDiskCacheRoundTrip() {
+	const Path dir("unittest_scaledtex");
+	File::DeleteDirRecursively(dir);
+
+	const int w = 32, h = 16, factor = 2;
+	std::vector<u32> src, scaled;
+	GenerateTexture(src, w, h, 4);
+	GenerateTexture(scaled, w * factor, h * factor, 8);
+	const u64 key = TextureScalerDiskCache::ComputeKey(src.data(), w, h, factor);
+	std::vector<u32> out(scaled.size());
+
+	{
+		TextureScalerDiskCache cache;
+		cache.StartInDir(dir);
+		EXPECT_TRUE(cache.Enabled());
+		EXPECT_FALSE(cache.Load(key, out.data(), w, h, factor));
+		cache.Save(key, scaled.data(), w * factor, h * factor);
+		EXPECT_TRUE(cache.Contains(key));
+		EXPECT_TRUE(WaitForScaledTexture(cache, key, out.data(), w, h, factor));
+		EXPECT_TRUE(out == scaled);
+	}
+
+	// A new session finds it on disk.
+	TextureScalerDiskCache cache;
+	cache.StartInDir(dir);
+	EXPECT_TRUE(cache.Contains(key));
+	std::fill(out.begin(), out.end(), 0);
+	EXPECT_TRUE(cache.Load(key, out.data(), w, h, factor));
+	EXPECT_TRUE(out == scaled);
+
+	// The same data under another key's name must be rejected by the header, and dropped.
+	const u64 otherKey = key ^ 1;
+	EXPECT_TRUE(File::Copy(cache.FilenameForKey(key), cache.FilenameForKey(otherKey)));
+	cache.StartInDir(dir);
+	EXPECT_TRUE(cache.Contains(otherKey));
+	bool bad = false;
+	EXPECT_FALSE(TextureScalerDiskCache::LoadFile(cache.FilenameForKey(otherKey), otherKey, out.data(), w, h, factor, &bad));
+	EXPECT_TRUE(bad);
+	EXPECT_FALSE(File::Exists(cache.FilenameForKey(otherKey)));
+
+	// So must a size that doesn't match what's stored.
+	EXPECT_FALSE(cache.Load(key, out.data(), w * 2, h, factor));
+	EXPECT_FALSE(cache.Contains(key));
+	EXPECT_FALSE(File::Exists(cache.FilenameForKey(key)));
+
+	// A missing file is not bad, it may still be getting written.
+	EXPECT_FALSE(TextureScalerDiskCache::LoadFile(cache.FilenameForKey(key), key, out.data(), w, h, factor, &bad));
+	EXPECT_FALSE(bad);
+
+	cache.Stop();
+	File::DeleteDirRecursively(dir);
+	return true;
+}
+
+// Scales a typical big texture for a short while with each scaler, and prints the time per call.
+static void BenchmarkTextureScaler() {
+	static const int types[] = { TextureScalerCommon::XBRZ, TextureScalerCommon::HYBRID, TextureScalerCommon::BICUBIC, TextureScalerCommon::HYBRID_BICUBIC };
+	static const int factors[] = { 2, 4 };
+	const int size = 256;
+	std::vector<u32> src;
+	GenerateTexture(src, size, size, 8);
+	std::vector<u32> out(size * size * 16);
+	TextureScalerCommon scaler;
+
+	for (int type : types) {
+		g_Config.iTexScalingType = type;
+		for (int factor : factors) {
+			int w, h;
+			double ms = timeIt([&] {
+				scaler.ScaleAlways(out.data(), src.data(), size, size, &w, &h, factor);
+			}) * 1000.0;
+			printf("Scale %dx%d %s x%d: %0.2f ms (%0.1f Mpixels/s)\n", size, size, ScalerName(type), factor, ms, (w * h) / (ms * 1000.0));
+		}
+	}
+}
+
+bool TestTextureScaler() {
+	const int oldType = g_Config.iTexScalingType;
+	const bool oldDeposterize = g_Config.bTexDeposterize;
+	g_Config.iTexScalingType = TextureScalerCommon::XBRZ;
+	g_Config.bTexDeposterize = false;
+	g_threadManager.Init(cpu_info.num_cores, cpu_info.logical_cpu_count);
+
+	bool success = TestTextureScalerFlat() && TestTextureScalerDiskCacheKey() && TestTextureScalerDiskCacheRoundTrip();
+	static const int types[] = { TextureScalerCommon::XBRZ, TextureScalerCommon::HYBRID, TextureScalerCommon::BICUBIC, TextureScalerCommon::HYBRID_BICUBIC };
+	for (int type : types) {
+		for (int factor = 2; factor <= 5 && success; factor++)
+			success = TestTextureScalerBlocks(type, factor);
+	}
+
+	if (success && g_testBenchmarks)
+		BenchmarkTextureScaler();
+
+	g_threadManager.Teardown();
+	g_Config.iTexScalingType = oldType;
+	g_Config.bTexDeposterize = oldDeposterize;
+	return success;
+}
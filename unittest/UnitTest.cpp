@@ -117,6 +117,7 @@
 
 // Set to true for more verbose unit tests.
 bool g_testLog = false;
+bool g_testBenchmarks = false;
 
 std::string System_GetProperty(SystemProperty prop) { return ""; }
 std::vector<std::string> System_GetPropertyStringVec(SystemProperty prop) { return std::vector<std::string>(); }
@@ -2855,6 +2856,12 @@ bool TestVFS();
 bool TestZipSlip();
 bool TestLzrc();
 bool TestTextureReplacer();
+bool TestIndexGenerator();
+bool TestTextureScaler();
+bool TestSasAudio();
+bool TestAtrac3PlusDSP();
+bool TestAtracDecodeAhead();
+bool TestTessellationCache();
 
 TestItem availableTests[] = {
 #if PPSSPP_ARCH(ARM64) || PPSSPP_ARCH(AMD64) || PPSSPP_ARCH(X86)
@@ -2922,6 +2929,12 @@ TestItem availableTests[] = {
 	TEST_ITEM(ZipSlip),
 	TEST_ITEM(Lzrc),
 	TEST_ITEM(TextureReplacer),
+	TEST_ITEM(IndexGenerator),
+	TEST_ITEM(TextureScaler),
+	TEST_ITEM(SasAudio),
+	TEST_ITEM(Atrac3PlusDSP),
+	TEST_ITEM(AtracDecodeAhead),
+	TEST_ITEM(TessellationCache),
 };
 
 int main(int argc, const char *argv[]) {
@@ -2941,21 +2954,30 @@ int main(int argc, const char *argv[]) {
 	g_Config.bEnableLogging = true;
 	g_logManager.DisableOutput(LogOutput::DebugString);  // not really needed
 
+	// "--bench" can go anywhere, and also prints the timings of tests that have them.
+	std::vector<const char *> args;
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "--bench"))
+			g_testBenchmarks = true;
+		else
+			args.push_back(argv[i]);
+	}
+
 	// Collect the set of tests to run: "all", or one or more test names by
 	// (case-insensitive) name. Every non-"all" argument must match a known test name, or we
 	// bail out with the usage text - a silent partial run (e.g. from a typo) would be worse
 	// than an error.
 	std::vector<TestItem> testsToRun;
 	bool badArg = false;
-	if (argc == 2 && !strcasecmp(argv[1], "all")) {
+	if (args.size() == 1 && !strcasecmp(args[0], "all")) {
 		for (const auto &f : availableTests) {
 			testsToRun.push_back(f);
 		}
 	} else {
-		for (int i = 1; i < argc; ++i) {
+		for (const char *arg : args) {
 			const TestItem *found = nullptr;
 			for (const auto &f : availableTests) {
-				if (!strcasecmp(argv[i], f.name)) {
+				if (!strcasecmp(arg, f.name)) {
 					found = &f;
 					break;
 				}
@@ -2963,7 +2985,7 @@ int main(int argc, const char *argv[]) {
 			if (found) {
 				testsToRun.push_back(*found);
 			} else {
-				fprintf(stderr, "Unknown test: %s\n", argv[i]);
+				fprintf(stderr, "Unknown test: %s\n", arg);
 				badArg = true;
 			}
 		}
@@ -2971,6 +2993,7 @@ int main(int argc, const char *argv[]) {
 
 	if (testsToRun.empty() || badArg) {
 		fprintf(stderr, "You may select tests to run by passing one or more arguments, either \"all\" or one or more of the below.\n");
+		fprintf(stderr, "Add --bench to also run the benchmarks.\n");
 		fprintf(stderr, "\n");
 		fprintf(stderr, "Available tests:\n");
 		for (auto f : availableTests) {
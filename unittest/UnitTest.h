@@ -3,6 +3,8 @@
 #include <cmath>
 #include <algorithm>
 
+#include "Common/TimeUtil.h"
+
 inline bool rel_equal(float a, float b, float precision) {
 	float diff = fabsf(a - b);
 	if (diff == 0.0f) {
@@ -28,3 +30,18 @@ inline bool rel_equal(float a, float b, float precision) {
 #define RET(a) if (!(a)) { return false; }
 
 extern bool g_testLog;
+// Set by --bench. Timings are noisy and slow, so tests only print them when asked.
+extern bool g_testBenchmarks;
+
+// Calls func in batches until at least minSeconds have passed, and returns the seconds per call.
+template <typename F>
+double timeIt(F func, int batch = 1, double minSeconds = 0.25) {
+	int calls = 0;
+	double st = time_now_d();
+	do {
+		for (int j = 0; j < batch; ++j)
+			func();
+		calls += batch;
+	} while (time_now_d() - st < minSeconds);
+	return (time_now_d() - st) / calls;
+}